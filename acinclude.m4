@@ -163,6 +163,24 @@ AC_DEFUN([ACX_CHECK_POLL], [
 	fi
 ])dnl ACX_CHECK_POLL
 
+AC_DEFUN([ACX_CHECK_EPOLL], [
+    AC_MSG_CHECKING([for epoll])
+    AC_TRY_LINK([#include <sys/epoll.h>],
+				[struct epoll_event ev; int fd = epoll_create(1);
+				ev.events = EPOLLIN; ev.data.ptr = 0;
+				epoll_ctl(fd, EPOLL_CTL_ADD, 0, &ev);
+				epoll_wait(fd, &ev, 1, 10);],
+				acx_epoll_ok=yes, acx_epoll_ok=no)
+	AC_MSG_RESULT($acx_epoll_ok)
+	if test x"$acx_epoll_ok" = xyes; then
+		ifelse([$1],,AC_DEFINE(HAVE_EPOLL,1,[Define if you have the \`epoll\' functions.]),[$1])
+		:
+	else
+		acx_epoll_ok=no
+		$2
+	fi
+])dnl ACX_CHECK_EPOLL
+
 dnl See if we need extra libraries for nanosleep
 AC_DEFUN([ACX_CHECK_NANOSLEEP], [
 	acx_nanosleep_ok=no
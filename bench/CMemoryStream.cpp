@@ -0,0 +1,112 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CMemoryStream.h"
+
+//
+// CMemoryStream
+//
+
+CMemoryStream::CMemoryStream()
+{
+	// do nothing
+}
+
+CMemoryStream::~CMemoryStream()
+{
+	// do nothing
+}
+
+void
+CMemoryStream::close()
+{
+	m_buffer.pop(m_buffer.getSize());
+}
+
+UInt32
+CMemoryStream::read(void* buffer, UInt32 n)
+{
+	if (n > m_buffer.getSize()) {
+		n = m_buffer.getSize();
+	}
+	if (buffer != NULL) {
+		m_buffer.read(buffer, n);
+	}
+	else {
+		m_buffer.pop(n);
+	}
+	return n;
+}
+
+UInt32
+CMemoryStream::readInto(CStreamBuffer& buffer)
+{
+	const UInt32 n = m_buffer.getSize();
+	buffer.splice(m_buffer, n);
+	return n;
+}
+
+const void*
+CMemoryStream::peek(UInt32 n)
+{
+	return m_buffer.peek(n);
+}
+
+void
+CMemoryStream::write(const void* buffer, UInt32 n)
+{
+	m_buffer.write(buffer, n);
+}
+
+void
+CMemoryStream::flush()
+{
+	// do nothing
+}
+
+void
+CMemoryStream::shutdownInput()
+{
+	// do nothing
+}
+
+void
+CMemoryStream::shutdownOutput()
+{
+	// do nothing
+}
+
+void*
+CMemoryStream::getEventTarget() const
+{
+	return const_cast<void*>(reinterpret_cast<const void*>(this));
+}
+
+bool
+CMemoryStream::isReady() const
+{
+	return (m_buffer.getSize() > 0);
+}
+
+UInt32
+CMemoryStream::getSize() const
+{
+	return m_buffer.getSize();
+}
+
+UInt32
+CMemoryStream::getOutputSize() const
+{
+	return 0;
+}
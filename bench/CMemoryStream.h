@@ -0,0 +1,50 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CMEMORYSTREAM_H
+#define CMEMORYSTREAM_H
+
+#include "IStream.h"
+#include "CStreamBuffer.h"
+
+//! In-memory stream
+/*!
+A stream whose writes are queued in memory to be read back, for
+benchmarking protocol encoding and decoding without a socket.  It
+never sends events.
+*/
+class CMemoryStream : public IStream {
+public:
+	CMemoryStream();
+	virtual ~CMemoryStream();
+
+	// IStream overrides
+	virtual void		close();
+	virtual UInt32		read(void* buffer, UInt32 n);
+	virtual UInt32		readInto(CStreamBuffer& buffer);
+	virtual const void*	peek(UInt32 n);
+	virtual void		write(const void* buffer, UInt32 n);
+	virtual void		flush();
+	virtual void		shutdownInput();
+	virtual void		shutdownOutput();
+	virtual void*		getEventTarget() const;
+	virtual bool		isReady() const;
+	virtual UInt32		getSize() const;
+	virtual UInt32		getOutputSize() const;
+
+private:
+	CStreamBuffer		m_buffer;
+};
+
+#endif
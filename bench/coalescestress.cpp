@@ -0,0 +1,260 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "IEventJob.h"
+#include "IPrimaryScreen.h"
+#include "CString.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include <stdio.h>
+
+//
+// checks event coalescing:  that runs of events merge only with events
+// of the same type and target, that a coalescer can end a run, that
+// order is kept around the events that end a run, and that a backlog
+// of relative motion is handled in one call per run without losing
+// motion.  exits with status 1 if any test fails.
+//
+
+enum {
+	kBacklog = 10000,
+	kRunSize = 1000
+};
+
+typedef IPrimaryScreen::CMotionInfo CMotionInfo;
+
+static CEvent::Type		s_absType    = CEvent::kUnknown;
+static CEvent::Type		s_relType    = CEvent::kUnknown;
+static CEvent::Type		s_buttonType = CEvent::kUnknown;
+static CEvent::Type		s_keyType    = CEvent::kUnknown;
+static char				s_target;
+static char				s_otherTarget;
+
+// the latest position wins except that one with a negative x, standing
+// in for a position on a jump zone, isn't merged away
+static
+bool
+coalesceAbsolute(CEvent& event, const CEvent& next, void*)
+{
+	CMotionInfo* info           = static_cast<CMotionInfo*>(event.getData());
+	const CMotionInfo* nextInfo =
+							static_cast<const CMotionInfo*>(next.getData());
+	if (info->m_x < 0) {
+		return false;
+	}
+	info->m_x = nextInfo->m_x;
+	info->m_y = nextInfo->m_y;
+	return true;
+}
+
+static
+bool
+coalesceRelative(CEvent& event, const CEvent& next, void*)
+{
+	CMotionInfo* info           = static_cast<CMotionInfo*>(event.getData());
+	const CMotionInfo* nextInfo =
+							static_cast<const CMotionInfo*>(next.getData());
+	info->m_x += nextInfo->m_x;
+	info->m_y += nextInfo->m_y;
+	return true;
+}
+
+static
+void
+addMotion(CEventQueue& queue, CEvent::Type type, void* target,
+				SInt32 x, SInt32 y)
+{
+	// use both ways of giving an event its data
+	if (((x + y) & 1) != 0) {
+		queue.addEvent(CEvent(type, target, CMotionInfo::alloc(x, y)));
+	}
+	else {
+		queue.addEvent(CEvent::withCopy(type, target, CMotionInfo::make(x, y)));
+	}
+}
+
+// returns the queued events as text, emptying the queue
+static
+CString
+drain(CEventQueue& queue)
+{
+	CString result;
+	CEvent event;
+	while (queue.getEvent(event, 0.0)) {
+		const CMotionInfo* info =
+							static_cast<const CMotionInfo*>(event.getData());
+		char buffer[64];
+		if (event.getType() == s_absType) {
+			sprintf(buffer, "A%s(%d,%d) ",
+							(event.getTarget() == &s_otherTarget) ? "'" : "",
+							info->m_x, info->m_y);
+		}
+		else if (event.getType() == s_relType) {
+			sprintf(buffer, "R(%d,%d) ", info->m_x, info->m_y);
+		}
+		else {
+			sprintf(buffer, "%s ", queue.getTypeName(event.getType()));
+		}
+		result += buffer;
+		CEvent::deleteData(event);
+	}
+	return result;
+}
+
+static
+bool
+testOrder(CEventQueue& queue)
+{
+	static const char* s_expected =
+		"A(3,3) button A(5,5) A'(7,7) key R(6,-6) A(-1,9) A(-2,9) "
+		"A(8,8) ";
+
+	UInt32 taken0, coalesced0;
+	queue.getCoalesceCounts(taken0, coalesced0);
+	addMotion(queue, s_absType, &s_target, 1, 1);
+	addMotion(queue, s_absType, &s_target, 2, 2);
+	addMotion(queue, s_absType, &s_target, 3, 3);
+	queue.addEvent(CEvent(s_buttonType, &s_target));
+	addMotion(queue, s_absType, &s_target, 4, 4);
+	addMotion(queue, s_absType, &s_target, 5, 5);
+	addMotion(queue, s_absType, &s_otherTarget, 6, 6);
+	addMotion(queue, s_absType, &s_otherTarget, 7, 7);
+	queue.addEvent(CEvent(s_keyType, &s_target));
+	addMotion(queue, s_relType, &s_target, 1, -1);
+	addMotion(queue, s_relType, &s_target, 2, -2);
+	addMotion(queue, s_relType, &s_target, 3, -3);
+	addMotion(queue, s_absType, &s_target, -1, 9);
+	addMotion(queue, s_absType, &s_target, -2, 9);
+	addMotion(queue, s_absType, &s_target, 7, 7);
+	addMotion(queue, s_absType, &s_target, 8, 8);
+	const CString order = drain(queue);
+
+	UInt32 taken, coalesced;
+	queue.getCoalesceCounts(taken, coalesced);
+	taken     -= taken0;
+	coalesced -= coalesced0;
+	printf("events in order:  %s\n", order.c_str());
+	printf("%d events taken, %d coalesced\n", taken, coalesced);
+	return (order == s_expected && taken == 16 && coalesced == 7);
+}
+
+static
+bool
+testPendingDropped(CEventQueue& queue)
+{
+	// the event that ended a run waits in the queue and goes with the
+	// buffer
+	addMotion(queue, s_absType, &s_target, 1, 1);
+	addMotion(queue, s_absType, &s_target, 2, 2);
+	queue.addEvent(CEvent(s_keyType, &s_target));
+	CEvent event;
+	queue.getEvent(event, 0.0);
+	CEvent::deleteData(event);
+	const bool pending = !queue.isEmpty();
+	queue.adoptBuffer(NULL);
+	const bool dropped = (queue.isEmpty() && !queue.getEvent(event, 0.0));
+	printf("event ending a run:  %s, %s with the buffer\n",
+							pending ? "kept" : "lost",
+							dropped ? "dropped" : "not dropped");
+	return (pending && dropped);
+}
+
+static
+bool
+testNoCoalescer(CEventQueue& queue)
+{
+	queue.setCoalescer(s_absType, NULL, NULL);
+	addMotion(queue, s_absType, &s_target, 1, 1);
+	addMotion(queue, s_absType, &s_target, 2, 2);
+	const CString order = drain(queue);
+	queue.setCoalescer(s_absType, &coalesceAbsolute, NULL);
+	printf("without a coalescer:  %s\n", order.c_str());
+	return (order == "A(1,1) A(2,2) ");
+}
+
+// counts the calls and adds up the motion it's run for
+class CMotionCounter : public IEventJob {
+public:
+	CMotionCounter() : m_calls(0), m_dx(0) { }
+
+	virtual void		run(const CEvent& event)
+	{
+		++m_calls;
+		m_dx += static_cast<const CMotionInfo*>(event.getData())->m_x;
+	}
+
+public:
+	UInt32				m_calls;
+	SInt32				m_dx;
+};
+
+static
+bool
+testBacklog(CEventQueue& queue, bool coalesce)
+{
+	// relative motion queued while the main thread was busy with a
+	// button event every kRunSize moves
+	CMotionCounter* counter = new CMotionCounter;
+	queue.adoptHandler(s_relType, &s_target, counter);
+	queue.setCoalescer(s_relType, coalesce ? &coalesceRelative : NULL, NULL);
+	for (UInt32 i = 0; i < kBacklog; ++i) {
+		addMotion(queue, s_relType, &s_target, 1, 0);
+		if ((i % kRunSize) == kRunSize - 1) {
+			queue.addEvent(CEvent(s_buttonType, &s_target));
+		}
+	}
+
+	CStopwatch timer;
+	CEvent event;
+	while (queue.getEvent(event, 0.0)) {
+		queue.dispatchEvent(event);
+		CEvent::deleteData(event);
+	}
+	const double t     = timer.getTime();
+	const UInt32 calls = counter->m_calls;
+	const SInt32 dx    = counter->m_dx;
+	queue.removeHandler(s_relType, &s_target);
+	queue.setCoalescer(s_relType, &coalesceRelative, NULL);
+
+	printf("%d queued moves %s:  %d handler calls, dx %d, %.2f ms\n",
+							kBacklog, coalesce ? "coalesced" : "plain",
+							calls, dx, 1.0e3 * t);
+	return (dx == kBacklog &&
+			calls == (coalesce ? kBacklog / kRunSize : kBacklog));
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	s_absType    = queue.registerType("absolute");
+	s_relType    = queue.registerType("relative");
+	s_buttonType = queue.registerType("button");
+	s_keyType    = queue.registerType("key");
+	queue.setCoalescer(s_absType, &coalesceAbsolute, NULL);
+	queue.setCoalescer(s_relType, &coalesceRelative, NULL);
+
+	bool pass = true;
+	pass = testOrder(queue) && pass;
+	pass = testPendingDropped(queue) && pass;
+	pass = testNoCoalescer(queue) && pass;
+	pass = testBacklog(queue, false) && pass;
+	pass = testBacklog(queue, true) && pass;
+	printf(pass ? "passed\n" : "FAILED\n");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CMemoryStream.h"
+#include "CProtocolUtil.h"
+#include "ProtocolTypes.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include <stdio.h>
+#include <string.h>
+
+//
+// times the three ways to send and parse a fixed-size protocol message:
+// writef() and readf() with a format string, writeMessage() and
+// readMessage() with a CMsg* class, and encode() and decode() with no
+// stream at all.  first checks that encode() writes exactly what
+// writef() does.
+//
+
+enum {
+	kBatch = 1024,
+	kCount = 2048 * kBatch
+};
+
+// the encode/decode loop goes through these so the compiler can't see
+// that decode() reads back what encode() just wrote and fold the two
+// away.  the messages are encoded into a buffer reached through a
+// volatile pointer and each decoded message is added to a volatile.
+static UInt8			s_wire[kBatch * CMsgDMouseMove::kSize];
+static UInt8* volatile	s_wirePtr = s_wire;
+static volatile SInt32	s_sink    = 0;
+
+// returns true if the message waiting in \p stream, written there by
+// writef(), is exactly what encoding \p msg produces
+template <class T>
+static
+bool
+matches(CMemoryStream& stream, const T& msg)
+{
+	UInt8 expected[T::kSize + 16];
+	UInt8 actual[T::kSize];
+	const UInt32 n = stream.read(expected, sizeof(expected));
+	return (n == T::kSize &&
+			CProtocolUtil::encode(actual, msg) == T::kSize &&
+			memcmp(expected, actual, T::kSize) == 0);
+}
+
+static
+bool
+checkCodec(CMemoryStream& stream)
+{
+	for (SInt32 i = 0; i < 70000; i += 7) {
+		CProtocolUtil::writef(&stream, kMsgCEnter,
+							i - 35000, -i, i * 65537u, i);
+		if (!matches(stream, CMsgCEnter(i - 35000, -i, i * 65537u, i))) {
+			fprintf(stderr, "CINN doesn't match writef() at %d\n", i);
+			return false;
+		}
+		CProtocolUtil::writef(&stream, kMsgDInfo,
+							i, -i, i + 1, i + 2, 0, i + 3, -i);
+		if (!matches(stream, CMsgDInfo(i, -i, i + 1, i + 2, 0, i + 3, -i))) {
+			fprintf(stderr, "DINF doesn't match writef() at %d\n", i);
+			return false;
+		}
+		CProtocolUtil::writef(&stream, kMsgCClipboard, i & 0xff, i * 3u);
+		if (!matches(stream, CMsgCClipboard(i & 0xff, i * 3u))) {
+			fprintf(stderr, "CCLP doesn't match writef() at %d\n", i);
+			return false;
+		}
+	}
+	return true;
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CMemoryStream stream;
+
+	if (!checkCodec(stream)) {
+		return 1;
+	}
+
+	// every move is (i, -i) so the sum stays zero if they round trip
+	UInt8 code[4];
+	SInt32 check = 0;
+
+	CStopwatch timer;
+	for (SInt32 i = 0; i < kCount; ++i) {
+		SInt32 x, y;
+		CProtocolUtil::writef(&stream, kMsgDMouseMove, i, -i);
+		stream.read(code, 4);
+		CProtocolUtil::readf(&stream, kMsgDMouseMove + 4, &x, &y);
+		check += x + y;
+	}
+	const double formatted = timer.getTime();
+
+	timer.reset();
+	for (SInt32 i = 0; i < kCount; ++i) {
+		CMsgDMouseMove msg;
+		CProtocolUtil::writeMessage(&stream, CMsgDMouseMove(i, -i));
+		stream.read(code, 4);
+		CProtocolUtil::readMessage(&stream, msg);
+		check += msg.m_x + msg.m_y;
+	}
+	const double typed = timer.getTime();
+
+	// encode a batch of messages then decode them, like a packet
+	// filter's worth of input
+	timer.reset();
+	for (SInt32 i = 0; i < kCount; i += kBatch) {
+		UInt8* dst = s_wirePtr;
+		for (SInt32 j = i; j < i + kBatch; ++j) {
+			dst += CProtocolUtil::encode(dst, CMsgDMouseMove(j, -j));
+		}
+		const UInt8* src = s_wirePtr;
+		for (SInt32 j = 0; j < kBatch; ++j) {
+			CMsgDMouseMove msg;
+			CProtocolUtil::decode(src + 4, CMsgDMouseMove::kSize - 4, msg);
+			s_sink += msg.m_x + msg.m_y;
+			src    += CMsgDMouseMove::kSize;
+		}
+	}
+	const double codec = timer.getTime();
+	check += s_sink;
+
+	printf("%d mouse moves, encoded and decoded:\n", kCount);
+	printf("  writef/readf              %6.1f ns/message\n",
+							1.0e9 * formatted / kCount);
+	printf("  writeMessage/readMessage  %6.1f ns/message\n",
+							1.0e9 * typed / kCount);
+	printf("  encode/decode             %6.1f ns/message\n",
+							1.0e9 * codec / kCount);
+	return (check == 0) ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "CEventDataPool.h"
+#include "IEventJob.h"
+#include "IKeyState.h"
+#include "IPrimaryScreen.h"
+#include "CThread.h"
+#include "CFunctionJob.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "CArchAtomic.h"
+#include <stdio.h>
+
+//
+// checks that input events don't touch the heap.  motion and key
+// events are posted in bursts, first from the dispatching thread and
+// then from another thread as a screen would, and dispatched and
+// deleted as the main loop does.  exits with status 1 if any event
+// data came from malloc() or an event was lost.
+//
+
+enum {
+	kBurst  = 64,
+	kBursts = 20000
+};
+
+static CEvent::Type		s_motionType = CEvent::kUnknown;
+static CEvent::Type		s_keyType    = CEvent::kUnknown;
+static volatile UInt32	s_dispatched = 0;
+static UInt32			s_sum        = 0;
+static char				s_target;
+
+// adds the positions and keys it's run for to s_sum
+class CSummer : public IEventJob {
+public:
+	virtual void		run(const CEvent& event)
+	{
+		if (event.getType() == s_motionType) {
+			const IPrimaryScreen::CMotionInfo* info =
+				static_cast<const IPrimaryScreen::CMotionInfo*>(
+							event.getData());
+			s_sum += info->m_x + info->m_y;
+		}
+		else {
+			const IKeyState::CKeyInfo* info =
+				static_cast<const IKeyState::CKeyInfo*>(event.getData());
+			s_sum += info->m_key;
+		}
+		CArchAtomic::add(s_dispatched, 1);
+	}
+};
+
+// posts a burst of motion and key events using both ways of giving
+// an event its data.  returns what the handler will add to its sum.
+static
+UInt32
+postBurst(IEventQueue* queue, void* target, UInt32 burst)
+{
+	UInt32 sum = 0;
+	for (UInt32 i = 0; i < kBurst; i += 4) {
+		const SInt32 x = static_cast<SInt32>(burst & 0xff);
+		const SInt32 y = static_cast<SInt32>(i);
+		queue->addEvent(CEvent(s_motionType, target,
+							IPrimaryScreen::CMotionInfo::alloc(x, y)));
+		queue->addEvent(CEvent::withCopy(s_motionType, target,
+							IPrimaryScreen::CMotionInfo::make(y, x)));
+		queue->addEvent(CEvent(s_keyType, target,
+							IKeyState::CKeyInfo::alloc('a', 0, 38, 1)));
+		queue->addEvent(CEvent(s_keyType, target,
+							IKeyState::CKeyInfo::alloc('a', 0, 38, 0)));
+		sum += 2 * (x + y) + 2 * 'a';
+	}
+	return sum;
+}
+
+// dispatches and deletes \p n events
+static
+void
+dispatch(CEventQueue& queue, UInt32 n)
+{
+	CEvent event;
+	for (UInt32 i = 0; i < n; ++i) {
+		if (!queue.getEvent(event, 1.0)) {
+			return;
+		}
+		queue.dispatchEvent(event);
+		CEvent::deleteData(event);
+	}
+}
+
+static
+void
+produce(void*)
+{
+	for (UInt32 i = 0; i < kBursts; ++i) {
+		// don't get more than a burst ahead of the dispatcher
+		while (CArchAtomic::load(s_dispatched) + kBurst < i * kBurst) {
+			ARCH->sleep(0.0);
+		}
+		postBurst(EVENTQUEUE, &s_target, i);
+	}
+}
+
+static
+bool
+testSameThread(CEventQueue& queue)
+{
+	const UInt32 heap0 = CEventDataPool::getHeapCount();
+	s_sum              = 0;
+	CArchAtomic::store(s_dispatched, 0);
+	UInt32 sum = 0;
+	CStopwatch timer;
+	for (UInt32 i = 0; i < kBursts; ++i) {
+		sum += postBurst(&queue, &s_target, i);
+		dispatch(queue, kBurst);
+	}
+	const double t     = timer.getTime();
+	const UInt32 n     = CArchAtomic::load(s_dispatched);
+	const UInt32 heap  = CEventDataPool::getHeapCount() - heap0;
+	printf("%d events posted and dispatched on one thread:  "
+							"%5.1f ns/event, %d from the heap\n",
+							n, 1.0e9 * t / n, heap);
+	return (n == kBurst * kBursts && s_sum == sum && heap == 0);
+}
+
+static
+bool
+testOtherThread(CEventQueue& queue)
+{
+	const UInt32 heap0 = CEventDataPool::getHeapCount();
+	CArchAtomic::store(s_dispatched, 0);
+	CThread thread(new CFunctionJob(&produce));
+	dispatch(queue, kBurst * kBursts);
+	thread.wait();
+	const UInt32 n    = CArchAtomic::load(s_dispatched);
+	const UInt32 heap = CEventDataPool::getHeapCount() - heap0;
+	printf("%d events posted on another thread:  %d from the heap\n",
+							n, heap);
+	return (n == kBurst * kBursts && heap == 0);
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	s_motionType = queue.registerType("motion");
+	s_keyType    = queue.registerType("key");
+	queue.adoptHandler(s_motionType, &s_target, new CSummer);
+	queue.adoptHandler(s_keyType, &s_target, new CSummer);
+
+	bool pass = true;
+	pass = testSameThread(queue) && pass;
+	pass = testOtherThread(queue) && pass;
+	queue.removeHandlers(&s_target);
+	printf(pass ? "passed\n" : "FAILED\n");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "IEventJob.h"
+#include "CThread.h"
+#include "CFunctionJob.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "CArchAtomic.h"
+#include "stdvector.h"
+#include <stdio.h>
+
+//
+// measures event queue throughput:  the cost of addEvent() and
+// getEvent() on their own, then events per second from 1 to 8 threads
+// posting to one thread that gets and dispatches them.
+//
+
+enum {
+	kCostBatch     = 2000,
+	kCostRounds    = 500,
+	kTotalEvents   = 2000000
+};
+
+static CEvent::Type		s_type        = CEvent::kUnknown;
+static volatile UInt32	s_start       = 0;
+static UInt32			s_perProducer = 0;
+
+// counts events and checks that each producer's arrive in order.  an
+// event's data is the producer's index in the top 8 bits and the
+// event's index in the rest.
+class CCounter : public IEventJob {
+public:
+	CCounter(UInt32 numProducers) :
+		m_next(numProducers, 0), m_count(0), m_outOfOrder(0) { }
+
+	virtual void		run(const CEvent& event)
+	{
+		const UInt32 data  = static_cast<UInt32>(
+							reinterpret_cast<size_t>(event.getData()));
+		const UInt32 index = data & 0x00ffffff;
+		UInt32& next       = m_next[data >> 24];
+		if (index != next) {
+			++m_outOfOrder;
+		}
+		next = index + 1;
+		++m_count;
+	}
+
+public:
+	std::vector<UInt32>	m_next;
+	UInt32				m_count;
+	UInt32				m_outOfOrder;
+};
+
+static
+void
+produce(void* vindex)
+{
+	const UInt32 index = static_cast<UInt32>(reinterpret_cast<size_t>(vindex));
+	while (CArchAtomic::load(s_start) == 0) {
+		// wait for the other producers
+	}
+	for (UInt32 i = 0; i < s_perProducer; ++i) {
+		const size_t data = (index << 24) | i;
+		EVENTQUEUE->addEvent(CEvent(s_type, NULL,
+							reinterpret_cast<void*>(data),
+							CEvent::kDontFreeData));
+	}
+}
+
+static
+void
+benchCosts(CEventQueue& queue)
+{
+	double add = 0.0, get = 0.0;
+	CEvent event;
+	for (UInt32 i = 0; i < kCostRounds; ++i) {
+		CStopwatch timer;
+		for (UInt32 j = 0; j < kCostBatch; ++j) {
+			queue.addEvent(CEvent(s_type, NULL, NULL, CEvent::kDontFreeData));
+		}
+		add += timer.getTime();
+		timer.reset();
+		while (queue.getEvent(event, 0.0)) {
+			// discard
+		}
+		get += timer.getTime();
+	}
+	const double n = static_cast<double>(kCostRounds) * kCostBatch;
+	printf("addEvent()  %6.1f ns\n", 1.0e9 * add / n);
+	printf("getEvent()  %6.1f ns\n", 1.0e9 * get / n);
+}
+
+// returns the number of events that arrived out of order
+static
+UInt32
+benchThroughput(CEventQueue& queue, UInt32 numProducers)
+{
+	s_perProducer = kTotalEvents / numProducers;
+	CArchAtomic::store(s_start, 0);
+	CCounter* counter = new CCounter(numProducers);
+	queue.adoptHandler(s_type, NULL, counter);
+
+	std::vector<CThread*> producers;
+	for (UInt32 i = 0; i < numProducers; ++i) {
+		producers.push_back(new CThread(new CFunctionJob(&produce,
+							reinterpret_cast<void*>(static_cast<size_t>(i)))));
+	}
+
+	const UInt32 total = s_perProducer * numProducers;
+	CStopwatch timer;
+	CArchAtomic::store(s_start, 1);
+	CEvent event;
+	while (counter->m_count < total) {
+		if (queue.getEvent(event, 1.0)) {
+			queue.dispatchEvent(event);
+		}
+	}
+	const double t = timer.getTime();
+
+	for (UInt32 i = 0; i < numProducers; ++i) {
+		producers[i]->wait();
+		delete producers[i];
+	}
+	const UInt32 outOfOrder = counter->m_outOfOrder;
+	queue.removeHandler(s_type, NULL);
+
+	printf("%d producer%s  %5.2f M events/s, %6.1f ns/event\n",
+							numProducers, (numProducers == 1) ? " " : "s",
+							total / t / 1.0e6, 1.0e9 * t / total);
+	return outOfOrder;
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	s_type = queue.registerType("bench");
+
+	benchCosts(queue);
+	UInt32 outOfOrder = 0;
+	for (UInt32 n = 1; n <= 8; n *= 2) {
+		outOfOrder += benchThroughput(queue, n);
+	}
+	if (outOfOrder != 0) {
+		fprintf(stderr, "%d events arrived out of order\n", outOfOrder);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "CSimpleEventQueueBuffer.h"
+#include "CLockFreeQueue.h"
+#include "IEventJob.h"
+#include "CThread.h"
+#include "CFunctionJob.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "CArchAtomic.h"
+#include "stdvector.h"
+#include <stdio.h>
+
+//
+// stress tests the lock-free parts of the event queue:  several threads
+// posting to one consumer, bursts past the ring and slot array, waking a
+// blocked consumer, the ring with several consumers and replacing the
+// buffer while events are being posted.  exits with status 1 if any
+// test fails.
+//
+
+enum {
+	kProducers     = 4,
+	kPerProducer   = 250000,
+	kBurst         = 20000,
+	kWakeups       = 500,
+	kRingCapacity  = 1024,
+	kRingPerThread = 100000,
+	kAdoptEvents   = 300000,
+	kSlots         = 4096
+};
+
+static CEvent::Type		s_type  = CEvent::kUnknown;
+static volatile UInt32	s_start = 0;
+
+// counts events and checks that each producer's arrive in order.  an
+// event's data is the producer's index in the top 8 bits and the
+// event's index in the rest.
+class CCounter : public IEventJob {
+public:
+	CCounter(UInt32 numProducers) :
+		m_next(numProducers, 0), m_count(0), m_outOfOrder(0) { }
+
+	virtual void		run(const CEvent& event)
+	{
+		const UInt32 data  = static_cast<UInt32>(
+							reinterpret_cast<size_t>(event.getData()));
+		const UInt32 index = data & 0x00ffffff;
+		UInt32& next       = m_next[data >> 24];
+		if (index != next) {
+			++m_outOfOrder;
+		}
+		next = index + 1;
+		++m_count;
+	}
+
+public:
+	std::vector<UInt32>	m_next;
+	UInt32				m_count;
+	UInt32				m_outOfOrder;
+};
+
+static
+void
+postEvent(UInt32 producer, UInt32 index)
+{
+	const size_t data = (producer << 24) | index;
+	EVENTQUEUE->addEvent(CEvent(s_type, NULL,
+							reinterpret_cast<void*>(data),
+							CEvent::kDontFreeData));
+}
+
+static
+void
+produce(void* vindex)
+{
+	const UInt32 index = static_cast<UInt32>(reinterpret_cast<size_t>(vindex));
+	while (CArchAtomic::load(s_start) == 0) {
+		// wait for the other producers
+	}
+	for (UInt32 i = 0; i < kPerProducer; ++i) {
+		postEvent(index, i);
+	}
+}
+
+static
+bool
+testProducers(CEventQueue& queue)
+{
+	CCounter* counter = new CCounter(kProducers);
+	queue.adoptHandler(s_type, NULL, counter);
+	CThread* producers[kProducers];
+	for (UInt32 i = 0; i < kProducers; ++i) {
+		producers[i] = new CThread(new CFunctionJob(&produce,
+							reinterpret_cast<void*>(static_cast<size_t>(i))));
+	}
+	CArchAtomic::store(s_start, 1);
+	CEvent event;
+	while (counter->m_count < kProducers * kPerProducer) {
+		if (queue.getEvent(event, 1.0)) {
+			queue.dispatchEvent(event);
+		}
+	}
+	for (UInt32 i = 0; i < kProducers; ++i) {
+		producers[i]->wait();
+		delete producers[i];
+	}
+	const bool pass = (counter->m_outOfOrder == 0 && !queue.getEvent(event, 0.0));
+	printf("%d producers, %d events:  %d out of order\n",
+							kProducers, counter->m_count, counter->m_outOfOrder);
+	queue.removeHandler(s_type, NULL);
+	return pass;
+}
+
+static
+bool
+testBurst(CEventQueue& queue)
+{
+	// nothing is taken until every event is posted
+	CCounter* counter = new CCounter(1);
+	queue.adoptHandler(s_type, NULL, counter);
+	for (UInt32 i = 0; i < kBurst; ++i) {
+		postEvent(0, i);
+	}
+	CEvent event;
+	while (queue.getEvent(event, 0.0)) {
+		queue.dispatchEvent(event);
+	}
+	const bool pass = (counter->m_count == kBurst &&
+						counter->m_outOfOrder == 0);
+	printf("burst of %d:  %d delivered, %d out of order\n",
+							kBurst, counter->m_count, counter->m_outOfOrder);
+	queue.removeHandler(s_type, NULL);
+	return pass;
+}
+
+static volatile UInt32	s_ping = 0;
+
+static
+void
+ping(void*)
+{
+	for (UInt32 i = 0; i < kWakeups; ++i) {
+		while (CArchAtomic::load(s_ping) != 2 * i) {
+			// wait for the consumer to block again
+		}
+		ARCH->sleep(0.0001);
+		EVENTQUEUE->addEvent(CEvent(s_type, NULL, NULL, CEvent::kDontFreeData));
+		CArchAtomic::store(s_ping, 2 * i + 1);
+	}
+}
+
+static
+bool
+testWakeups(CEventQueue& queue)
+{
+	// a lost wakeup leaves getEvent() blocked until its timeout
+	CThread pinger(new CFunctionJob(&ping));
+	UInt32 timeouts = 0;
+	CEvent event;
+	for (UInt32 i = 0; i < kWakeups; ++i) {
+		CArchAtomic::store(s_ping, 2 * i);
+		while (!queue.getEvent(event, 1.0)) {
+			++timeouts;
+		}
+		while (CArchAtomic::load(s_ping) != 2 * i + 1) {
+			// wait for the pinger to finish posting
+		}
+	}
+	pinger.wait();
+	printf("%d wakeups of a blocked getEvent():  %d timed out\n",
+							kWakeups, timeouts);
+	return (timeouts == 0);
+}
+
+static CLockFreeQueue*	s_ring          = NULL;
+static volatile UInt32	s_ringReceived  = 0;
+static volatile UInt32	s_ringReordered = 0;
+
+static
+void
+pushRing(void* vindex)
+{
+	const UInt32 index = static_cast<UInt32>(reinterpret_cast<size_t>(vindex));
+	for (UInt32 i = 0; i < kRingPerThread; ++i) {
+		while (!s_ring->push((index << 24) | i)) {
+			// full
+		}
+	}
+}
+
+static
+void
+popRing(void*)
+{
+	// values from one producer popped by one consumer stay in order
+	SInt32 last[kProducers];
+	for (UInt32 i = 0; i < kProducers; ++i) {
+		last[i] = -1;
+	}
+	UInt32 reordered = 0;
+	for (UInt32 n = 0; n < kRingPerThread; ) {
+		UInt32 value;
+		if (s_ring->pop(value)) {
+			const SInt32 index = static_cast<SInt32>(value & 0x00ffffff);
+			if (index <= last[value >> 24]) {
+				++reordered;
+			}
+			last[value >> 24] = index;
+			++n;
+		}
+	}
+	CArchAtomic::add(s_ringReceived, kRingPerThread);
+	CArchAtomic::add(s_ringReordered, reordered);
+}
+
+static
+bool
+testRing()
+{
+	CLockFreeQueue ring(kRingCapacity);
+	s_ring = &ring;
+	CThread* threads[2 * kProducers];
+	for (UInt32 i = 0; i < kProducers; ++i) {
+		void* index = reinterpret_cast<void*>(static_cast<size_t>(i));
+		threads[2 * i]     = new CThread(new CFunctionJob(&pushRing, index));
+		threads[2 * i + 1] = new CThread(new CFunctionJob(&popRing, index));
+	}
+	for (UInt32 i = 0; i < 2 * kProducers; ++i) {
+		threads[i]->wait();
+		delete threads[i];
+	}
+	printf("ring, %d pushers and %d poppers:  %d values, %d reordered, %s\n",
+							kProducers, kProducers, s_ringReceived,
+							s_ringReordered,
+							ring.isEmpty() ? "empty" : "not empty");
+	return (s_ringReceived == kProducers * kRingPerThread &&
+			s_ringReordered == 0 && ring.isEmpty());
+}
+
+static volatile UInt32	s_postersDone = 0;
+
+static
+void
+postWithData(void*)
+{
+	for (UInt32 i = 0; i < kAdoptEvents; ++i) {
+		EVENTQUEUE->addEvent(CEvent(s_type, NULL, new int(i)));
+	}
+	CArchAtomic::add(s_postersDone, 1);
+}
+
+static
+bool
+testAdoptBuffer(CEventQueue& queue)
+{
+	// replacing the buffer discards queued events.  every slot they
+	// used must come back.
+	CThread a(new CFunctionJob(&postWithData));
+	CThread b(new CFunctionJob(&postWithData));
+	UInt32 adopts = 0;
+	CEvent event;
+	while (CArchAtomic::load(s_postersDone) < 2) {
+		for (UInt32 i = 0; i < 100 && queue.getEvent(event, 0.0); ++i) {
+			CEvent::deleteData(event);
+		}
+		queue.adoptBuffer(new CSimpleEventQueueBuffer);
+		++adopts;
+	}
+	a.wait();
+	b.wait();
+	while (queue.getEvent(event, 0.0)) {
+		CEvent::deleteData(event);
+	}
+
+	for (UInt32 i = 0; i < kSlots; ++i) {
+		queue.addEvent(CEvent(s_type, NULL, NULL, CEvent::kDontFreeData));
+	}
+	UInt32 n = 0;
+	while (queue.getEvent(event, 0.0)) {
+		++n;
+	}
+	printf("%d buffer replacements while posting:  %d of %d events "
+							"queued afterwards\n", adopts, n, kSlots);
+	return (n == kSlots);
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	s_type = queue.registerType("stress");
+
+	bool pass = true;
+	pass = testProducers(queue) && pass;
+	pass = testBurst(queue) && pass;
+	pass = testWakeups(queue) && pass;
+	pass = testRing() && pass;
+	pass = testAdoptBuffer(queue) && pass;
+	printf(pass ? "passed\n" : "FAILED\n");
+	return pass ? 0 : 1;
+}
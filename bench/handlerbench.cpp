@@ -0,0 +1,108 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "IEventJob.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "stdvector.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// measures the cost of dispatchEvent() looking up a handler with 10
+// and with 10000 handlers installed.  the handlers are split between
+// two event types and the events go to randomly chosen targets so the
+// lookups don't just hit the same entry.
+//
+
+enum {
+	kEvents = 4096,
+	kRounds = 1000
+};
+
+// counts the events it's run for
+class CCounter : public IEventJob {
+public:
+	CCounter() : m_count(0) { }
+
+	virtual void		run(const CEvent&) { ++m_count; }
+
+public:
+	UInt32				m_count;
+};
+
+// returns true iff every event was handled
+static
+bool
+benchDispatch(CEventQueue& queue, CEvent::Type types[2], UInt32 numHandlers)
+{
+	// one target per pair of handlers.  the queue owns the jobs but a
+	// job is also a handy unique target.
+	const UInt32 numTargets = numHandlers / 2;
+	std::vector<CCounter*> targets;
+	for (UInt32 i = 0; i < numTargets; ++i) {
+		CCounter* counter = new CCounter;
+		queue.adoptHandler(types[0], counter, counter);
+		queue.adoptHandler(types[1], counter, new CCounter);
+		targets.push_back(counter);
+	}
+
+	std::vector<CEvent> events;
+	for (UInt32 i = 0; i < kEvents; ++i) {
+		// only type 0 events reach the counters we keep
+		events.push_back(CEvent(types[0], targets[rand() % numTargets]));
+		events.push_back(CEvent(types[1], targets[rand() % numTargets]));
+	}
+
+	CStopwatch timer;
+	for (UInt32 i = 0; i < kRounds; ++i) {
+		for (std::vector<CEvent>::const_iterator j = events.begin();
+								j != events.end(); ++j) {
+			queue.dispatchEvent(*j);
+		}
+	}
+	const double t = timer.getTime();
+
+	UInt32 handled = 0;
+	for (UInt32 i = 0; i < numTargets; ++i) {
+		handled += targets[i]->m_count;
+		queue.removeHandlers(targets[i]);
+	}
+
+	const double n = static_cast<double>(kRounds) * events.size();
+	printf("%5d handlers  %6.1f ns/dispatch\n", numHandlers, 1.0e9 * t / n);
+	return (handled == kRounds * kEvents);
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	CEvent::Type types[2];
+	types[0] = queue.registerType("bench0");
+	types[1] = queue.registerType("bench1");
+
+	bool pass = true;
+	pass = benchDispatch(queue, types, 10) && pass;
+	pass = benchDispatch(queue, types, 10000) && pass;
+	if (!pass) {
+		fprintf(stderr, "some events were not handled\n");
+		return 1;
+	}
+	return 0;
+}
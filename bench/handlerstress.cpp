@@ -0,0 +1,172 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "IEventJob.h"
+#include "CThread.h"
+#include "CFunctionJob.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "CArchAtomic.h"
+#include <stdio.h>
+
+//
+// stress tests adding and removing event handlers while events are
+// dispatched:  a handler that removes itself and another target's
+// handler while it runs, and one thread adding and removing handlers
+// while another dispatches to them and to a handler that stays put.
+// exits with status 1 if any test fails.
+//
+
+enum {
+	kChurnTargets = 64,
+	kChurnTypes   = 4
+};
+
+static const double		kChurnTime = 1.0;
+
+static CEvent::Type		s_types[kChurnTypes];
+static char				s_targets[kChurnTargets];
+static volatile UInt32	s_stop = 0;
+
+// counts the events it's run for
+class CCounter : public IEventJob {
+public:
+	CCounter() : m_count(0) { }
+
+	virtual void		run(const CEvent&)
+	{
+		CArchAtomic::add(m_count, 1);
+	}
+
+public:
+	volatile UInt32		m_count;
+};
+
+// removes its own handler and all of another target's while it runs
+class CRemover : public IEventJob {
+public:
+	CRemover(UInt32* count, void* other) : m_count(count), m_other(other) { }
+
+	virtual void		run(const CEvent& event)
+	{
+		++*m_count;
+		EVENTQUEUE->removeHandler(event.getType(), event.getTarget());
+		EVENTQUEUE->removeHandlers(m_other);
+		// the queue must not have deleted us yet
+		++*m_count;
+	}
+
+private:
+	UInt32*				m_count;
+	void*				m_other;
+};
+
+static
+bool
+testSelfRemoval(CEventQueue& queue)
+{
+	int a, b;
+	UInt32 aCount = 0, bCount = 0;
+	queue.adoptHandler(s_types[0], &a, new CRemover(&aCount, &b));
+	queue.adoptHandler(s_types[0], &b, new CRemover(&bCount, &a));
+	queue.adoptHandler(s_types[1], &b, new CRemover(&bCount, &a));
+
+	const bool ran = queue.dispatchEvent(CEvent(s_types[0], &a));
+	const bool gone = (!queue.dispatchEvent(CEvent(s_types[0], &a)) &&
+						!queue.dispatchEvent(CEvent(s_types[0], &b)) &&
+						!queue.dispatchEvent(CEvent(s_types[1], &b)));
+	printf("handler removing itself and another target:  ran %s, "
+							"%s afterwards\n", (ran && aCount == 2) ?
+							"to completion" : "wrongly",
+							gone ? "both gone" : "still there");
+	return (ran && aCount == 2 && bCount == 0 && gone);
+}
+
+static
+void
+churn(void*)
+{
+	for (UInt32 i = 0; !CArchAtomic::load(s_stop); ++i) {
+		void* target = s_targets + (i % kChurnTargets);
+		EVENTQUEUE->adoptHandler(s_types[i % kChurnTypes],
+							target, new CCounter);
+		if ((i & 1) != 0) {
+			EVENTQUEUE->removeHandlers(s_targets + ((7 * i) % kChurnTargets));
+		}
+	}
+	for (UInt32 i = 0; i < kChurnTargets; ++i) {
+		EVENTQUEUE->removeHandlers(s_targets + i);
+	}
+}
+
+static
+bool
+testChurn(CEventQueue& queue)
+{
+	CCounter* fixed = new CCounter;
+	queue.adoptHandler(s_types[0], fixed, fixed);
+
+	// also dispatch to the churned targets.  whether their handlers
+	// run is up to the race but they mustn't be deleted while running.
+	CArchAtomic::store(s_stop, 0);
+	CThread thread(new CFunctionJob(&churn));
+	UInt32 n = 0, churned = 0;
+	CStopwatch timer;
+	for (UInt32 i = 0; timer.getTime() < kChurnTime; ++i) {
+		queue.dispatchEvent(CEvent(s_types[0], fixed));
+		++n;
+		if (queue.dispatchEvent(CEvent(s_types[i % kChurnTypes],
+							s_targets + (i % kChurnTargets)))) {
+			++churned;
+		}
+	}
+	CArchAtomic::store(s_stop, 1);
+	thread.wait();
+
+	// the churn thread removed all of its handlers before exiting
+	UInt32 left = 0;
+	for (UInt32 i = 0; i < kChurnTargets; ++i) {
+		for (UInt32 j = 0; j < kChurnTypes; ++j) {
+			if (queue.dispatchEvent(CEvent(s_types[j], s_targets + i))) {
+				++left;
+			}
+		}
+	}
+
+	const UInt32 handled = fixed->m_count;
+	queue.removeHandler(s_types[0], fixed);
+	printf("%d dispatches during handler churn:  %d handled, "
+							"%d churned handlers ran, %d left\n",
+							n, handled, churned, left);
+	return (handled == n && left == 0);
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	for (UInt32 i = 0; i < kChurnTypes; ++i) {
+		s_types[i] = queue.registerType("stress");
+	}
+
+	bool pass = true;
+	pass = testSelfRemoval(queue) && pass;
+	pass = testChurn(queue) && pass;
+	printf(pass ? "passed\n" : "FAILED\n");
+	return pass ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CProtocolUtil.h"
+#include "ProtocolTypes.h"
+#include "CPacketStreamFilter.h"
+#include "CTCPListenSocket.h"
+#include "CTCPSocket.h"
+#include "CNetworkAddress.h"
+#include "CSocketMultiplexer.h"
+#include "CEventQueue.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// measures protocol messages per second over loopback.  mouse move
+// messages are written with CProtocolUtil::writef() through a
+// CPacketStreamFilter and CTCPSocket and read back with readf() on
+// the accepted socket.  the reader keeps up to kMaxInFlight messages
+// behind the writer.
+//
+
+enum {
+	kBenchPort    = 24890,
+	kCount        = 500000,
+	kReadInterval = 64,
+	kMaxInFlight  = 4096
+};
+
+static
+void
+dispatchEvents(CEventQueue& queue)
+{
+	CEvent event;
+	while (queue.getEvent(event, 0.0)) {
+		queue.dispatchEvent(event);
+		CEvent::deleteData(event);
+	}
+}
+
+int
+main(int argc, char** argv)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	CSocketMultiplexer multiplexer;
+
+	const int port = (argc > 1) ? atoi(argv[1]) : kBenchPort;
+	CNetworkAddress addr("127.0.0.1", port);
+	addr.resolve();
+	CTCPListenSocket listen;
+	listen.bind(addr);
+
+	// connect
+	CTCPSocket* client = new CTCPSocket;
+	client->connect(addr);
+	IDataSocket* server = NULL;
+	CStopwatch timer;
+	while ((server = listen.accept()) == NULL) {
+		dispatchEvents(queue);
+		if (timer.getTime() > 5.0) {
+			fprintf(stderr, "can't connect on port %d\n", port);
+			return 1;
+		}
+		ARCH->sleep(0.001);
+	}
+	CPacketStreamFilter writer(client);
+	CPacketStreamFilter reader(server);
+
+	// send and read back
+	SInt32 received = 0;
+	timer.reset();
+	for (SInt32 i = 0; i < kCount; ++i) {
+		CProtocolUtil::writef(&writer, kMsgDMouseMove,
+							i & 0x7fff, (i >> 3) & 0x7fff);
+		if ((i % kReadInterval) != kReadInterval - 1 && i != kCount - 1) {
+			continue;
+		}
+		do {
+			dispatchEvents(queue);
+			while (reader.isReady()) {
+				UInt8 code[4];
+				SInt32 x, y;
+				reader.read(code, 4);
+				if (!CProtocolUtil::readf(&reader, kMsgDMouseMove + 4,
+								&x, &y) || x != (received & 0x7fff)) {
+					fprintf(stderr, "bad message %d\n", received);
+					return 1;
+				}
+				++received;
+			}
+		} while (received < i - kMaxInFlight ||
+				(i == kCount - 1 && received < kCount));
+	}
+	const double t = timer.getTime();
+
+	printf("%d messages in %.3f s, %.0f messages/s\n",
+							kCount, t, kCount / t);
+	return 0;
+}
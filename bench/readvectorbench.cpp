@@ -0,0 +1,129 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CMemoryStream.h"
+#include "CProtocolUtil.h"
+#include "CStopwatch.h"
+#include "CMutex.h"
+#include "CLock.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "stdvector.h"
+#include <stdio.h>
+
+//
+// times reading '%4I' vectors of 1k and 64k elements with readf()
+// against the element at a time decoding it replaced.  the stream
+// takes a lock on every read like CPacketStreamFilter does, so the old
+// per-element cost is what it was on a real connection.
+//
+
+// memory stream that locks on every read
+class CLockedMemoryStream : public CMemoryStream {
+public:
+	virtual UInt32		read(void* buffer, UInt32 n)
+	{
+		CLock lock(&m_mutex);
+		return CMemoryStream::read(buffer, n);
+	}
+
+	virtual const void*	peek(UInt32 n)
+	{
+		CLock lock(&m_mutex);
+		return CMemoryStream::peek(n);
+	}
+
+private:
+	CMutex				m_mutex;
+};
+
+// reads a '%4I' vector one element at a time the way readf() used to
+static
+void
+readVectorByElement(IStream* stream, std::vector<UInt32>* v)
+{
+	UInt8 buffer[4];
+	stream->read(buffer, 4);
+	const UInt32 n = (static_cast<UInt32>(buffer[0]) << 24) |
+					 (static_cast<UInt32>(buffer[1]) << 16) |
+					 (static_cast<UInt32>(buffer[2]) <<  8) |
+					  static_cast<UInt32>(buffer[3]);
+	for (UInt32 i = 0; i < n; ++i) {
+		stream->read(buffer, 4);
+		v->push_back((static_cast<UInt32>(buffer[0]) << 24) |
+					 (static_cast<UInt32>(buffer[1]) << 16) |
+					 (static_cast<UInt32>(buffer[2]) <<  8) |
+					  static_cast<UInt32>(buffer[3]));
+		LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", 4, i, v->back(), v->back()));
+	}
+}
+
+// returns the average microseconds to read a vector of \p size elements
+// with readf(), or with the old decoding if \p byElement is true.
+// returns a negative time if a vector doesn't read back correctly.
+static
+double
+bench(UInt32 size, UInt32 count, bool byElement)
+{
+	std::vector<UInt32> src(size);
+	for (UInt32 i = 0; i < size; ++i) {
+		src[i] = i * 2654435761u;
+	}
+
+	CLockedMemoryStream stream;
+	double total = 0.0;
+	for (UInt32 i = 0; i < count; ++i) {
+		std::vector<UInt32> dst;
+		CProtocolUtil::writef(&stream, "%4I", &src);
+		CStopwatch timer;
+		if (byElement) {
+			readVectorByElement(&stream, &dst);
+		}
+		else {
+			CProtocolUtil::readf(&stream, "%4I", &dst);
+		}
+		total += timer.getTime();
+		if (dst != src) {
+			return -1.0;
+		}
+	}
+	return 1.0e6 * total / count;
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+
+	static const UInt32 s_sizes[][2] = {
+		{ 1024,  2000 },
+		{ 65536, 40 }
+	};
+	int result = 0;
+	for (UInt32 i = 0; i < sizeof(s_sizes) / sizeof(s_sizes[0]); ++i) {
+		const UInt32 size  = s_sizes[i][0];
+		const UInt32 count = s_sizes[i][1];
+		const double old   = bench(size, count, true);
+		const double bulk  = bench(size, count, false);
+		if (old < 0.0 || bulk < 0.0) {
+			fprintf(stderr, "%%4I x %d didn't read back correctly\n", size);
+			result = 1;
+			continue;
+		}
+		printf("%%4I x %5d:  by element %8.1f us,  readf() %7.1f us\n",
+							size, old, bulk);
+	}
+	return result;
+}
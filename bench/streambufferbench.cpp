@@ -0,0 +1,121 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CStreamBuffer.h"
+#include "COldStreamBuffer.h"
+#include "CStopwatch.h"
+#include "CArch.h"
+#include <stdio.h>
+#include <string.h>
+
+//
+// compares CStreamBuffer with the list of vectors it replaced under the
+// two kinds of traffic a socket buffer sees:  a steady stream of small
+// input messages read a few at a time and clipboard transfers of
+// megabytes read in large pieces.
+//
+
+enum {
+	kInputSize       = 24,
+	kInputBatch      = 10,
+	kInputCount      = 5000000,
+	kClipboardSize   = 1 << 20,
+	kClipboardRead   = 64 * 1024,
+	kClipboardCount  = 200
+};
+
+static UInt8			s_data[kClipboardSize];
+static UInt8			s_sink[kClipboardRead];
+static UInt32			s_check = 0;
+
+static
+void
+consume(const void* data, UInt32 n)
+{
+	// copy out like a reader would and keep the compiler from
+	// dropping the copy
+	memcpy(s_sink, data, n);
+	s_check += s_sink[0] + s_sink[n - 1];
+}
+
+// returns nanoseconds per message for input-sized messages that are
+// written one at a time and read kInputBatch at a time.  like a socket
+// buffer, the buffer never quite empties:  part of a message is always
+// left over so messages straddle chunk boundaries.
+template <class T>
+static
+double
+benchInput()
+{
+	T buffer;
+	buffer.write(s_data, kInputSize / 2);
+	CStopwatch timer;
+	for (UInt32 i = 0; i < kInputCount; ++i) {
+		buffer.write(s_data + (i & 255), kInputSize);
+		if (buffer.getSize() >= kInputSize * kInputBatch) {
+			while (buffer.getSize() >= kInputSize) {
+				consume(buffer.peek(kInputSize), kInputSize);
+				buffer.pop(kInputSize);
+			}
+		}
+	}
+	return 1.0e9 * timer.getTime() / kInputCount;
+}
+
+// returns megabytes per second for clipboard-sized transfers written
+// all at once and read kClipboardRead bytes at a time
+template <class T>
+static
+double
+benchClipboard()
+{
+	T buffer;
+	CStopwatch timer;
+	for (UInt32 i = 0; i < kClipboardCount; ++i) {
+		buffer.write(s_data, kClipboardSize);
+		while (buffer.getSize() > 0) {
+			UInt32 n = buffer.getSize();
+			if (n > kClipboardRead) {
+				n = kClipboardRead;
+			}
+			consume(buffer.peek(n), n);
+			buffer.pop(n);
+		}
+	}
+	return (double)kClipboardSize * kClipboardCount /
+							(1024.0 * 1024.0 * timer.getTime());
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+
+	for (UInt32 i = 0; i < kClipboardSize; ++i) {
+		s_data[i] = static_cast<UInt8>(i * 7 + 1);
+	}
+
+	printf("input, %d byte messages:\n", kInputSize);
+	printf("  old buffer  %8.1f ns/message\n",
+							benchInput<COldStreamBuffer>());
+	printf("  new buffer  %8.1f ns/message\n",
+							benchInput<CStreamBuffer>());
+	printf("clipboard, %d KB written, read %d KB at a time:\n",
+							kClipboardSize / 1024, kClipboardRead / 1024);
+	printf("  old buffer  %8.1f MB/s\n",
+							benchClipboard<COldStreamBuffer>());
+	printf("  new buffer  %8.1f MB/s\n",
+							benchClipboard<CStreamBuffer>());
+	return (s_check == 0) ? 1 : 0;
+}
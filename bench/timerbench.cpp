@@ -0,0 +1,95 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "stdvector.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// measures the cost of polling the event queue and of rearming a
+// timer with 10 to 10000 long timers pending.  rearming is timed both
+// with resetTimer() and with deleting the timer and making a new one,
+// as a heartbeat would have to without resetTimer().
+//
+
+enum {
+	kPolls   = 2000000,
+	kRearms  = 200000
+};
+
+// a random duration long enough that no timer expires during the run
+static
+double
+getDuration()
+{
+	return 100.0 + (rand() % 1000);
+}
+
+static
+void
+benchTimers(CEventQueue& queue, UInt32 numTimers)
+{
+	std::vector<CEventQueueTimer*> timers;
+	for (UInt32 i = 0; i < numTimers; ++i) {
+		timers.push_back(queue.newOneShotTimer(getDuration(), NULL));
+	}
+
+	// fewer polls with many timers so each size takes about as long
+	const UInt32 polls = kPolls / numTimers + 1000;
+	CEvent event;
+	CStopwatch timer;
+	for (UInt32 i = 0; i < polls; ++i) {
+		queue.getEvent(event, 0.0);
+	}
+	const double poll = timer.getTime() / polls;
+
+	timer.reset();
+	for (UInt32 i = 0; i < kRearms; ++i) {
+		queue.resetTimer(timers[rand() % numTimers]);
+	}
+	const double reset = timer.getTime() / kRearms;
+
+	timer.reset();
+	for (UInt32 i = 0; i < kRearms; ++i) {
+		CEventQueueTimer*& t = timers[rand() % numTimers];
+		queue.deleteTimer(t);
+		t = queue.newOneShotTimer(getDuration(), NULL);
+	}
+	const double recreate = timer.getTime() / kRearms;
+
+	printf("%5d timers  poll %8.3f us, resetTimer() %7.3f us, "
+							"delete and new %7.3f us\n", numTimers,
+							1.0e6 * poll, 1.0e6 * reset, 1.0e6 * recreate);
+
+	for (UInt32 i = 0; i < numTimers; ++i) {
+		queue.deleteTimer(timers[i]);
+	}
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+
+	for (UInt32 n = 10; n <= 10000; n *= 10) {
+		benchTimers(queue, n);
+	}
+	return 0;
+}
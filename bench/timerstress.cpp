@@ -0,0 +1,209 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventQueue.h"
+#include "CStopwatch.h"
+#include "CLog.h"
+#include "CArch.h"
+#include "stdmap.h"
+#include "stdvector.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//
+// stress tests the event queue's timers:  300 one-shot and repeating
+// timers that are randomly reset and deleted while the queue is
+// polled, then the count of a repeating timer that missed periods and
+// the rearming of an expired one-shot timer.  exits with status 1 if
+// any test fails.
+//
+
+enum {
+	kTimers = 300
+};
+
+static const double		kRunTime  = 1.0;
+
+// what we expect of a timer
+class CTimerInfo {
+public:
+	double				m_duration;
+	double				m_deadline;
+	bool				m_oneShot;
+	bool				m_alive;
+	bool				m_fired;
+};
+typedef std::map<CEventQueueTimer*, CTimerInfo> CTimerMap;
+
+// returns the timer event in \p event, or NULL if it's not one
+static
+IEventQueue::CTimerEvent*
+getTimerEvent(const CEvent& event)
+{
+	if (event.getType() != CEvent::kTimer) {
+		return NULL;
+	}
+	return static_cast<IEventQueue::CTimerEvent*>(event.getData());
+}
+
+static
+bool
+testRandom(CEventQueue& queue)
+{
+	CStopwatch timer;
+	CTimerMap timers;
+	std::vector<CEventQueueTimer*> all;
+	for (UInt32 i = 0; i < kTimers; ++i) {
+		CTimerInfo info;
+		info.m_duration = 0.005 + 0.001 * (rand() % 200);
+		info.m_deadline = timer.getTime() + info.m_duration;
+		info.m_oneShot  = ((rand() & 1) != 0);
+		info.m_alive    = true;
+		info.m_fired    = false;
+		CEventQueueTimer* t = info.m_oneShot ?
+							queue.newOneShotTimer(info.m_duration, NULL) :
+							queue.newTimer(info.m_duration, NULL);
+		timers[t] = info;
+		all.push_back(t);
+	}
+
+	UInt32 events = 0, bad = 0, early = 0;
+	while (timer.getTime() < kRunTime) {
+		// now and then reset or delete a timer
+		const int r          = rand() % 100;
+		CEventQueueTimer* t  = all[rand() % all.size()];
+		CTimerInfo& info     = timers[t];
+		if (r < 5 && info.m_alive) {
+			queue.resetTimer(t);
+			info.m_deadline = timer.getTime() + info.m_duration;
+			info.m_fired    = false;
+		}
+		else if (r < 7 && info.m_alive) {
+			queue.deleteTimer(t);
+			info.m_alive = false;
+		}
+
+		CEvent event;
+		if (!queue.getEvent(event, 0.002)) {
+			continue;
+		}
+		IEventQueue::CTimerEvent* timerEvent = getTimerEvent(event);
+		if (timerEvent == NULL) {
+			continue;
+		}
+		++events;
+		CTimerInfo& fired = timers[timerEvent->m_timer];
+		const double now  = timer.getTime();
+		if (!fired.m_alive || (fired.m_oneShot && fired.m_fired) ||
+			timerEvent->m_count < 1) {
+			++bad;
+		}
+		if (now < fired.m_deadline - 0.0005) {
+			++early;
+		}
+		fired.m_fired    = true;
+		fired.m_deadline = now + fired.m_duration;
+	}
+
+	// every live timer well past its deadline has fired
+	UInt32 missed = 0;
+	const double now = timer.getTime();
+	for (CTimerMap::iterator i = timers.begin(); i != timers.end(); ++i) {
+		const CTimerInfo& info = i->second;
+		if (info.m_alive && !info.m_fired && info.m_deadline < now - 0.05) {
+			++missed;
+		}
+		if (info.m_alive) {
+			queue.deleteTimer(i->first);
+		}
+	}
+	printf("%d timers reset and deleted at random:  %d events, "
+							"%d wrong, %d early, %d missed\n",
+							kTimers, events, bad, early, missed);
+	return (bad == 0 && early == 0 && missed == 0);
+}
+
+static
+bool
+testMissedPeriods(CEventQueue& queue)
+{
+	// a repeating timer's count covers the periods nobody polled for
+	CEventQueueTimer* t = queue.newTimer(0.01, NULL);
+	ARCH->sleep(0.055);
+	UInt32 count = 0;
+	CEvent event;
+	while (queue.getEvent(event, 0.0)) {
+		IEventQueue::CTimerEvent* timerEvent = getTimerEvent(event);
+		if (timerEvent != NULL && timerEvent->m_timer == t) {
+			count = timerEvent->m_count;
+		}
+	}
+	queue.deleteTimer(t);
+	printf("10 ms timer polled after 55 ms:  count %d\n", count);
+	return (count >= 5);
+}
+
+static
+bool
+testRearmExpired(CEventQueue& queue)
+{
+	// an expired one-shot timer fires again once reset and not before
+	// its duration is up
+	CEventQueueTimer* t = queue.newOneShotTimer(0.01, NULL);
+	UInt32 n = 0;
+	bool early = false;
+	CStopwatch timer;
+	CEvent event;
+	while (timer.getTime() < 0.05) {
+		if (queue.getEvent(event, 0.005)) {
+			IEventQueue::CTimerEvent* timerEvent = getTimerEvent(event);
+			if (timerEvent != NULL && timerEvent->m_timer == t) {
+				++n;
+			}
+		}
+	}
+	queue.resetTimer(t);
+	const double reset = timer.getTime();
+	while (timer.getTime() < 0.1) {
+		if (queue.getEvent(event, 0.005)) {
+			IEventQueue::CTimerEvent* timerEvent = getTimerEvent(event);
+			if (timerEvent != NULL && timerEvent->m_timer == t) {
+				++n;
+				if (timer.getTime() - reset < 0.0095) {
+					early = true;
+				}
+			}
+		}
+	}
+	queue.deleteTimer(t);
+	printf("one-shot timer reset once after expiring:  fired %d times%s\n",
+							n, early ? ", early" : "");
+	return (n == 2 && !early);
+}
+
+int
+main(int, char**)
+{
+	CArch arch;
+	CLOG->setFilter(CLog::kWARNING);
+	CEventQueue queue;
+	srand(3);
+
+	bool pass = true;
+	pass = testRandom(queue) && pass;
+	pass = testMissedPeriods(queue) && pass;
+	pass = testRearmExpired(queue) && pass;
+	printf(pass ? "passed\n" : "FAILED\n");
+	return pass ? 0 : 1;
+}
@@ -476,6 +476,38 @@ CArch::unblockPollSocket(CArchThread thread)
 	m_net->unblockPollSocket(thread);
 }
 
+CArchPollSet
+CArch::newPollSet()
+{
+	return m_net->newPollSet();
+}
+
+void
+CArch::closePollSet(CArchPollSet set)
+{
+	m_net->closePollSet(set);
+}
+
+void
+CArch::setPollSetEvents(CArchPollSet set, CArchSocket s,
+				unsigned short events, void* userData)
+{
+	m_net->setPollSetEvents(set, s, events, userData);
+}
+
+void
+CArch::removePollSetSocket(CArchPollSet set, CArchSocket s)
+{
+	m_net->removePollSetSocket(set, s);
+}
+
+int
+CArch::waitPollSet(CArchPollSet set,
+				CPollSetEntry ready[], int num, double timeout)
+{
+	return m_net->waitPollSet(set, ready, num, timeout);
+}
+
 size_t
 CArch::readSocket(CArchSocket s, void* buf, size_t len)
 {
@@ -488,6 +520,26 @@ CArch::writeSocket(CArchSocket s, const void* buf, size_t len)
 	return m_net->writeSocket(s, buf, len);
 }
 
+size_t
+CArch::writevSocket(CArchSocket s, const CIOVec vec[], int num)
+{
+	return m_net->writevSocket(s, vec, num);
+}
+
+size_t
+CArch::readFromSocket(CArchSocket s, void* buf, size_t len,
+				CArchNetAddress* addr)
+{
+	return m_net->readFromSocket(s, buf, len, addr);
+}
+
+size_t
+CArch::writeToSocket(CArchSocket s, const void* buf, size_t len,
+				CArchNetAddress addr)
+{
+	return m_net->writeToSocket(s, buf, len, addr);
+}
+
 void
 CArch::throwErrorOnSocket(CArchSocket s)
 {
@@ -614,6 +666,12 @@ CArch::getOSName() const
 	return m_system->getOSName();
 }
 
+void
+CArch::getRandom(void* buffer, UInt32 size) const
+{
+	m_system->getRandom(buffer, size);
+}
+
 void
 CArch::addReceiver(IArchTaskBarReceiver* receiver)
 {
@@ -140,9 +140,22 @@ public:
 	virtual bool		connectSocket(CArchSocket s, CArchNetAddress name);
 	virtual int			pollSocket(CPollEntry[], int num, double timeout);
 	virtual void		unblockPollSocket(CArchThread thread);
+	virtual CArchPollSet	newPollSet();
+	virtual void		closePollSet(CArchPollSet set);
+	virtual void		setPollSetEvents(CArchPollSet set, CArchSocket s,
+							unsigned short events, void* userData);
+	virtual void		removePollSetSocket(CArchPollSet set, CArchSocket s);
+	virtual int			waitPollSet(CArchPollSet set,
+							CPollSetEntry ready[], int num, double timeout);
 	virtual size_t		readSocket(CArchSocket s, void* buf, size_t len);
 	virtual size_t		writeSocket(CArchSocket s,
 							const void* buf, size_t len);
+	virtual size_t		writevSocket(CArchSocket s,
+							const CIOVec vec[], int num);
+	virtual size_t		readFromSocket(CArchSocket s, void* buf, size_t len,
+							CArchNetAddress* addr);
+	virtual size_t		writeToSocket(CArchSocket s, const void* buf,
+							size_t len, CArchNetAddress addr);
 	virtual void		throwErrorOnSocket(CArchSocket);
 	virtual bool		setNoDelayOnSocket(CArchSocket, bool noDelay);
 	virtual bool		setReuseAddrOnSocket(CArchSocket, bool reuse);
@@ -174,6 +187,7 @@ public:
 
 	// IArchSystem overrides
 	virtual std::string	getOSName() const;
+	virtual void		getRandom(void* buffer, UInt32 size) const;
 
 	// IArchTaskBar
 	virtual void		addReceiver(IArchTaskBarReceiver*);
@@ -0,0 +1,201 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CARCHATOMIC_H
+#define CARCHATOMIC_H
+
+#include "BasicTypes.h"
+
+#if defined(_MSC_VER)
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#elif !defined(__GNUC__) || (__GNUC__ < 4) || \
+		(__GNUC__ == 4 && __GNUC_MINOR__ < 1)
+#	error "no atomic operations for this compiler"
+#endif
+
+//! Atomic operations
+/*!
+Lock-free operations on 32-bit values and pointers shared between
+threads.  These are inline rather than part of \c IArchMultithread
+because they're used where a virtual call or a mutex would cost more
+than the work being protected.
+*/
+class CArchAtomic {
+public:
+	//! Read a value
+	/*!
+	Returns \p v.  Reads and writes after this call in program order
+	aren't moved before it (acquire semantics).
+	*/
+	static UInt32		load(const volatile UInt32& v);
+
+	//! Write a value
+	/*!
+	Sets \p v to \p x.  Reads and writes before this call in program
+	order aren't moved after it (release semantics).
+	*/
+	static void			store(volatile UInt32& v, UInt32 x);
+
+	//! Add to a value
+	/*!
+	Adds \p delta to \p v and returns the new value.  This is a full
+	memory barrier.
+	*/
+	static UInt32		add(volatile UInt32& v, UInt32 delta);
+
+	//! Compare and swap
+	/*!
+	Sets \p v to \p x iff it's equal to \p expected and returns true
+	iff it did.  This is a full memory barrier.
+	*/
+	static bool			compareAndSwap(volatile UInt32& v,
+							UInt32 expected, UInt32 x);
+
+	//! Read a pointer
+	/*!
+	Same as \c load() but for a pointer.
+	*/
+	template <class T>
+	static T*			loadPointer(T* const volatile& p);
+
+	//! Write a pointer
+	/*!
+	Same as \c store() but for a pointer.
+	*/
+	template <class T>
+	static void			storePointer(T* volatile& p, T* x);
+};
+
+#if defined(_MSC_VER)
+
+inline
+UInt32
+CArchAtomic::load(const volatile UInt32& v)
+{
+	UInt32 x = v;
+	MemoryBarrier();
+	return x;
+}
+
+inline
+void
+CArchAtomic::store(volatile UInt32& v, UInt32 x)
+{
+	MemoryBarrier();
+	v = x;
+}
+
+inline
+UInt32
+CArchAtomic::add(volatile UInt32& v, UInt32 delta)
+{
+	return static_cast<UInt32>(InterlockedExchangeAdd(
+							reinterpret_cast<volatile LONG*>(&v),
+							static_cast<LONG>(delta))) + delta;
+}
+
+inline
+bool
+CArchAtomic::compareAndSwap(volatile UInt32& v, UInt32 expected, UInt32 x)
+{
+	return (static_cast<UInt32>(InterlockedCompareExchange(
+							reinterpret_cast<volatile LONG*>(&v),
+							static_cast<LONG>(x),
+							static_cast<LONG>(expected))) == expected);
+}
+
+template <class T>
+inline
+T*
+CArchAtomic::loadPointer(T* const volatile& p)
+{
+	T* x = p;
+	MemoryBarrier();
+	return x;
+}
+
+template <class T>
+inline
+void
+CArchAtomic::storePointer(T* volatile& p, T* x)
+{
+	MemoryBarrier();
+	p = x;
+}
+
+#else
+
+// x86 never moves a load ahead of another load or a store ahead of
+// another access so loads and stores only have to be kept in order by
+// the compiler.  other processors need a real barrier.
+#if defined(__i386__) || defined(__x86_64__)
+#	define ARCH_ATOMIC_FENCE() __asm__ __volatile__("" : : : "memory")
+#else
+#	define ARCH_ATOMIC_FENCE() __sync_synchronize()
+#endif
+
+inline
+UInt32
+CArchAtomic::load(const volatile UInt32& v)
+{
+	UInt32 x = v;
+	ARCH_ATOMIC_FENCE();
+	return x;
+}
+
+inline
+void
+CArchAtomic::store(volatile UInt32& v, UInt32 x)
+{
+	ARCH_ATOMIC_FENCE();
+	v = x;
+}
+
+inline
+UInt32
+CArchAtomic::add(volatile UInt32& v, UInt32 delta)
+{
+	return __sync_add_and_fetch(&v, delta);
+}
+
+inline
+bool
+CArchAtomic::compareAndSwap(volatile UInt32& v, UInt32 expected, UInt32 x)
+{
+	return __sync_bool_compare_and_swap(&v, expected, x);
+}
+
+template <class T>
+inline
+T*
+CArchAtomic::loadPointer(T* const volatile& p)
+{
+	T* x = p;
+	ARCH_ATOMIC_FENCE();
+	return x;
+}
+
+template <class T>
+inline
+void
+CArchAtomic::storePointer(T* volatile& p, T* x)
+{
+	ARCH_ATOMIC_FENCE();
+	p = x;
+}
+
+#endif
+
+#endif
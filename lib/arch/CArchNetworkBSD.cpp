@@ -19,6 +19,7 @@
 #if HAVE_UNISTD_H
 #	include <unistd.h>
 #endif
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #if !defined(TCP_NODELAY)
@@ -40,6 +41,10 @@
 #	endif
 #endif
 
+#if HAVE_EPOLL
+#	include <sys/epoll.h>
+#endif
+
 #if !HAVE_INET_ATON
 #	include <stdio.h>
 #endif
@@ -493,6 +498,183 @@ CArchNetworkBSD::unblockPollSocket(CArchThread thread)
 	}
 }
 
+#if HAVE_EPOLL
+
+CArchPollSet
+CArchNetworkBSD::newPollSet()
+{
+	// the size is only a hint
+	int fd = epoll_create(16);
+	if (fd == -1) {
+		throwError(errno);
+	}
+
+	CArchPollSetImpl* set = new CArchPollSetImpl;
+	set->m_fd             = fd;
+	set->m_unblockFd      = -1;
+	return set;
+}
+
+void
+CArchNetworkBSD::closePollSet(CArchPollSet set)
+{
+	assert(set != NULL);
+
+	close(set->m_fd);
+	delete set;
+}
+
+void
+CArchNetworkBSD::setPollSetEvents(CArchPollSet set, CArchSocket s,
+				unsigned short events, void* userData)
+{
+	assert(set != NULL);
+	assert(s   != NULL);
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	if ((events & kPOLLIN) != 0) {
+		ev.events |= EPOLLIN;
+	}
+	if ((events & kPOLLOUT) != 0) {
+		ev.events |= EPOLLOUT;
+	}
+	ev.data.ptr = userData;
+
+	// change the interest in place, adding the socket if it's new
+	if (epoll_ctl(set->m_fd, EPOLL_CTL_MOD, s->m_fd, &ev) == -1) {
+		if (errno != ENOENT ||
+			epoll_ctl(set->m_fd, EPOLL_CTL_ADD, s->m_fd, &ev) == -1) {
+			throwError(errno);
+		}
+	}
+}
+
+void
+CArchNetworkBSD::removePollSetSocket(CArchPollSet set, CArchSocket s)
+{
+	assert(set != NULL);
+	assert(s   != NULL);
+
+	// old kernels require a non-NULL event even though it's ignored
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	if (epoll_ctl(set->m_fd, EPOLL_CTL_DEL, s->m_fd, &ev) == -1) {
+		if (errno != ENOENT && errno != EBADF) {
+			throwError(errno);
+		}
+	}
+}
+
+int
+CArchNetworkBSD::waitPollSet(CArchPollSet set,
+				CPollSetEntry ready[], int num, double timeout)
+{
+	assert(set   != NULL);
+	assert(ready != NULL && num > 0);
+
+	// add the unblock pipe for this thread.  we identify its events
+	// by the set itself, which can't be any client's user data.
+	const int* unblockPipe = getUnblockPipe();
+	if (unblockPipe != NULL && unblockPipe[0] != set->m_unblockFd) {
+		struct epoll_event ev;
+		memset(&ev, 0, sizeof(ev));
+		if (set->m_unblockFd != -1) {
+			epoll_ctl(set->m_fd, EPOLL_CTL_DEL, set->m_unblockFd, &ev);
+		}
+		ev.events   = EPOLLIN;
+		ev.data.ptr = set;
+		if (epoll_ctl(set->m_fd, EPOLL_CTL_ADD, unblockPipe[0], &ev) == -1) {
+			throwError(errno);
+		}
+		set->m_unblockFd = unblockPipe[0];
+	}
+
+	// prepare timeout
+	int t = (timeout < 0.0) ? -1 : static_cast<int>(1000.0 * timeout);
+
+	// do the wait
+	static const int s_maxEvents = 64;
+	struct epoll_event ev[s_maxEvents];
+	int n = epoll_wait(set->m_fd, ev,
+							(num < s_maxEvents) ? num : s_maxEvents, t);
+
+	// handle results
+	if (n == -1) {
+		if (errno == EINTR) {
+			// interrupted system call
+			ARCH->testCancelThread();
+			return 0;
+		}
+		throwError(errno);
+	}
+
+	// translate ready sockets
+	int m = 0;
+	for (int i = 0; i < n; ++i) {
+		if (ev[i].data.ptr == set) {
+			// the unblock event was signalled.  flush the pipe.
+			char dummy[100];
+			do {
+				read(unblockPipe[0], dummy, sizeof(dummy));
+			} while (errno != EAGAIN);
+			continue;
+		}
+
+		ready[m].m_userData = ev[i].data.ptr;
+		ready[m].m_revents  = 0;
+		if ((ev[i].events & EPOLLIN) != 0) {
+			ready[m].m_revents |= kPOLLIN;
+		}
+		if ((ev[i].events & EPOLLOUT) != 0) {
+			ready[m].m_revents |= kPOLLOUT;
+		}
+		if ((ev[i].events & EPOLLERR) != 0) {
+			ready[m].m_revents |= kPOLLERR;
+		}
+		++m;
+	}
+
+	return m;
+}
+
+#else
+
+CArchPollSet
+CArchNetworkBSD::newPollSet()
+{
+	// not supported.  clients fall back to pollSocket().
+	return NULL;
+}
+
+void
+CArchNetworkBSD::closePollSet(CArchPollSet)
+{
+	assert(0 && "poll sets not supported");
+}
+
+void
+CArchNetworkBSD::setPollSetEvents(CArchPollSet, CArchSocket,
+				unsigned short, void*)
+{
+	assert(0 && "poll sets not supported");
+}
+
+void
+CArchNetworkBSD::removePollSetSocket(CArchPollSet, CArchSocket)
+{
+	assert(0 && "poll sets not supported");
+}
+
+int
+CArchNetworkBSD::waitPollSet(CArchPollSet, CPollSetEntry[], int, double)
+{
+	assert(0 && "poll sets not supported");
+	return 0;
+}
+
+#endif
+
 size_t
 CArchNetworkBSD::readSocket(CArchSocket s, void* buf, size_t len)
 {
@@ -523,6 +705,83 @@ CArchNetworkBSD::writeSocket(CArchSocket s, const void* buf, size_t len)
 	return n;
 }
 
+size_t
+CArchNetworkBSD::writevSocket(CArchSocket s, const CIOVec vec[], int num)
+{
+	assert(s != NULL);
+	assert(vec != NULL || num == 0);
+
+	// translate pieces.  the caller will write the rest later if there
+	// are too many.
+	static const int s_maxPieces = 64;
+	struct iovec iov[s_maxPieces];
+	if (num > s_maxPieces) {
+		num = s_maxPieces;
+	}
+	for (int i = 0; i < num; ++i) {
+		iov[i].iov_base = const_cast<void*>(vec[i].m_data);
+		iov[i].iov_len  = vec[i].m_size;
+	}
+
+	ssize_t n = writev(s->m_fd, iov, num);
+	if (n == -1) {
+		if (errno == EINTR || errno == EAGAIN) {
+			return 0;
+		}
+		throwError(errno);
+	}
+	return n;
+}
+
+size_t
+CArchNetworkBSD::readFromSocket(CArchSocket s, void* buf, size_t len,
+				CArchNetAddress* addr)
+{
+	assert(s != NULL);
+
+	CArchNetAddressImpl* from = new CArchNetAddressImpl;
+	ACCEPT_TYPE_ARG3 fromLen  = (ACCEPT_TYPE_ARG3)(from->m_len);
+	ssize_t n = recvfrom(s->m_fd, buf, len, 0, &from->m_addr, &fromLen);
+	from->m_len = (socklen_t)fromLen;
+	if (n <= 0) {
+		int err = errno;
+		delete from;
+		if (addr != NULL) {
+			*addr = NULL;
+		}
+		if (n == 0 || err == EINTR || err == EAGAIN) {
+			return 0;
+		}
+		throwError(err);
+	}
+
+	// return address if requested
+	if (addr != NULL) {
+		*addr = from;
+	}
+	else {
+		delete from;
+	}
+	return n;
+}
+
+size_t
+CArchNetworkBSD::writeToSocket(CArchSocket s, const void* buf, size_t len,
+				CArchNetAddress addr)
+{
+	assert(s    != NULL);
+	assert(addr != NULL);
+
+	ssize_t n = sendto(s->m_fd, buf, len, 0, &addr->m_addr, addr->m_len);
+	if (n == -1) {
+		if (errno == EINTR || errno == EAGAIN || errno == ENOBUFS) {
+			return 0;
+		}
+		throwError(errno);
+	}
+	return n;
+}
+
 void
 CArchNetworkBSD::throwErrorOnSocket(CArchSocket s)
 {
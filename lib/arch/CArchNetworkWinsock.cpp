@@ -43,8 +43,10 @@ static int (PASCAL FAR *ioctl_winsock)(SOCKET s, int cmd, void FAR * data);
 static int (PASCAL FAR *listen_winsock)(SOCKET s, int backlog);
 static u_short (PASCAL FAR *ntohs_winsock)(u_short v);
 static int (PASCAL FAR *recv_winsock)(SOCKET s, void FAR * buf, int len, int flags);
+static int (PASCAL FAR *recvfrom_winsock)(SOCKET s, void FAR * buf, int len, int flags, struct sockaddr FAR *from, int FAR * fromlen);
 static int (PASCAL FAR *select_winsock)(int nfds, fd_set FAR *readfds, fd_set FAR *writefds, fd_set FAR *exceptfds, const struct timeval FAR *timeout);
 static int (PASCAL FAR *send_winsock)(SOCKET s, const void FAR * buf, int len, int flags);
+static int (PASCAL FAR *sendto_winsock)(SOCKET s, const void FAR * buf, int len, int flags, const struct sockaddr FAR *to, int tolen);
 static int (PASCAL FAR *setsockopt_winsock)(SOCKET s, int level, int optname, const void FAR * optval, int optlen);
 static int (PASCAL FAR *shutdown_winsock)(SOCKET s, int how);
 static SOCKET (PASCAL FAR *socket_winsock)(int af, int type, int protocol);
@@ -165,8 +167,10 @@ CArchNetworkWinsock::init(HMODULE module)
 	setfunc(listen_winsock, listen, int (PASCAL FAR *)(SOCKET s, int backlog));
 	setfunc(ntohs_winsock, ntohs, u_short (PASCAL FAR *)(u_short v));
 	setfunc(recv_winsock, recv, int (PASCAL FAR *)(SOCKET s, void FAR * buf, int len, int flags));
+	setfunc(recvfrom_winsock, recvfrom, int (PASCAL FAR *)(SOCKET s, void FAR * buf, int len, int flags, struct sockaddr FAR *from, int FAR * fromlen));
 	setfunc(select_winsock, select, int (PASCAL FAR *)(int nfds, fd_set FAR *readfds, fd_set FAR *writefds, fd_set FAR *exceptfds, const struct timeval FAR *timeout));
 	setfunc(send_winsock, send, int (PASCAL FAR *)(SOCKET s, const void FAR * buf, int len, int flags));
+	setfunc(sendto_winsock, sendto, int (PASCAL FAR *)(SOCKET s, const void FAR * buf, int len, int flags, const struct sockaddr FAR *to, int tolen));
 	setfunc(setsockopt_winsock, setsockopt, int (PASCAL FAR *)(SOCKET s, int level, int optname, const void FAR * optval, int optlen));
 	setfunc(shutdown_winsock, shutdown, int (PASCAL FAR *)(SOCKET s, int how));
 	setfunc(socket_winsock, socket, SOCKET (PASCAL FAR *)(int af, int type, int protocol));
@@ -522,6 +526,39 @@ CArchNetworkWinsock::unblockPollSocket(CArchThread thread)
 	}
 }
 
+CArchPollSet
+CArchNetworkWinsock::newPollSet()
+{
+	// not supported.  clients fall back to pollSocket().
+	return NULL;
+}
+
+void
+CArchNetworkWinsock::closePollSet(CArchPollSet)
+{
+	assert(0 && "poll sets not supported");
+}
+
+void
+CArchNetworkWinsock::setPollSetEvents(CArchPollSet, CArchSocket,
+				unsigned short, void*)
+{
+	assert(0 && "poll sets not supported");
+}
+
+void
+CArchNetworkWinsock::removePollSetSocket(CArchPollSet, CArchSocket)
+{
+	assert(0 && "poll sets not supported");
+}
+
+int
+CArchNetworkWinsock::waitPollSet(CArchPollSet, CPollSetEntry[], int, double)
+{
+	assert(0 && "poll sets not supported");
+	return 0;
+}
+
 size_t
 CArchNetworkWinsock::readSocket(CArchSocket s, void* buf, size_t len)
 {
@@ -558,6 +595,81 @@ CArchNetworkWinsock::writeSocket(CArchSocket s, const void* buf, size_t len)
 	return static_cast<size_t>(n);
 }
 
+size_t
+CArchNetworkWinsock::writevSocket(CArchSocket s, const CIOVec vec[], int num)
+{
+	assert(s != NULL);
+	assert(vec != NULL || num == 0);
+
+	// write each piece until the socket won't take any more
+	size_t total = 0;
+	for (int i = 0; i < num; ++i) {
+		size_t n = writeSocket(s, vec[i].m_data, vec[i].m_size);
+		total   += n;
+		if (n < vec[i].m_size) {
+			break;
+		}
+	}
+	return total;
+}
+
+size_t
+CArchNetworkWinsock::readFromSocket(CArchSocket s, void* buf, size_t len,
+				CArchNetAddress* addr)
+{
+	assert(s != NULL);
+
+	CArchNetAddress from = CArchNetAddressImpl::alloc(sizeof(struct sockaddr));
+	int n = recvfrom_winsock(s->m_socket, buf, len, 0,
+							&from->m_addr, &from->m_len);
+	if (n == SOCKET_ERROR) {
+		int err = getsockerror_winsock();
+		if (err == WSAEMSGSIZE) {
+			// datagram was truncated to fit buf
+			n = static_cast<int>(len);
+		}
+		else {
+			free(from);
+			if (addr != NULL) {
+				*addr = NULL;
+			}
+			if (err == WSAEINTR || err == WSAEWOULDBLOCK ||
+				err == WSAECONNRESET) {
+				// WSAECONNRESET reports an ICMP port unreachable for an
+				// earlier datagram, not a problem with this socket
+				return 0;
+			}
+			throwError(err);
+		}
+	}
+
+	// copy address if requested
+	if (addr != NULL) {
+		*addr = ARCH->copyAddr(from);
+	}
+	free(from);
+	return static_cast<size_t>(n);
+}
+
+size_t
+CArchNetworkWinsock::writeToSocket(CArchSocket s, const void* buf, size_t len,
+				CArchNetAddress addr)
+{
+	assert(s    != NULL);
+	assert(addr != NULL);
+
+	int n = sendto_winsock(s->m_socket, buf, len, 0,
+							&addr->m_addr, addr->m_len);
+	if (n == SOCKET_ERROR) {
+		int err = getsockerror_winsock();
+		if (err == WSAEINTR || err == WSAEWOULDBLOCK) {
+			return 0;
+		}
+		throwError(err);
+	}
+	return static_cast<size_t>(n);
+}
+
 void
 CArchNetworkWinsock::throwErrorOnSocket(CArchSocket s)
 {
@@ -14,6 +14,10 @@
 
 #include "CArchSystemUnix.h"
 #include <sys/utsname.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
 
 //
 // CArchSystemUnix
@@ -48,3 +52,38 @@ CArchSystemUnix::getOSName() const
 #endif
 	return "Unix <unknown>";
 }
+
+void
+CArchSystemUnix::getRandom(void* buffer, UInt32 size) const
+{
+	UInt8* dst = reinterpret_cast<UInt8*>(buffer);
+	int fd = open("/dev/urandom", O_RDONLY);
+	if (fd != -1) {
+		while (size > 0) {
+			ssize_t n = read(fd, dst, size);
+			if (n > 0) {
+				dst  += n;
+				size -= static_cast<UInt32>(n);
+			}
+			else if (n == 0 || errno != EINTR) {
+				break;
+			}
+		}
+		close(fd);
+	}
+
+	// no random device.  the best we can do is mix the time and our
+	// process id, which at least differ from run to run.
+	if (size > 0) {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		UInt32 x = static_cast<UInt32>(tv.tv_sec) * 1000003u ^
+					static_cast<UInt32>(tv.tv_usec) ^
+					(static_cast<UInt32>(getpid()) << 16);
+		while (size > 0) {
+			x      = x * 1664525u + 1013904223u;
+			*dst++ = static_cast<UInt8>(x >> 24);
+			--size;
+		}
+	}
+}
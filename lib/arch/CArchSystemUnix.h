@@ -27,6 +27,7 @@ public:
 
 	// IArchSystem overrides
 	virtual std::string	getOSName() const;
+	virtual void		getRandom(void* buffer, UInt32 size) const;
 };
 
 #endif
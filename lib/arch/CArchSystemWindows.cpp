@@ -16,6 +16,7 @@
 
 #include "CArchSystemWindows.h"
 #include <windows.h>
+#include <wincrypt.h>
 
 //
 // CArchSystemWindows
@@ -84,3 +85,31 @@ CArchSystemWindows::getOSName() const
 	}
 	return "Microsoft Windows <unknown>";
 }
+
+void
+CArchSystemWindows::getRandom(void* buffer, UInt32 size) const
+{
+	BYTE* dst = reinterpret_cast<BYTE*>(buffer);
+	HCRYPTPROV provider;
+	if (CryptAcquireContext(&provider, NULL, NULL, PROV_RSA_FULL,
+							CRYPT_VERIFYCONTEXT | CRYPT_SILENT)) {
+		BOOL result = CryptGenRandom(provider, size, dst);
+		CryptReleaseContext(provider, 0);
+		if (result) {
+			return;
+		}
+	}
+
+	// no crypto provider.  the best we can do is mix the time and our
+	// process id, which at least differ from run to run.
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	UInt32 x = static_cast<UInt32>(counter.LowPart) * 1000003u ^
+				static_cast<UInt32>(counter.HighPart) ^
+				(static_cast<UInt32>(GetCurrentProcessId()) << 16);
+	while (size > 0) {
+		x      = x * 1664525u + 1013904223u;
+		*dst++ = static_cast<BYTE>(x >> 24);
+		--size;
+	}
+}
@@ -41,7 +41,15 @@ CArchTimeUnix::~CArchTimeUnix()
 double
 CArchTimeUnix::time()
 {
-	struct timeval t;
-	gettimeofday(&t, NULL);
-	return (double)t.tv_sec + 1.0e-6 * (double)t.tv_usec;
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+	// use the monotonic clock so stepping the wall clock doesn't
+	// fire or stall timers
+	struct timespec t;
+	if (clock_gettime(CLOCK_MONOTONIC, &t) == 0) {
+		return (double)t.tv_sec + 1.0e-9 * (double)t.tv_nsec;
+	}
+#endif
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double)tv.tv_sec + 1.0e-6 * (double)tv.tv_usec;
 }
@@ -50,6 +50,21 @@ An opaque type representing a network address.
 */
 typedef CArchNetAddressImpl* CArchNetAddress;
 
+/*!      
+\class CArchPollSetImpl
+\brief Internal poll set data.
+An architecture dependent type holding the necessary data for a
+persistent poll set.
+*/
+class CArchPollSetImpl;
+
+/*!      
+\var CArchPollSet
+\brief Opaque poll set type.
+An opaque type representing a persistent set of sockets to poll.
+*/
+typedef CArchPollSetImpl* CArchPollSet;
+
 //! Interface for architecture dependent networking
 /*!
 This interface defines the networking operations required by
@@ -98,6 +113,26 @@ public:
 		unsigned short	m_revents;
 	};
 
+	//! A piece of data for \c writevSocket()
+	class CIOVec {
+	public:
+		//! The data
+		const void*		m_data;
+
+		//! The number of bytes of data
+		size_t			m_size;
+	};
+
+	//! A ready socket reported by \c waitPollSet()
+	class CPollSetEntry {
+	public:
+		//! The data passed to \c setPollSetEvents() for the socket
+		void*			m_userData;
+
+		//! The result events
+		unsigned short	m_revents;
+	};
+
 	//! @name manipulators
 	//@{
 
@@ -193,6 +228,57 @@ public:
 	*/
 	virtual void		unblockPollSocket(CArchThread thread) = 0;
 
+	//! Create a persistent poll set
+	/*!
+	Returns a new, empty poll set or NULL if persistent poll sets are
+	not supported, in which case clients must use \c pollSocket().
+	Sockets are registered with a poll set once and their events are
+	changed in place, so waiting costs time proportional to the number
+	of ready sockets rather than the number of registered sockets.
+	*/
+	virtual CArchPollSet	newPollSet() = 0;
+
+	//! Destroy a poll set
+	/*!
+	Destroys a poll set returned by \c newPollSet().  The sockets in
+	the set are not affected.
+	*/
+	virtual void		closePollSet(CArchPollSet set) = 0;
+
+	//! Set the events for a socket in a poll set
+	/*!
+	Adds socket \c s to \c set or, if it's already in the set, changes
+	the events to query for in place.  \c events can be any combination
+	of kPOLLIN and kPOLLOUT (or 0 to only detect errors).  \c userData
+	is reported with the socket's events by \c waitPollSet().
+	*/
+	virtual void		setPollSetEvents(CArchPollSet set, CArchSocket s,
+							unsigned short events, void* userData) = 0;
+
+	//! Remove a socket from a poll set
+	/*!
+	Removes socket \c s from \c set.  This must be called before the
+	last reference to \c s is closed.  It's not an error if \c s is
+	not in the set.
+	*/
+	virtual void		removePollSetSocket(CArchPollSet set,
+							CArchSocket s) = 0;
+
+	//! Wait on a poll set
+	/*!
+	Waits up to \c timeout seconds (or indefinitely if \c timeout < 0)
+	for some socket in \c set to become ready.  Fills in at most \c num
+	entries of \c ready with the sockets that are ready and returns
+	the number of entries filled in, which may be 0 if
+	\c unblockPollSocket() was called for the waiting thread.  Events
+	are reported as for \c pollSocket().
+
+	(Cancellation point)
+	*/
+	virtual int			waitPollSet(CArchPollSet set,
+							CPollSetEntry ready[], int num,
+							double timeout) = 0;
+
 	//! Read data from socket
 	/*!
 	Read up to \c len bytes from socket \c s in \c buf and return the
@@ -212,6 +298,37 @@ public:
 	virtual size_t		writeSocket(CArchSocket s,
 							const void* buf, size_t len) = 0;
 
+	//! Write scattered data to socket
+	/*!
+	Write the \c num pieces of data in \c vec, in order, to socket \c s
+	and return the number of bytes written.  This is like calling
+	\c writeSocket() on each piece until one is not completely written,
+	but may be done with a single system call.
+	*/
+	virtual size_t		writevSocket(CArchSocket s,
+							const CIOVec vec[], int num) = 0;
+
+	//! Read datagram from socket
+	/*!
+	Read the next datagram waiting on the datagram socket \c s into
+	\c buf and return its length.  Any part of the datagram beyond
+	\c len bytes is discarded.  The sender's address is returned in
+	\c addr, which the caller must close with \c closeAddr(), unless
+	\c addr is NULL.  Returns 0, and sets \c addr to NULL, if no
+	datagram is waiting.
+	*/
+	virtual size_t		readFromSocket(CArchSocket s, void* buf, size_t len,
+							CArchNetAddress* addr) = 0;
+
+	//! Write datagram to socket
+	/*!
+	Send \c len bytes from \c buf as a single datagram on the datagram
+	socket \c s to \c addr.  Returns the number of bytes sent, which is
+	0 if the datagram could not be queued.
+	*/
+	virtual size_t		writeToSocket(CArchSocket s, const void* buf,
+							size_t len, CArchNetAddress addr) = 0;
+
 	//! Check error on socket
 	/*!
 	If the socket \c s is in an error state then throws an appropriate
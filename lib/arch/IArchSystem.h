@@ -16,6 +16,7 @@
 #define IARCHSYSTEM_H
 
 #include "IInterface.h"
+#include "BasicTypes.h"
 #include "stdstring.h"
 
 //! Interface for architecture dependent system queries
@@ -33,6 +34,13 @@ public:
 	*/
 	virtual std::string	getOSName() const = 0;
 
+	//! Get random bytes
+	/*!
+	Fills \p buffer with \p size bytes from the system's secure random
+	number source, for values other hosts must not be able to guess.
+	*/
+	virtual void		getRandom(void* buffer, UInt32 size) const = 0;
+
 	//@}
 };
 
@@ -30,7 +30,8 @@ public:
 	//! Get the current time
 	/*!
 	Returns the number of seconds since some arbitrary starting time.
-	This should return as high a precision as reasonable.
+	This should return as high a precision as reasonable and should
+	not jump when the user or the system changes the wall clock.
 	*/
 	virtual double		time() = 0;
 
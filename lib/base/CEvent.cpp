@@ -13,7 +13,9 @@
  */
 
 #include "CEvent.h"
+#include "CEventDataPool.h"
 #include "CEventQueue.h"
+#include <string.h>
 
 //
 // CEvent
@@ -21,20 +23,32 @@
 
 CEvent::CEvent() :
 	m_type(kUnknown),
-	m_target(NULL),
-	m_data(NULL),
-	m_flags(0)
+	m_flags(0),
+	m_target(NULL)
 {
-	// do nothing
+	m_data.m_pointer = NULL;
 }
 
 CEvent::CEvent(Type type, void* target, void* data, Flags flags) :
 	m_type(type),
-	m_target(target),
-	m_data(data),
-	m_flags(flags)
+	m_flags(flags & ~kInlineData),
+	m_target(target)
 {
-	// do nothing
+	m_data.m_pointer = data;
+}
+
+void
+CEvent::setCopy(const void* data, UInt32 size)
+{
+	if (size <= kInlineSize) {
+		memcpy(m_data.m_inline, data, size);
+		m_flags |= kInlineData;
+	}
+	else {
+		m_data.m_pointer = CEventDataPool::alloc(size);
+		memcpy(m_data.m_pointer, data, size);
+		m_flags &= ~kDontFreeData;
+	}
 }
 
 CEvent::Type
@@ -52,13 +66,16 @@ CEvent::getTarget() const
 void*
 CEvent::getData() const
 {
-	return m_data;
+	if ((m_flags & kInlineData) != 0) {
+		return const_cast<UInt32*>(m_data.m_inline);
+	}
+	return m_data.m_pointer;
 }
 
 CEvent::Flags
 CEvent::getFlags() const
 {
-	return m_flags;
+	return (m_flags & ~kInlineData);
 }
 
 CEvent::Type
@@ -87,11 +104,12 @@ CEvent::deleteData(const CEvent& event)
 	case kQuit:
 	case kSystem:
 	case kTimer:
+	case kFlush:
 		break;
 
 	default:
-		if ((event.getFlags() & kDontFreeData) == 0) {
-			free(event.getData());
+		if ((event.m_flags & (kDontFreeData | kInlineData)) == 0) {
+			CEventDataPool::release(event.m_data.m_pointer);
 		}
 		break;
 	}
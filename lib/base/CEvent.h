@@ -20,7 +20,9 @@
 
 //! Event
 /*!
-A \c CEvent holds an event type and a pointer to event data.
+A \c CEvent holds an event type and a pointer to event data.  Data
+no bigger than \c kInlineSize can instead be stored in the event itself
+using \c withCopy().
 */
 class CEvent {
 public:
@@ -30,6 +32,7 @@ public:
 		kQuit,		//!< The quit event
 		kSystem,	//!< The data points to a system event type
 		kTimer,		//!< The data points to timer info
+		kFlush,		//!< Requested with IEventQueue::addFlush()
 		kLast		//!< Must be last
 	};
 
@@ -40,19 +43,38 @@ public:
 		kDontFreeData		= 0x02	//!< Don't free data in deleteData
 	};
 
+	enum {
+		kInlineSize			= 8		//!< Most data stored in the event
+	};
+
 	CEvent();
 
 	//! Create \c CEvent with data
 	/*!
 	The \p type must have been registered using \c registerType().
-	The \p data must be POD (plain old data) allocated by malloc(),
-	which means it cannot have a constructor, destructor or be
-	composed of any types that do.  \p target is the intended
-	recipient of the event.  \p flags is any combination of \c Flags.
+	The \p data must be POD (plain old data) allocated by malloc() or
+	\c CEventDataPool::alloc(), which means it cannot have a
+	constructor, destructor or be composed of any types that do.
+	\p target is the intended recipient of the event.  \p flags is
+	any combination of \c Flags.
 	*/
 	CEvent(Type type, void* target = NULL, void* data = NULL,
 							 UInt32 flags = kNone);
 
+	//! Create \c CEvent with a copy of data
+	/*!
+	Returns an event like \c CEvent(type, target, data, flags) except
+	that it owns a copy of \p data.  The data must be POD and must not
+	point into itself.  If it's no bigger than \c kInlineSize it's
+	stored in the event, so creating and posting the event doesn't
+	allocate.  \c getData() then returns a pointer into the event,
+	which is only valid as long as that copy of the event is.  Larger
+	data is copied into memory from \c CEventDataPool::alloc().
+	*/
+	template <class T>
+	static CEvent		withCopy(Type type, void* target, const T& data,
+							 UInt32 flags = kNone);
+
 	//! @name manipulators
 	//@{
 
@@ -79,7 +101,9 @@ public:
 
 	//! Release event data
 	/*!
-	Deletes event data for the given event (using free()).
+	Deletes event data for the given event (using
+	\c CEventDataPool::release()).  Does nothing if the data is stored
+	in the event or the event has the \c kDontFreeData flag.
 	*/
 	static void			deleteData(const CEvent&);
 
@@ -113,11 +137,30 @@ public:
 	
 	//@}
 
+private:
+	// set in m_flags when the data is stored in m_data.m_inline
+	enum { kInlineData = 0x80000000 };
+
+	void				setCopy(const void* data, UInt32 size);
+
 private:
 	Type				m_type;
-	void*				m_target;
-	void*				m_data;
 	Flags				m_flags;
+	void*				m_target;
+	union {
+		void*			m_pointer;
+		UInt32			m_inline[kInlineSize / sizeof(UInt32)];
+	} m_data;
 };
 
+template <class T>
+inline
+CEvent
+CEvent::withCopy(Type type, void* target, const T& data, UInt32 flags)
+{
+	CEvent event(type, target, NULL, flags);
+	event.setCopy(&data, sizeof(T));
+	return event;
+}
+
 #endif
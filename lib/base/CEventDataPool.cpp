@@ -0,0 +1,177 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CEventDataPool.h"
+#include "CArchAtomic.h"
+#include "CLog.h"
+#include <stdlib.h>
+
+//
+// CEventDataSlab
+//
+
+// a slab of equal sized blocks.  free blocks form a stack linked by
+// index.  the top of the stack is packed with a count of changes to it
+// into one word so any thread can take or return a block with a single
+// compare and swap.  a thread preempted between reading the top and
+// swapping it only mistakes a new top for the one it read if the stack
+// changed exactly a multiple of 65536 times in between.
+class CEventDataSlab {
+public:
+	CEventDataSlab(UInt32 blockSize, UInt32 numBlocks);
+	~CEventDataSlab();
+
+	// returns a free block or NULL if they're all in use
+	void*				alloc();
+
+	// returns block to the slab.  returns false if block isn't part of
+	// the slab.
+	bool				release(void* block);
+
+	UInt32				getBlockSize() const;
+
+private:
+	enum { kEnd = 0xffff };
+
+	UInt32				m_blockSize;
+	char*				m_begin;
+	char*				m_end;
+	UInt16*				m_next;
+
+	// low 16 bits index the top block, high 16 bits count changes
+	volatile UInt32		m_top;
+};
+
+CEventDataSlab::CEventDataSlab(UInt32 blockSize, UInt32 numBlocks) :
+	m_blockSize(blockSize)
+{
+	assert(numBlocks < kEnd);
+
+	m_begin = static_cast<char*>(malloc(blockSize * numBlocks));
+	m_end   = m_begin + blockSize * numBlocks;
+	m_next  = new UInt16[numBlocks];
+	for (UInt32 i = 0; i + 1 < numBlocks; ++i) {
+		m_next[i] = static_cast<UInt16>(i + 1);
+	}
+	m_next[numBlocks - 1] = kEnd;
+	m_top = 0;
+}
+
+CEventDataSlab::~CEventDataSlab()
+{
+	delete[] m_next;
+	free(m_begin);
+}
+
+void*
+CEventDataSlab::alloc()
+{
+	UInt32 top, index;
+	do {
+		top   = CArchAtomic::load(m_top);
+		index = (top & 0xffffu);
+		if (index == kEnd) {
+			return NULL;
+		}
+		// m_next[index] may be stale if another thread takes the block
+		// first but then the swap fails
+	} while (!CArchAtomic::compareAndSwap(m_top, top,
+							((top + 0x10000u) & 0xffff0000u) | m_next[index]));
+	return m_begin + index * m_blockSize;
+}
+
+bool
+CEventDataSlab::release(void* block)
+{
+	char* p = static_cast<char*>(block);
+	if (p < m_begin || p >= m_end) {
+		return false;
+	}
+	const UInt32 index = static_cast<UInt32>((p - m_begin) / m_blockSize);
+	UInt32 top;
+	do {
+		top           = CArchAtomic::load(m_top);
+		m_next[index] = static_cast<UInt16>(top & 0xffffu);
+	} while (!CArchAtomic::compareAndSwap(m_top, top,
+							((top + 0x10000u) & 0xffff0000u) | index));
+	return true;
+}
+
+UInt32
+CEventDataSlab::getBlockSize() const
+{
+	return m_blockSize;
+}
+
+// the small slab takes button, motion, wheel and hot key info that
+// isn't stored in the event itself, the middle one key info.  sizes
+// are multiples of 16 so every block is aligned like malloc()'s.
+static CEventDataSlab	s_smallSlab(16, 256);
+static CEventDataSlab	s_mediumSlab(64, 256);
+static CEventDataSlab	s_largeSlab(256, 64);
+static CEventDataSlab*	const s_slabs[] = {
+	&s_smallSlab,
+	&s_mediumSlab,
+	&s_largeSlab
+};
+static const UInt32		s_numSlabs = sizeof(s_slabs) / sizeof(s_slabs[0]);
+
+static volatile UInt32	s_heapCount = 0;
+
+
+//
+// CEventDataPool
+//
+
+void*
+CEventDataPool::alloc(UInt32 size)
+{
+	// use the smallest block that fits.  if they're all taken then a
+	// bigger block is still better than the heap.
+	for (UInt32 i = 0; i < s_numSlabs; ++i) {
+		if (size <= s_slabs[i]->getBlockSize()) {
+			void* block = s_slabs[i]->alloc();
+			if (block != NULL) {
+				return block;
+			}
+		}
+	}
+	// log the first fallback and then every power of two so an
+	// undersized slab or a leak shows up without flooding the log
+	UInt32 count = CArchAtomic::add(s_heapCount, 1);
+	if ((count & (count - 1)) == 0) {
+		LOG((CLOG_DEBUG "event data of %d bytes fell back to the heap, %d time%s so far", size, count, (count == 1) ? "" : "s"));
+	}
+	return malloc(size);
+}
+
+void
+CEventDataPool::release(void* data)
+{
+	if (data == NULL) {
+		return;
+	}
+	for (UInt32 i = 0; i < s_numSlabs; ++i) {
+		if (s_slabs[i]->release(data)) {
+			return;
+		}
+	}
+	free(data);
+}
+
+UInt32
+CEventDataPool::getHeapCount()
+{
+	return CArchAtomic::load(s_heapCount);
+}
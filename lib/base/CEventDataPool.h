@@ -0,0 +1,61 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CEVENTDATAPOOL_H
+#define CEVENTDATAPOOL_H
+
+#include "BasicTypes.h"
+
+//! Event data allocator
+/*!
+Allocates event data from slabs of fixed size blocks that are set
+aside up front, one slab per block size, so posting input events
+doesn't touch the heap.  Any thread may allocate and release blocks.
+Requests bigger than the largest block, or made while every block of
+the right size is in use, fall back to malloc().
+*/
+class CEventDataPool {
+public:
+	//! @name manipulators
+	//@{
+
+	//! Allocate event data
+	/*!
+	Returns \p size bytes suitably aligned for any event data.  The
+	memory must be freed with \c release().
+	*/
+	static void*		alloc(UInt32 size);
+
+	//! Release event data
+	/*!
+	Frees \p data, which must be NULL or have come from \c alloc() or
+	malloc().
+	*/
+	static void			release(void* data);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get number of heap allocations
+	/*!
+	Returns the number of calls to \c alloc() that had to use malloc().
+	This should stay zero while the input path runs normally.
+	*/
+	static UInt32		getHeapCount();
+
+	//@}
+};
+
+#endif
@@ -13,11 +13,25 @@
  */
 
 #include "CEventQueue.h"
+#include "CEventDataPool.h"
 #include "CLog.h"
 #include "CSimpleEventQueueBuffer.h"
 #include "CStopwatch.h"
 #include "IEventJob.h"
 #include "CArch.h"
+#include "CArchAtomic.h"
+
+// hash of a handler's key for the handler hash table.  targets are
+// mostly heap pointers so the lowest bits carry little information.
+static
+UInt32
+hashHandler(CEvent::Type type, void* target)
+{
+	const UInt32 h = static_cast<UInt32>(
+							reinterpret_cast<size_t>(target) >> 3) *
+							2654435761u + type * 40503u;
+	return h ^ (h >> 16);
+}
 
 // interrupt handler.  this just adds a quit event to the queue.
 static
@@ -33,20 +47,55 @@ interrupt(CArch::ESignal, void*)
 //
 
 CEventQueue::CEventQueue() :
-	m_nextType(CEvent::kLast)
+	m_nextType(CEvent::kLast),
+	m_eventSlots(kEventSlots),
+	m_freeEventSlots(kEventSlots),
+	m_posting(0),
+	m_adopting(0),
+	m_handlerHash(NULL),
+	m_readers(0),
+	m_numRetired(0),
+	m_dispatching(0),
+	m_flushesPending(0),
+	m_hasPending(false),
+	m_numTaken(0),
+	m_numCoalesced(0)
 {
 	setInstance(this);
-	m_mutex = ARCH->newMutex();
+	m_mutex      = ARCH->newMutex();
+	m_adoptMutex = ARCH->newMutex();
+	for (UInt32 i = 0; i < kEventSlots; ++i) {
+		m_freeEventSlots.push(i);
+	}
 	ARCH->setSignalHandler(CArch::kINTERRUPT, &interrupt, NULL);
 	ARCH->setSignalHandler(CArch::kTERMINATE, &interrupt, NULL);
 	m_buffer = new CSimpleEventQueueBuffer;
+	rebuildHandlerHash();
 }
 
 CEventQueue::~CEventQueue()
 {
+	LOG((CLOG_DEBUG1 "event data fell back to the heap %d times", CEventDataPool::getHeapCount()));
+	LOG((CLOG_DEBUG1 "coalesced %d of %d events", m_numCoalesced, m_numTaken));
+	if (m_hasPending) {
+		CEvent::deleteData(m_pending);
+	}
+	for (CTimers::iterator i = m_timers.begin(); i != m_timers.end(); ++i) {
+		delete i->second;
+	}
+	for (CRetiredHandlers::iterator i = m_retiredHandlers.begin();
+							i != m_retiredHandlers.end(); ++i) {
+		delete *i;
+	}
+	for (CRetiredHashes::iterator i = m_retiredHashes.begin();
+							i != m_retiredHashes.end(); ++i) {
+		delete *i;
+	}
+	delete m_handlerHash;
 	delete m_buffer;
 	ARCH->setSignalHandler(CArch::kINTERRUPT, NULL, NULL);
 	ARCH->setSignalHandler(CArch::kTERMINATE, NULL, NULL);
+	ARCH->closeMutex(m_adoptMutex);
 	ARCH->closeMutex(m_mutex);
 	setInstance(NULL);
 }
@@ -88,6 +137,9 @@ CEventQueue::getTypeName(CEvent::Type type)
 	case CEvent::kTimer:
 		return "timer";
 
+	case CEvent::kFlush:
+		return "flush";
+
 	default:
 		CTypeMap::const_iterator i = m_typeMap.find(type);
 		if (i == m_typeMap.end()) {
@@ -102,26 +154,54 @@ CEventQueue::getTypeName(CEvent::Type type)
 void
 CEventQueue::adoptBuffer(IEventQueueBuffer* buffer)
 {
+	// make new posts wait and let the ones in progress finish
+	CArchMutexLock adoptLock(m_adoptMutex);
+	CArchAtomic::add(m_adopting, 1);
+	while (CArchAtomic::load(m_posting) != 0) {
+		ARCH->sleep(0.0);
+	}
+
 	CArchMutexLock lock(m_mutex);
 
 	// discard old buffer and old events
 	delete m_buffer;
+	for (UInt32 i = 0; i < kEventSlots; ++i) {
+		if (m_eventSlots[i].getType() != CEvent::kUnknown) {
+			CEvent::deleteData(m_eventSlots[i]);
+			m_eventSlots[i] = CEvent();
+			m_freeEventSlots.push(i);
+		}
+	}
 	for (CEventTable::iterator i = m_events.begin(); i != m_events.end(); ++i) {
 		CEvent::deleteData(i->second);
 	}
 	m_events.clear();
 	m_oldEventIDs.clear();
+	if (m_hasPending) {
+		CEvent::deleteData(m_pending);
+		m_hasPending = false;
+	}
 
 	// use new buffer
 	m_buffer = buffer;
 	if (m_buffer == NULL) {
 		m_buffer = new CSimpleEventQueueBuffer;
 	}
+
+	CArchAtomic::add(m_adopting, static_cast<UInt32>(-1));
 }
 
 bool
 CEventQueue::getEvent(CEvent& event, double timeout)
 {
+	// an event read ahead while coalescing comes first
+	if (m_hasPending) {
+		event        = m_pending;
+		m_hasPending = false;
+		coalesceEvents(event);
+		return true;
+	}
+
 	CStopwatch timer(true);
 retry:
 	// if no events are waiting then handle timers and then wait
@@ -150,10 +230,7 @@ retry:
 	}
 
 	// get the event
-	UInt32 dataID;
-	IEventQueueBuffer::Type type = m_buffer->getEvent(event, dataID);
-	switch (type) {
-	case IEventQueueBuffer::kNone:
+	if (!readEvent(event)) {
 		if (timeout < 0.0 || timeout <= timer.getTime()) {
 			// don't want to fail if client isn't expecting that
 			// so if getEvent() fails with an infinite timeout
@@ -161,36 +238,47 @@ retry:
 			goto retry;
 		}
 		return false;
-
-	case IEventQueueBuffer::kSystem:
-		return true;
-
-	case IEventQueueBuffer::kUser:
-		{
-			CArchMutexLock lock(m_mutex);
-			event = removeEvent(dataID);
-			return true;
-		}
-
-	default:
-		assert(0 && "invalid event type");
-		return false;
 	}
+	coalesceEvents(event);
+	return true;
 }
 
 bool
 CEventQueue::dispatchEvent(const CEvent& event)
 {
-	void* target   = event.getTarget();
-	IEventJob* job = getHandler(event.getType(), target);
+	// look up the handler without locking.  it won't be deleted until
+	// we're done with it, even if it's removed while it runs.
+	void* target = event.getTarget();
+	startReading();
+	IEventJob* job = findHandler(event.getType(), target);
 	if (job == NULL) {
-		job = getHandler(CEvent::kUnknown, target);
+		job = findHandler(CEvent::kUnknown, target);
 	}
-	if (job != NULL) {
+	if (job == NULL) {
+		doneReading();
+		return false;
+	}
+
+	CArchAtomic::add(m_dispatching, 1);
+	try {
 		job->run(event);
-		return true;
 	}
-	return false;
+	catch (...) {
+		CArchAtomic::add(m_dispatching, static_cast<UInt32>(-1));
+		doneReading();
+		throw;
+	}
+
+	// send flushes once the outermost dispatch is done.  see addFlush()
+	// for why this can't miss one.
+	const bool flush =
+		(CArchAtomic::add(m_dispatching, static_cast<UInt32>(-1)) == 0 &&
+		CArchAtomic::load(m_flushesPending) != 0);
+	doneReading();
+	if (flush) {
+		dispatchFlushes();
+	}
+	return true;
 }
 
 void
@@ -201,6 +289,7 @@ CEventQueue::addEvent(const CEvent& event)
 	case CEvent::kUnknown:
 	case CEvent::kSystem:
 	case CEvent::kTimer:
+	case CEvent::kFlush:
 		return;
 
 	default:
@@ -212,89 +301,96 @@ CEventQueue::addEvent(const CEvent& event)
 		CEvent::deleteData(event);
 	}
 	else {
-		CArchMutexLock lock(m_mutex);
-		
-		// store the event's data locally
-		UInt32 eventID = saveEvent(event);
-		
-		// add it
-		if (!m_buffer->addEvent(eventID)) {
-			// failed to send event
-			removeEvent(eventID);
-			CEvent::deleteData(event);
+		// post without locking unless adoptBuffer() is replacing the
+		// buffer, in which case wait for it to finish
+		CArchAtomic::add(m_posting, 1);
+		if (CArchAtomic::load(m_adopting) == 0) {
+			postEvent(event);
+			CArchAtomic::add(m_posting, static_cast<UInt32>(-1));
 		}
+		else {
+			CArchAtomic::add(m_posting, static_cast<UInt32>(-1));
+			CArchMutexLock lock(m_adoptMutex);
+			postEvent(event);
+		}
+	}
+}
+
+bool
+CEventQueue::addFlush(void* target)
+{
+	// say a flush is pending before checking for a dispatch.  the
+	// outermost dispatch finishes before checking for pending flushes
+	// so either we see it hasn't finished or it sees our flush.
+	CArchMutexLock lock(m_mutex);
+	CArchAtomic::add(m_flushesPending, 1);
+	if (CArchAtomic::load(m_dispatching) == 0) {
+		CArchAtomic::add(m_flushesPending, static_cast<UInt32>(-1));
+		return false;
 	}
+	m_flushes.push_back(target);
+	return true;
 }
 
 CEventQueueTimer*
 CEventQueue::newTimer(double duration, void* target)
 {
-	assert(duration > 0.0);
-
-	CEventQueueTimer* timer = m_buffer->newTimer(duration, false);
-	if (target == NULL) {
-		target = timer;
-	}
-	CArchMutexLock lock(m_mutex);
-	m_timers.insert(timer);
-	// initial duration is requested duration plus whatever's on
-	// the clock currently because the latter will be subtracted
-	// the next time we check for timers.
-	m_timerQueue.push(CTimer(timer, duration,
-							duration + m_time.getTime(), target, false));
-	return timer;
+	return addTimer(duration, target, false);
 }
 
 CEventQueueTimer*
 CEventQueue::newOneShotTimer(double duration, void* target)
 {
-	assert(duration > 0.0);
-
-	CEventQueueTimer* timer = m_buffer->newTimer(duration, true);
-	if (target == NULL) {
-		target = timer;
-	}
-	CArchMutexLock lock(m_mutex);
-	m_timers.insert(timer);
-	// initial duration is requested duration plus whatever's on
-	// the clock currently because the latter will be subtracted
-	// the next time we check for timers.
-	m_timerQueue.push(CTimer(timer, duration,
-							duration + m_time.getTime(), target, true));
-	return timer;
+	return addTimer(duration, target, true);
 }
 
 void
 CEventQueue::deleteTimer(CEventQueueTimer* timer)
 {
 	CArchMutexLock lock(m_mutex);
-	for (CTimerQueue::iterator index = m_timerQueue.begin();
-							index != m_timerQueue.end(); ++index) {
-		if (index->getTimer() == timer) {
-			m_timerQueue.erase(index);
-			break;
-		}
-	}
 	CTimers::iterator index = m_timers.find(timer);
 	if (index != m_timers.end()) {
+		eraseTimer(index->second);
+		delete index->second;
 		m_timers.erase(index);
 	}
 	m_buffer->deleteTimer(timer);
 }
 
 void
-CEventQueue::adoptHandler(CEvent::Type type, void* target, IEventJob* handler)
+CEventQueue::resetTimer(CEventQueueTimer* timer)
 {
 	CArchMutexLock lock(m_mutex);
-	IEventJob*& job = m_handlers[target][type];
-	delete job;
-	job = handler;
+	CTimers::iterator index = m_timers.find(timer);
+	if (index != m_timers.end()) {
+		CTimer* t = index->second;
+		t->reset(m_time.getTime());
+		if (t->getIndex() == static_cast<size_t>(-1)) {
+			// expired one-shot
+			pushTimer(t);
+		}
+		else {
+			updateTimer(t);
+		}
+	}
+}
+
+void
+CEventQueue::adoptHandler(CEvent::Type type, void* target, IEventJob* handler)
+{
+	{
+		CArchMutexLock lock(m_mutex);
+		IEventJob*& job = m_handlers[target][type];
+		retireHandler(job);
+		job = handler;
+		setHashedHandler(type, target, handler);
+	}
+	reclaim();
 }
 
 void
 CEventQueue::removeHandler(CEvent::Type type, void* target)
 {
-	IEventJob* handler = NULL;
 	{
 		CArchMutexLock lock(m_mutex);
 		CHandlerTable::iterator index = m_handlers.find(target);
@@ -302,43 +398,42 @@ CEventQueue::removeHandler(CEvent::Type type, void* target)
 			CTypeHandlerTable& typeHandlers = index->second;
 			CTypeHandlerTable::iterator index2 = typeHandlers.find(type);
 			if (index2 != typeHandlers.end()) {
-				handler = index2->second;
+				retireHandler(index2->second);
 				typeHandlers.erase(index2);
+				setHashedHandler(type, target, NULL);
+				if (typeHandlers.empty()) {
+					m_handlers.erase(index);
+				}
 			}
 		}
 	}
-	delete handler;
+	reclaim();
 }
 
 void
 CEventQueue::removeHandlers(void* target)
 {
-	std::vector<IEventJob*> handlers;
 	{
 		CArchMutexLock lock(m_mutex);
 		CHandlerTable::iterator index = m_handlers.find(target);
 		if (index != m_handlers.end()) {
-			// copy to handlers array and clear table for target
 			CTypeHandlerTable& typeHandlers = index->second;
 			for (CTypeHandlerTable::iterator index2 = typeHandlers.begin();
 							index2 != typeHandlers.end(); ++index2) {
-				handlers.push_back(index2->second);
+				retireHandler(index2->second);
+				setHashedHandler(index2->first, target, NULL);
 			}
-			typeHandlers.clear();
+			m_handlers.erase(index);
 		}
 	}
-
-	// delete handlers
-	for (std::vector<IEventJob*>::iterator index = handlers.begin();
-							index != handlers.end(); ++index) {
-		delete *index;
-	}
+	reclaim();
 }
 
 bool
 CEventQueue::isEmpty() const
 {
-	return (m_buffer->isEmpty() && getNextTimerTimeout() != 0.0);
+	return (!m_hasPending && m_buffer->isEmpty() &&
+							getNextTimerTimeout() != 0.0);
 }
 
 IEventJob*
@@ -356,11 +451,117 @@ CEventQueue::getHandler(CEvent::Type type, void* target) const
 	return NULL;
 }
 
+void
+CEventQueue::setCoalescer(CEvent::Type type,
+				CoalesceFunc func, void* userData)
+{
+	CArchMutexLock lock(m_mutex);
+	if (func == NULL) {
+		m_coalescers.erase(type);
+	}
+	else {
+		CCoalescer& coalescer = m_coalescers[type];
+		coalescer.m_func      = func;
+		coalescer.m_userData  = userData;
+	}
+}
+
+void
+CEventQueue::getCoalesceCounts(UInt32& taken, UInt32& coalesced) const
+{
+	taken     = m_numTaken;
+	coalesced = m_numCoalesced;
+}
+
+void
+CEventQueue::postEvent(const CEvent& event)
+{
+	// store the event's data locally
+	UInt32 eventID = saveEvent(event);
+
+	// add it
+	if (!m_buffer->addEvent(eventID)) {
+		// failed to send event
+		removeEvent(eventID);
+		CEvent::deleteData(event);
+	}
+}
+
+bool
+CEventQueue::readEvent(CEvent& event)
+{
+	UInt32 dataID;
+	IEventQueueBuffer::Type type = m_buffer->getEvent(event, dataID);
+	switch (type) {
+	case IEventQueueBuffer::kNone:
+		return false;
+
+	case IEventQueueBuffer::kSystem:
+		++m_numTaken;
+		return true;
+
+	case IEventQueueBuffer::kUser:
+		++m_numTaken;
+		event = removeEvent(dataID);
+		return true;
+
+	default:
+		assert(0 && "invalid event type");
+		return false;
+	}
+}
+
+void
+CEventQueue::coalesceEvents(CEvent& event)
+{
+	// there's nothing to merge unless another event is waiting
+	if (m_buffer->isEmpty()) {
+		return;
+	}
+	CCoalescer coalescer;
+	{
+		CArchMutexLock lock(m_mutex);
+		CCoalescerTable::const_iterator index =
+							m_coalescers.find(event.getType());
+		if (index == m_coalescers.end()) {
+			return;
+		}
+		coalescer = index->second;
+	}
+
+	// merge waiting events until one doesn't match or the coalescer
+	// won't merge it.  keep that one for the next call to getEvent().
+	// a system event's data may belong to the buffer but the buffer
+	// isn't read again before it's used.
+	UInt32 n = 0;
+	while (!m_buffer->isEmpty() && readEvent(m_pending)) {
+		if (m_pending.getType()   != event.getType() ||
+			m_pending.getTarget() != event.getTarget() ||
+			!coalescer.m_func(event, m_pending, coalescer.m_userData)) {
+			m_hasPending = true;
+			break;
+		}
+		CEvent::deleteData(m_pending);
+		++n;
+	}
+	if (n > 0) {
+		m_numCoalesced += n;
+		LOG((CLOG_DEBUG2 "coalesced %u %s events into one, %u of %u events so far", n + 1, getTypeName(event.getType()), m_numCoalesced, m_numTaken));
+	}
+}
+
 UInt32
 CEventQueue::saveEvent(const CEvent& event)
 {
-	// choose id
+	// use a free slot if there is one
 	UInt32 id;
+	if (m_freeEventSlots.pop(id)) {
+		m_eventSlots[id] = event;
+		return id;
+	}
+
+	// otherwise use the table
+	CArchMutexLock lock(m_mutex);
 	if (!m_oldEventIDs.empty()) {
 		// reuse an id
 		id = m_oldEventIDs.back();
@@ -368,7 +569,7 @@ CEventQueue::saveEvent(const CEvent& event)
 	}
 	else {
 		// make a new id
-		id = static_cast<UInt32>(m_events.size());
+		id = kEventSlots + static_cast<UInt32>(m_events.size());
 	}
 
 	// save data
@@ -379,7 +580,18 @@ CEventQueue::saveEvent(const CEvent& event)
 CEvent
 CEventQueue::removeEvent(UInt32 eventID)
 {
+	// look in the slots first
+	if (eventID < kEventSlots) {
+		CEvent event = m_eventSlots[eventID];
+		if (event.getType() != CEvent::kUnknown) {
+			m_eventSlots[eventID] = CEvent();
+			m_freeEventSlots.push(eventID);
+		}
+		return event;
+	}
+
 	// look up id
+	CArchMutexLock lock(m_mutex);
 	CEventTable::iterator index = m_events.find(eventID);
 	if (index == m_events.end()) {
 		return CEvent();
@@ -395,43 +607,52 @@ CEventQueue::removeEvent(UInt32 eventID)
 	return event;
 }
 
+CEventQueueTimer*
+CEventQueue::addTimer(double duration, void* target, bool oneShot)
+{
+	assert(duration > 0.0);
+
+	CEventQueueTimer* timer = m_buffer->newTimer(duration, oneShot);
+	if (target == NULL) {
+		target = timer;
+	}
+	CArchMutexLock lock(m_mutex);
+	CTimer* t = new CTimer(timer, duration, m_time.getTime(), target, oneShot);
+	m_timers.insert(std::make_pair(timer, t));
+	pushTimer(t);
+	return timer;
+}
+
 bool
 CEventQueue::hasTimerExpired(CEvent& event)
 {
-	// return true if there's a timer in the timer priority queue that
-	// has expired.  if returning true then fill in event appropriately
-	// and reset and reinsert the timer.
+	// return true if there's a timer in the timer heap that has
+	// expired.  if returning true then fill in event appropriately
+	// and reset and reposition the timer.
+	CArchMutexLock lock(m_mutex);
 	if (m_timerQueue.empty()) {
 		return false;
 	}
 
-	// get time elapsed since last check
-	const double time = m_time.getTime();
-	m_time.reset();
-
-	// countdown elapsed time
-	for (CTimerQueue::iterator index = m_timerQueue.begin();
-							index != m_timerQueue.end(); ++index) {
-		(*index) -= time;
-	}
-
 	// done if no timers are expired
-	if (m_timerQueue.top() > 0.0) {
+	const double now = m_time.getTime();
+	CTimer* timer    = m_timerQueue.front();
+	if (timer->getDeadline() > now) {
 		return false;
 	}
 
-	// remove timer from queue
-	CTimer timer = m_timerQueue.top();
-	m_timerQueue.pop();
+	// prepare event
+	timer->fillEvent(m_timerEvent, now);
+	event = CEvent(CEvent::kTimer, timer->getTarget(), &m_timerEvent);
 
-	// prepare event and reset the timer's clock
-	timer.fillEvent(m_timerEvent);
-	event = CEvent(CEvent::kTimer, timer.getTarget(), &m_timerEvent);
-	timer.reset();
-
-	// reinsert timer into queue if it's not a one-shot
-	if (!timer.isOneShot()) {
-		m_timerQueue.push(timer);
+	// a one-shot leaves the heap but stays known until it's deleted.
+	// anything else counts down again from now.
+	if (timer->isOneShot()) {
+		eraseTimer(timer);
+	}
+	else {
+		timer->reset(now);
+		siftDown(0);
 	}
 
 	return true;
@@ -441,15 +662,309 @@ double
 CEventQueue::getNextTimerTimeout() const
 {
 	// return -1 if no timers, 0 if the top timer has expired, otherwise
-	// the time until the top timer in the timer priority queue will
-	// expire.
+	// the time until the top timer in the timer heap will expire.
+	CArchMutexLock lock(m_mutex);
 	if (m_timerQueue.empty()) {
 		return -1.0;
 	}
-	if (m_timerQueue.top() <= 0.0) {
+	const double timeLeft = m_timerQueue.front()->getDeadline() -
+							m_time.getTime();
+	if (timeLeft <= 0.0) {
 		return 0.0;
 	}
-	return m_timerQueue.top();
+	return timeLeft;
+}
+
+void
+CEventQueue::pushTimer(CTimer* timer)
+{
+	timer->setIndex(m_timerQueue.size());
+	m_timerQueue.push_back(timer);
+	siftUp(timer->getIndex());
+}
+
+void
+CEventQueue::eraseTimer(CTimer* timer)
+{
+	// nothing to do if not in the heap
+	const size_t index = timer->getIndex();
+	if (index == static_cast<size_t>(-1)) {
+		return;
+	}
+	timer->setIndex(static_cast<size_t>(-1));
+
+	// move the last timer into the hole and restore the heap
+	CTimer* last = m_timerQueue.back();
+	m_timerQueue.pop_back();
+	if (last != timer) {
+		m_timerQueue[index] = last;
+		last->setIndex(index);
+		updateTimer(last);
+	}
+}
+
+void
+CEventQueue::updateTimer(CTimer* timer)
+{
+	// the deadline may have moved either way
+	siftUp(timer->getIndex());
+	siftDown(timer->getIndex());
+}
+
+void
+CEventQueue::siftUp(size_t index)
+{
+	CTimer* timer = m_timerQueue[index];
+	while (index > 0) {
+		const size_t parent = (index - 1) >> 1;
+		if (!(*timer < *m_timerQueue[parent])) {
+			break;
+		}
+		m_timerQueue[index] = m_timerQueue[parent];
+		m_timerQueue[index]->setIndex(index);
+		index = parent;
+	}
+	m_timerQueue[index] = timer;
+	timer->setIndex(index);
+}
+
+void
+CEventQueue::siftDown(size_t index)
+{
+	const size_t n = m_timerQueue.size();
+	CTimer* timer  = m_timerQueue[index];
+	for (;;) {
+		size_t child = (index << 1) + 1;
+		if (child >= n) {
+			break;
+		}
+		if (child + 1 < n && *m_timerQueue[child + 1] < *m_timerQueue[child]) {
+			++child;
+		}
+		if (!(*m_timerQueue[child] < *timer)) {
+			break;
+		}
+		m_timerQueue[index] = m_timerQueue[child];
+		m_timerQueue[index]->setIndex(index);
+		index = child;
+	}
+	m_timerQueue[index] = timer;
+	timer->setIndex(index);
+}
+
+void
+CEventQueue::dispatchFlushes()
+{
+	// flush handlers may write and request more flushes so keep
+	// going until there are none
+	CFlushList flushes;
+	for (;;) {
+		{
+			CArchMutexLock lock(m_mutex);
+			if (m_flushes.empty()) {
+				return;
+			}
+			flushes.swap(m_flushes);
+			CArchAtomic::add(m_flushesPending,
+							static_cast<UInt32>(0 - flushes.size()));
+		}
+
+		// use only the flush handler, not a catch-all handler.  the
+		// target may have gone away since asking for the flush.
+		startReading();
+		try {
+			for (CFlushList::iterator i = flushes.begin();
+								i != flushes.end(); ++i) {
+				IEventJob* job = findHandler(CEvent::kFlush, *i);
+				if (job != NULL) {
+					job->run(CEvent(CEvent::kFlush, *i));
+				}
+			}
+		}
+		catch (...) {
+			doneReading();
+			throw;
+		}
+		doneReading();
+		flushes.clear();
+	}
+}
+
+void
+CEventQueue::startReading()
+{
+	CArchAtomic::add(m_readers, 1);
+}
+
+void
+CEventQueue::doneReading()
+{
+	if (CArchAtomic::add(m_readers, static_cast<UInt32>(-1)) == 0) {
+		reclaim();
+	}
+}
+
+IEventJob*
+CEventQueue::findHandler(CEvent::Type type, void* target) const
+{
+	// the table is never more than half full so there's always an
+	// unused entry to stop at
+	const CHandlerHash* hash = CArchAtomic::loadPointer(m_handlerHash);
+	for (UInt32 i = hashHandler(type, target); ; ++i) {
+		const CHandlerEntry& entry = hash->m_entries[i & hash->m_mask];
+		if (CArchAtomic::load(entry.m_used) == 0) {
+			return NULL;
+		}
+		if (entry.m_target == target && entry.m_type == type) {
+			return CArchAtomic::loadPointer(entry.m_job);
+		}
+	}
+}
+
+void
+CEventQueue::setHashedHandler(CEvent::Type type,
+				void* target, IEventJob* handler)
+{
+	// replace the job if the key's already in the table
+	CHandlerHash* hash = m_handlerHash;
+	UInt32 i = hashHandler(type, target);
+	for (;; ++i) {
+		CHandlerEntry& entry = hash->m_entries[i & hash->m_mask];
+		if (entry.m_used == 0) {
+			break;
+		}
+		if (entry.m_target == target && entry.m_type == type) {
+			CArchAtomic::storePointer(entry.m_job, handler);
+			return;
+		}
+	}
+	if (handler == NULL) {
+		return;
+	}
+
+	// if the table's full then rebuild it from m_handlers, which
+	// already has the new handler
+	if (2 * (hash->m_used + 1) > hash->m_mask + 1) {
+		rebuildHandlerHash();
+		return;
+	}
+
+	// fill in the unused entry and then publish it
+	CHandlerEntry& entry = hash->m_entries[i & hash->m_mask];
+	entry.m_type   = type;
+	entry.m_target = target;
+	entry.m_job    = handler;
+	++hash->m_used;
+	CArchAtomic::store(entry.m_used, 1);
+}
+
+void
+CEventQueue::rebuildHandlerHash()
+{
+	// size the table to be at most a quarter full
+	UInt32 n = 0;
+	for (CHandlerTable::const_iterator index = m_handlers.begin();
+							index != m_handlers.end(); ++index) {
+		n += static_cast<UInt32>(index->second.size());
+	}
+	UInt32 size = 16;
+	while (size < 4 * n) {
+		size <<= 1;
+	}
+
+	// fill in the new table.  nobody can see it yet.
+	CHandlerHash* hash = new CHandlerHash(size);
+	for (CHandlerTable::const_iterator index = m_handlers.begin();
+							index != m_handlers.end(); ++index) {
+		void* target = index->first;
+		const CTypeHandlerTable& typeHandlers = index->second;
+		for (CTypeHandlerTable::const_iterator index2 = typeHandlers.begin();
+							index2 != typeHandlers.end(); ++index2) {
+			UInt32 i = hashHandler(index2->first, target);
+			while (hash->m_entries[i & hash->m_mask].m_used != 0) {
+				++i;
+			}
+			CHandlerEntry& entry = hash->m_entries[i & hash->m_mask];
+			entry.m_used   = 1;
+			entry.m_type   = index2->first;
+			entry.m_target = target;
+			entry.m_job    = index2->second;
+		}
+	}
+	hash->m_used = n;
+
+	// publish it and retire the old one
+	CHandlerHash* oldHash = m_handlerHash;
+	CArchAtomic::storePointer(m_handlerHash, hash);
+	if (oldHash != NULL) {
+		m_retiredHashes.push_back(oldHash);
+		CArchAtomic::add(m_numRetired, 1);
+	}
+}
+
+void
+CEventQueue::retireHandler(IEventJob* handler)
+{
+	if (handler != NULL) {
+		m_retiredHandlers.push_back(handler);
+		CArchAtomic::add(m_numRetired, 1);
+	}
+}
+
+void
+CEventQueue::reclaim()
+{
+	if (CArchAtomic::load(m_numRetired) == 0) {
+		return;
+	}
+
+	// the retired handlers and tables were unhooked before they were
+	// retired.  if nobody's reading now then nobody can still have
+	// them.  the add is just a read with a full memory barrier.
+	CRetiredHandlers handlers;
+	CRetiredHashes hashes;
+	{
+		CArchMutexLock lock(m_mutex);
+		if (CArchAtomic::add(m_readers, 0) != 0) {
+			return;
+		}
+		handlers.swap(m_retiredHandlers);
+		hashes.swap(m_retiredHashes);
+		CArchAtomic::store(m_numRetired, 0);
+	}
+
+	// delete them
+	for (CRetiredHandlers::iterator i = handlers.begin();
+							i != handlers.end(); ++i) {
+		delete *i;
+	}
+	for (CRetiredHashes::iterator i = hashes.begin();
+							i != hashes.end(); ++i) {
+		delete *i;
+	}
+}
+
+
+//
+// CEventQueue::CHandlerHash
+//
+
+CEventQueue::CHandlerHash::CHandlerHash(UInt32 size) :
+	m_mask(size - 1),
+	m_used(0),
+	m_entries(new CHandlerEntry[size])
+{
+	for (UInt32 i = 0; i < size; ++i) {
+		m_entries[i].m_used   = 0;
+		m_entries[i].m_type   = CEvent::kUnknown;
+		m_entries[i].m_target = NULL;
+		m_entries[i].m_job    = NULL;
+	}
+}
+
+CEventQueue::CHandlerHash::~CHandlerHash()
+{
+	delete[] m_entries;
 }
 
 
@@ -458,12 +973,13 @@ CEventQueue::getNextTimerTimeout() const
 //
 
 CEventQueue::CTimer::CTimer(CEventQueueTimer* timer, double timeout,
-				double initialTime, void* target, bool oneShot) :
+				double now, void* target, bool oneShot) :
 	m_timer(timer),
 	m_timeout(timeout),
 	m_target(target),
 	m_oneShot(oneShot),
-	m_time(initialTime)
+	m_deadline(now + timeout),
+	m_index(static_cast<size_t>(-1))
 {
 	assert(m_timeout > 0.0);
 }
@@ -474,21 +990,15 @@ CEventQueue::CTimer::~CTimer()
 }
 
 void
-CEventQueue::CTimer::reset()
-{
-	m_time = m_timeout;
-}
-
-CEventQueue::CTimer&
-CEventQueue::CTimer::operator-=(double dt)
+CEventQueue::CTimer::reset(double now)
 {
-	m_time -= dt;
-	return *this;
+	m_deadline = now + m_timeout;
 }
 
-CEventQueue::CTimer::operator double() const
+void
+CEventQueue::CTimer::setIndex(size_t index)
 {
-	return m_time;
+	m_index = index;
 }
 
 bool
@@ -509,18 +1019,31 @@ CEventQueue::CTimer::getTarget() const
 	return m_target;
 }
 
+double
+CEventQueue::CTimer::getDeadline() const
+{
+	return m_deadline;
+}
+
+size_t
+CEventQueue::CTimer::getIndex() const
+{
+	return m_index;
+}
+
 void
-CEventQueue::CTimer::fillEvent(CTimerEvent& event) const
+CEventQueue::CTimer::fillEvent(CTimerEvent& event, double now) const
 {
 	event.m_timer = m_timer;
 	event.m_count = 0;
-	if (m_time <= 0.0) {
-		event.m_count = static_cast<UInt32>((m_timeout - m_time) / m_timeout);
+	if (m_deadline <= now) {
+		event.m_count = static_cast<UInt32>(
+							(m_timeout + now - m_deadline) / m_timeout);
 	}
 }
 
 bool
 CEventQueue::CTimer::operator<(const CTimer& t) const
 {
-	return m_time < t.m_time;
+	return m_deadline < t.m_deadline;
 }
@@ -17,11 +17,12 @@
 
 #include "IEventQueue.h"
 #include "CEvent.h"
-#include "CPriorityQueue.h"
+#include "CLockFreeQueue.h"
 #include "CStopwatch.h"
 #include "IArchMultithread.h"
 #include "stdmap.h"
-#include "stdset.h"
+#include "stdvector.h"
+#include <algorithm>
 
 //! Event queue
 /*!
@@ -38,47 +39,74 @@ public:
 	virtual bool		getEvent(CEvent& event, double timeout = -1.0);
 	virtual bool		dispatchEvent(const CEvent& event);
 	virtual void		addEvent(const CEvent& event);
+	virtual bool		addFlush(void* target);
 	virtual CEventQueueTimer*
 						newTimer(double duration, void* target);
 	virtual CEventQueueTimer*
 						newOneShotTimer(double duration, void* target);
 	virtual void		deleteTimer(CEventQueueTimer*);
+	virtual void		resetTimer(CEventQueueTimer*);
 	virtual void		adoptHandler(CEvent::Type type,
 							void* target, IEventJob* handler);
 	virtual void		removeHandler(CEvent::Type type, void* target);
 	virtual void		removeHandlers(void* target);
+	virtual void		setCoalescer(CEvent::Type type,
+							CoalesceFunc func, void* userData);
 	virtual CEvent::Type
 						registerType(const char* name);
 	virtual CEvent::Type
 						registerTypeOnce(CEvent::Type& type, const char* name);
 	virtual bool		isEmpty() const;
 	virtual IEventJob*	getHandler(CEvent::Type type, void* target) const;
+	virtual void		getCoalesceCounts(UInt32& taken,
+							UInt32& coalesced) const;
 	virtual const char*	getTypeName(CEvent::Type type);
 
 private:
+	void				postEvent(const CEvent& event);
+	bool				readEvent(CEvent& event);
+	void				coalesceEvents(CEvent& event);
 	UInt32				saveEvent(const CEvent& event);
 	CEvent				removeEvent(UInt32 eventID);
+	CEventQueueTimer*	addTimer(double duration, void* target, bool oneShot);
 	bool				hasTimerExpired(CEvent& event);
 	double				getNextTimerTimeout() const;
+	void				dispatchFlushes();
+
+	// handler lookup for dispatching.  call startReading() before
+	// findHandler() and doneReading() when done with the handler.
+	void				startReading();
+	void				doneReading();
+	IEventJob*			findHandler(CEvent::Type type, void* target) const;
+
+	// handler table changes.  call with m_mutex locked, then call
+	// reclaim() once it's unlocked.
+	void				setHashedHandler(CEvent::Type type,
+							void* target, IEventJob* handler);
+	void				rebuildHandlerHash();
+	void				retireHandler(IEventJob*);
+	void				reclaim();
 
 private:
 	class CTimer {
 	public:
-		CTimer(CEventQueueTimer*, double timeout, double initialTime,
+		CTimer(CEventQueueTimer*, double timeout, double now,
 							void* target, bool oneShot);
 		~CTimer();
 
-		void			reset();
-
-		CTimer&			operator-=(double);
+		//! Restart the countdown from \p now
+		void			reset(double now);
 
-						operator double() const;
+		//! Set the timer's index in the timer heap
+		void			setIndex(size_t);
 
 		bool			isOneShot() const;
 		CEventQueueTimer*
 						getTimer() const;
 		void*			getTarget() const;
-		void			fillEvent(CTimerEvent&) const;
+		double			getDeadline() const;
+		size_t			getIndex() const;
+		void			fillEvent(CTimerEvent&, double now) const;
 
 		bool			operator<(const CTimer&) const;
 
@@ -87,15 +115,54 @@ private:
 		double				m_timeout;
 		void*				m_target;
 		bool				m_oneShot;
-		double				m_time;
+		double				m_deadline;
+		size_t				m_index;
 	};
-	typedef std::set<CEventQueueTimer*> CTimers;
-	typedef CPriorityQueue<CTimer> CTimerQueue;
+	typedef std::map<CEventQueueTimer*, CTimer*> CTimers;
+	typedef std::vector<CTimer*> CTimerQueue;
+	enum { kEventSlots = 4096 };
+	typedef std::vector<CEvent> CEventSlots;
 	typedef std::map<UInt32, CEvent> CEventTable;
 	typedef std::vector<UInt32> CEventIDList;
 	typedef std::map<CEvent::Type, const char*> CTypeMap;
 	typedef std::map<CEvent::Type, IEventJob*> CTypeHandlerTable;
 	typedef std::map<void*, CTypeHandlerTable> CHandlerTable;
+	typedef std::vector<void*> CFlushList;
+	class CCoalescer {
+	public:
+		CoalesceFunc	m_func;
+		void*			m_userData;
+	};
+	typedef std::map<CEvent::Type, CCoalescer> CCoalescerTable;
+
+	// an entry's key is set before m_used and never changes after.
+	// removing a handler just clears m_job.
+	struct CHandlerEntry {
+	public:
+		volatile UInt32	m_used;
+		CEvent::Type	m_type;
+		void*			m_target;
+		IEventJob* volatile	m_job;
+	};
+	struct CHandlerHash {
+	public:
+		CHandlerHash(UInt32 size);
+		~CHandlerHash();
+
+	public:
+		UInt32			m_mask;
+		UInt32			m_used;
+		CHandlerEntry*	m_entries;
+	};
+	typedef std::vector<IEventJob*> CRetiredHandlers;
+	typedef std::vector<CHandlerHash*> CRetiredHashes;
+
+	// timer heap operations.  all are O(log n).
+	void				pushTimer(CTimer*);
+	void				eraseTimer(CTimer*);
+	void				updateTimer(CTimer*);
+	void				siftUp(size_t index);
+	void				siftDown(size_t index);
 
 	CArchMutex			m_mutex;
 
@@ -106,18 +173,60 @@ private:
 	// buffer of events
 	IEventQueueBuffer*	m_buffer;
 
-	// saved events
+	// saved events.  an event's id is its index in m_eventSlots and
+	// the free indices are in m_freeEventSlots so saving and removing
+	// an event doesn't lock.  if every slot is taken then events go in
+	// m_events, under m_mutex, with ids from kEventSlots up.
+	CEventSlots			m_eventSlots;
+	CLockFreeQueue		m_freeEventSlots;
 	CEventTable			m_events;
 	CEventIDList		m_oldEventIDs;
 
-	// timers
+	// posting events.  m_posting counts the threads in addEvent() and
+	// m_adopting is non-zero while adoptBuffer() replaces the buffer.
+	// posting takes m_adoptMutex only while that's happening.
+	CArchMutex			m_adoptMutex;
+	volatile UInt32		m_posting;
+	volatile UInt32		m_adopting;
+
+	// timers.  every timer is in m_timers and each one that hasn't
+	// expired is also in m_timerQueue, a binary heap ordered by
+	// deadline in which each timer knows its own index.  deadlines are
+	// absolute times on m_time, which is never reset.
 	CStopwatch			m_time;
 	CTimers				m_timers;
 	CTimerQueue			m_timerQueue;
 	CTimerEvent			m_timerEvent;
 
-	// event handlers
+	// event handlers.  m_handlers is the master copy, changed and read
+	// under m_mutex.  m_handlerHash holds the same handlers in an open
+	// addressed hash table that dispatching reads without locking.
+	// it's only changed under m_mutex and is rebuilt without removed
+	// entries when it fills up.  replaced handlers and tables are kept
+	// until no thread is between startReading() and doneReading().
 	CHandlerTable		m_handlers;
+	CHandlerHash* volatile	m_handlerHash;
+	volatile UInt32		m_readers;
+	volatile UInt32		m_numRetired;
+	CRetiredHandlers	m_retiredHandlers;
+	CRetiredHashes		m_retiredHashes;
+
+	// flush requests.  m_dispatching is the total depth of nested
+	// dispatches on all threads.  m_flushesPending is non-zero while
+	// m_flushes may be non-empty.
+	volatile UInt32		m_dispatching;
+	volatile UInt32		m_flushesPending;
+	CFlushList			m_flushes;
+
+	// coalescing.  m_coalescers is changed and read under m_mutex.
+	// getEvent() only looks in it when another event is already
+	// waiting.  m_pending is an event read while coalescing that
+	// didn't belong to the run;  getEvent() returns it next.
+	CCoalescerTable		m_coalescers;
+	CEvent				m_pending;
+	bool				m_hasPending;
+	UInt32				m_numTaken;
+	UInt32				m_numCoalesced;
 };
 
 #endif
@@ -0,0 +1,113 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CLockFreeQueue.h"
+#include "CArchAtomic.h"
+
+//
+// CLockFreeQueue
+//
+
+CLockFreeQueue::CLockFreeQueue(UInt32 capacity) :
+	m_head(0),
+	m_tail(0)
+{
+	UInt32 n = 2;
+	while (n < capacity) {
+		n <<= 1;
+	}
+	m_mask  = n - 1;
+	m_cells = new CCell[n];
+	for (UInt32 i = 0; i < n; ++i) {
+		m_cells[i].m_sequence = i;
+		m_cells[i].m_value    = 0;
+	}
+}
+
+CLockFreeQueue::~CLockFreeQueue()
+{
+	delete[] m_cells;
+}
+
+bool
+CLockFreeQueue::push(UInt32 value)
+{
+	// claim the cell at the tail.  if another producer beats us to it
+	// then try again at the new tail.
+	UInt32 pos = CArchAtomic::load(m_tail);
+	CCell* cell;
+	for (;;) {
+		cell = m_cells + (pos & m_mask);
+		const SInt32 diff = static_cast<SInt32>(
+							CArchAtomic::load(cell->m_sequence) - pos);
+		if (diff == 0) {
+			if (CArchAtomic::compareAndSwap(m_tail, pos, pos + 1)) {
+				break;
+			}
+			pos = CArchAtomic::load(m_tail);
+		}
+		else if (diff < 0) {
+			// the cell still holds a value from a lap ago
+			return false;
+		}
+		else {
+			pos = CArchAtomic::load(m_tail);
+		}
+	}
+
+	// fill the cell and publish it
+	cell->m_value = value;
+	CArchAtomic::store(cell->m_sequence, pos + 1);
+	return true;
+}
+
+bool
+CLockFreeQueue::pop(UInt32& value)
+{
+	// claim the cell at the head.  if another consumer beats us to it
+	// then try again at the new head.
+	UInt32 pos = CArchAtomic::load(m_head);
+	CCell* cell;
+	for (;;) {
+		cell = m_cells + (pos & m_mask);
+		const SInt32 diff = static_cast<SInt32>(
+							CArchAtomic::load(cell->m_sequence) - (pos + 1));
+		if (diff == 0) {
+			if (CArchAtomic::compareAndSwap(m_head, pos, pos + 1)) {
+				break;
+			}
+			pos = CArchAtomic::load(m_head);
+		}
+		else if (diff < 0) {
+			// nothing pushed here yet
+			return false;
+		}
+		else {
+			pos = CArchAtomic::load(m_head);
+		}
+	}
+
+	// take the value and free the cell for the next lap
+	value = cell->m_value;
+	CArchAtomic::store(cell->m_sequence, pos + m_mask + 1);
+	return true;
+}
+
+bool
+CLockFreeQueue::isEmpty() const
+{
+	const UInt32 pos  = CArchAtomic::load(m_head);
+	const CCell* cell = m_cells + (pos & m_mask);
+	return (CArchAtomic::load(cell->m_sequence) != pos + 1);
+}
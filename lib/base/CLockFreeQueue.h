@@ -0,0 +1,93 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CLOCKFREEQUEUE_H
+#define CLOCKFREEQUEUE_H
+
+#include "BasicTypes.h"
+
+//! Bounded lock-free queue
+/*!
+A fixed size FIFO of 32-bit values that any number of threads may push
+to and pop from concurrently without locking.  Pushing to a full queue
+and popping from an empty one fail rather than block.
+*/
+class CLockFreeQueue {
+public:
+	//! Create a queue
+	/*!
+	Creates a queue with room for at least \p capacity values.  The
+	capacity is rounded up to a power of two.
+	*/
+	CLockFreeQueue(UInt32 capacity);
+	~CLockFreeQueue();
+
+	//! @name manipulators
+	//@{
+
+	//! Add a value
+	/*!
+	Adds \p value to the end of the queue.  Returns false if the queue
+	is full.
+	*/
+	bool				push(UInt32 value);
+
+	//! Remove a value
+	/*!
+	Removes the value at the front of the queue and returns it in
+	\p value.  Returns false if the queue is empty.
+	*/
+	bool				pop(UInt32& value);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if empty
+	/*!
+	Returns true iff the queue is empty.  If other threads are using
+	the queue then the result may be out of date by the time it's
+	returned.
+	*/
+	bool				isEmpty() const;
+
+	//@}
+
+private:
+	// not implemented
+	CLockFreeQueue(const CLockFreeQueue&);
+	CLockFreeQueue&		operator=(const CLockFreeQueue&);
+
+private:
+	// a cell's sequence number says whose turn it is.  it equals the
+	// push position when the cell is free to push into and the push
+	// position plus one when it holds a value to pop.
+	struct CCell {
+		volatile UInt32	m_sequence;
+		UInt32			m_value;
+	};
+
+	CCell*				m_cells;
+	UInt32				m_mask;
+
+	// keep the ends on separate cache lines so producers and the
+	// consumer don't fight over them
+	char				m_pad1[64];
+	volatile UInt32		m_head;
+	char				m_pad2[64];
+	volatile UInt32		m_tail;
+	char				m_pad3[64];
+};
+
+#endif
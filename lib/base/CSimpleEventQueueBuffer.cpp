@@ -15,6 +15,7 @@
 #include "CSimpleEventQueueBuffer.h"
 #include "CStopwatch.h"
 #include "CArch.h"
+#include "CArchAtomic.h"
 
 class CEventQueueTimer { };
 
@@ -22,11 +23,13 @@ class CEventQueueTimer { };
 // CSimpleEventQueueBuffer
 //
 
-CSimpleEventQueueBuffer::CSimpleEventQueueBuffer()
+CSimpleEventQueueBuffer::CSimpleEventQueueBuffer() :
+	m_queue(kQueueSize),
+	m_overflowing(0),
+	m_waiting(0)
 {
 	m_queueMutex     = ARCH->newMutex();
 	m_queueReadyCond = ARCH->newCondVar();
-	m_queueReady     = false;
 }
 
 CSimpleEventQueueBuffer::~CSimpleEventQueueBuffer()
@@ -38,40 +41,65 @@ CSimpleEventQueueBuffer::~CSimpleEventQueueBuffer()
 void
 CSimpleEventQueueBuffer::waitForEvent(double timeout)
 {
+	if (!isEmpty()) {
+		return;
+	}
+
+	// say we're waiting before checking for events again.  addEvent()
+	// adds its event before checking if we're waiting so either we'll
+	// see the event or it'll see us waiting and wake us.
 	CArchMutexLock lock(m_queueMutex);
+	CArchAtomic::add(m_waiting, 1);
 	CStopwatch timer(true);
-	while (!m_queueReady) {
+	while (isEmpty()) {
 		double timeLeft = timeout;
 		if (timeLeft >= 0.0) {
 			timeLeft -= timer.getTime();
 			if (timeLeft < 0.0) {
-				return;
+				break;
 			}
 		}
 		ARCH->waitCondVar(m_queueReadyCond, m_queueMutex, timeLeft);
 	}
+	CArchAtomic::add(m_waiting, static_cast<UInt32>(-1));
 }
 
 IEventQueueBuffer::Type
 CSimpleEventQueueBuffer::getEvent(CEvent&, UInt32& dataID)
 {
-	CArchMutexLock lock(m_queueMutex);
-	if (!m_queueReady) {
-		return kNone;
+	if (m_queue.pop(dataID)) {
+		return kUser;
 	}
-	dataID = m_queue.back();
-	m_queue.pop_back();
-	m_queueReady = !m_queue.empty();
-	return kUser;
+
+	// anything in the overflow was added after everything in m_queue
+	if (CArchAtomic::load(m_overflowing) != 0) {
+		CArchMutexLock lock(m_queueMutex);
+		if (!m_overflow.empty()) {
+			dataID = m_overflow.front();
+			m_overflow.pop_front();
+			if (m_overflow.empty()) {
+				CArchAtomic::store(m_overflowing, 0);
+			}
+			return kUser;
+		}
+	}
+	return kNone;
 }
 
 bool
 CSimpleEventQueueBuffer::addEvent(UInt32 dataID)
 {
-	CArchMutexLock lock(m_queueMutex);
-	m_queue.push_front(dataID);
-	if (!m_queueReady) {
-		m_queueReady = true;
+	if (CArchAtomic::load(m_overflowing) != 0 || !m_queue.push(dataID)) {
+		CArchMutexLock lock(m_queueMutex);
+		m_overflow.push_back(dataID);
+		CArchAtomic::store(m_overflowing, 1);
+	}
+
+	// wake the reader if it's waiting.  the add is just a read with a
+	// full memory barrier so the read can't happen before the event
+	// was added.
+	if (CArchAtomic::add(m_waiting, 0) != 0) {
+		CArchMutexLock lock(m_queueMutex);
 		ARCH->broadcastCondVar(m_queueReadyCond);
 	}
 	return true;
@@ -80,8 +108,7 @@ CSimpleEventQueueBuffer::addEvent(UInt32 dataID)
 bool
 CSimpleEventQueueBuffer::isEmpty() const
 {
-	CArchMutexLock lock(m_queueMutex);
-	return !m_queueReady;
+	return (m_queue.isEmpty() && CArchAtomic::load(m_overflowing) == 0);
 }
 
 CEventQueueTimer*
@@ -16,12 +16,15 @@
 #define CSIMPLEEVENTQUEUEBUFFER_H
 
 #include "IEventQueueBuffer.h"
+#include "CLockFreeQueue.h"
 #include "IArchMultithread.h"
 #include "stddeque.h"
 
 //! In-memory event queue buffer
 /*!
 An event queue buffer provides a queue of events for an IEventQueue.
+Any number of threads may add events without locking but only one
+thread may get them.  That thread sleeps only when the buffer is empty.
 */
 class CSimpleEventQueueBuffer : public IEventQueueBuffer {
 public:
@@ -38,12 +41,21 @@ public:
 	virtual void		deleteTimer(CEventQueueTimer*) const;
 
 private:
+	enum { kQueueSize = 4096 };
 	typedef std::deque<UInt32> CEventDeque;
 
+	// events normally go through the lock-free m_queue.  when that's
+	// full they go to m_overflow instead, and keep going there until
+	// the reader has emptied it, so they stay in order.
+	CLockFreeQueue		m_queue;
+	volatile UInt32		m_overflowing;
+	CEventDeque			m_overflow;
+
+	// m_queueMutex guards m_overflow and sleeping.  m_waiting is
+	// non-zero while the reader is (about to be) asleep.
 	CArchMutex			m_queueMutex;
 	CArchCond			m_queueReadyCond;
-	bool				m_queueReady;
-	CEventDeque			m_queue;
+	volatile UInt32		m_waiting;
 };
 
 #endif
@@ -42,6 +42,16 @@ public:
 		UInt32				m_count;	//!< Number of repeats
 	};
 
+	//! Coalescing function
+	/*!
+	Merges the data of \p next, the event queued right after \p event,
+	into \p event and returns true, or returns false to leave both
+	events alone.  \p userData is the pointer given to
+	\c setCoalescer().  See \c setCoalescer().
+	*/
+	typedef bool		(*CoalesceFunc)(CEvent& event, const CEvent& next,
+							void* userData);
+
 	//! @name manipulators
 	//@{
 
@@ -73,6 +83,17 @@ public:
 	*/
 	virtual void		addEvent(const CEvent& event) = 0;
 
+	//! Request a flush
+	/*!
+	If an event is being dispatched then arranges for a \c CEvent::kFlush
+	event for \p target to be dispatched once that event, and any events
+	dispatched while handling it, have been handled and returns true.
+	Otherwise it does nothing and returns false.  Each successful call
+	yields one flush event.  This lets a handler gather up the output it
+	generates while handling an event and send it all at once.
+	*/
+	virtual bool		addFlush(void* target) = 0;
+
 	//! Create a recurring timer
 	/*!
 	Creates and returns a timer.  An event is returned after \p duration
@@ -114,6 +135,16 @@ public:
 	*/
 	virtual void		deleteTimer(CEventQueueTimer*) = 0;
 
+	//! Restart a timer
+	/*!
+	Restarts the countdown of a previously created timer from its full
+	duration, as if it had just been created.  This also rearms a
+	one-shot timer that has already expired.  This is much cheaper than
+	deleting the timer and creating a new one so use it for timers that
+	are pushed back often, like heartbeat alarms.
+	*/
+	virtual void		resetTimer(CEventQueueTimer*) = 0;
+
 	//! Register an event handler for an event type
 	/*!
 	Registers an event handler for \p type and \p target.  The \p handler
@@ -128,16 +159,35 @@ public:
 	//! Unregister an event handler for an event type
 	/*!
 	Unregisters an event handler for the \p type, \p target pair and
-	deletes it.
+	deletes it.  If an event is being dispatched then deleting the
+	handler may wait until that's done, so it's safe for a handler to
+	remove itself.
 	*/
 	virtual void		removeHandler(CEvent::Type type, void* target) = 0;
 
 	//! Unregister all event handlers for an event target
 	/*!
-	Unregisters all event handlers for the \p target and deletes them.
+	Unregisters all event handlers for the \p target and deletes them,
+	possibly later, like \c removeHandler().
 	*/
 	virtual void		removeHandlers(void* target) = 0;
 
+	//! Coalesce queued events of a type
+	/*!
+	Makes \c getEvent() merge runs of events of type \p type for the
+	same target.  When \c getEvent() takes such an event off the queue
+	and the next queued event has the same type and target, it calls
+	\p func with \p userData to merge the next event into the first,
+	discards the next event and repeats.  Events of other types or for
+	other targets end the run, as does \p func returning false, so
+	coalescing never changes the order of events.  Only events already
+	queued are merged;  \c getEvent() never waits for more.  \p func
+	must only change the data of the event it's given.  Pass NULL for
+	\p func to stop coalescing \p type.
+	*/
+	virtual void		setCoalescer(CEvent::Type type,
+							CoalesceFunc func, void* userData) = 0;
+
 	//! Creates a new event type
 	/*!
 	Returns a unique event type id.
@@ -173,6 +223,17 @@ public:
 	*/
 	virtual IEventJob*	getHandler(CEvent::Type type, void* target) const = 0;
 
+	//! Get coalescing counts
+	/*!
+	Returns the number of events \c getEvent() has taken off the queue
+	in \p taken and how many of those it merged into an earlier event
+	in \p coalesced.  Timer events aren't counted.  The ratio of
+	\p taken to \p taken - \p coalesced is the number of queued events
+	each returned event stands for.
+	*/
+	virtual void		getCoalesceCounts(UInt32& taken,
+							UInt32& coalesced) const = 0;
+
 	//! Get name for event
 	/*!
 	Returns the name for the event \p type.  This is primarily for
@@ -21,11 +21,13 @@
 #include "ProtocolTypes.h"
 #include "XSynergy.h"
 #include "IDataSocket.h"
+#include "IDatagramSocket.h"
 #include "ISocketFactory.h"
 #include "IStreamFilterFactory.h"
 #include "CLog.h"
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
+#include "CArch.h"
 
 //
 // CClient
@@ -50,7 +52,10 @@ CClient::CClient(const CString& name, const CNetworkAddress& address,
 	m_ready(false),
 	m_active(false),
 	m_suspended(false),
-	m_connectOnResume(false)
+	m_connectOnResume(false),
+	m_serverReached(false),
+	m_session(0),
+	m_sessionLost(0.0)
 {
 	assert(m_socketFactory != NULL);
 	assert(m_screen        != NULL);
@@ -97,8 +102,11 @@ CClient::connect()
 		// in case we couldn't resolve the address earlier or the address
 		// has changed (which can happen frequently if this is a laptop
 		// being shuttled between various networks).  patch by Brent
-		// Priddy.
-		m_serverAddress.resolve();
+		// Priddy.  when resuming a session we skip it if the address
+		// worked last time since the point is to reconnect quickly.
+		if (!m_serverReached || !canResume()) {
+			m_serverAddress.resolve();
+		}
 
 		// create the socket
 		IDataSocket* socket = m_socketFactory->create();
@@ -120,7 +128,8 @@ CClient::connect()
 		cleanupTimer();
 		cleanupConnecting();
 		delete m_stream;
-		m_stream = NULL;
+		m_stream        = NULL;
+		m_serverReached = false;
 		LOG((CLOG_DEBUG1 "connection failed"));
 		sendConnectionFailedEvent(e.what());
 		return;
@@ -151,6 +160,25 @@ CClient::handshakeComplete()
 	sendEvent(getConnectedEvent(), NULL);
 }
 
+bool
+CClient::setSession(UInt32 token)
+{
+	// the server echoes the token we offered if it resumed the session
+	if (token != 0 && token == m_session) {
+		LOG((CLOG_NOTE "resumed session"));
+		return true;
+	}
+
+	// new session.  reset clipboard state.
+	m_session = token;
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		m_ownClipboard[id]  = false;
+		m_sentClipboard[id] = false;
+		m_timeClipboard[id] = 0;
+	}
+	return false;
+}
+
 bool
 CClient::isConnected() const
 {
@@ -169,6 +197,12 @@ CClient::getServerAddress() const
 	return m_serverAddress;
 }
 
+IDatagramSocket*
+CClient::createDatagramSocket() const
+{
+	return m_socketFactory->createDatagram();
+}
+
 CEvent::Type
 CClient::getConnectedEvent()
 {
@@ -384,6 +418,13 @@ CClient::sendConnectionFailedEvent(const char* msg)
 	sendEvent(getConnectionFailedEvent(), info);
 }
 
+bool
+CClient::canResume() const
+{
+	return (m_session != 0 &&
+			ARCH->time() - m_sessionLost < kSessionResumeTime);
+}
+
 void
 CClient::setupConnecting()
 {
@@ -490,7 +531,8 @@ CClient::cleanupScreen()
 	if (m_server != NULL) {
 		if (m_ready) {
 			m_screen->disable();
-			m_ready = false;
+			m_ready       = false;
+			m_sessionLost = ARCH->time();
 		}
 		EVENTQUEUE->removeHandler(IScreen::getShapeChangedEvent(),
 							getEventTarget());
@@ -517,13 +559,7 @@ CClient::handleConnected(const CEvent&, void*)
 	LOG((CLOG_DEBUG1 "connected;  wait for hello"));
 	cleanupConnecting();
 	setupConnection();
-
-	// reset clipboard state
-	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
-		m_ownClipboard[id]  = false;
-		m_sentClipboard[id] = false;
-		m_timeClipboard[id] = 0;
-	}
+	m_serverReached = true;
 }
 
 void
@@ -535,7 +571,8 @@ CClient::handleConnectionFailed(const CEvent& event, void*)
 	cleanupTimer();
 	cleanupConnecting();
 	delete m_stream;
-	m_stream = NULL;
+	m_stream        = NULL;
+	m_serverReached = false;
 	LOG((CLOG_DEBUG1 "connection failed"));
 	sendConnectionFailedEvent(info->m_what);
 }
@@ -547,7 +584,8 @@ CClient::handleConnectTimeout(const CEvent&, void*)
 	cleanupConnecting();
 	cleanupConnection();
 	delete m_stream;
-	m_stream = NULL;
+	m_stream        = NULL;
+	m_serverReached = false;
 	LOG((CLOG_DEBUG1 "connection timed out"));
 	sendConnectionFailedEvent("Timed out");
 }
@@ -621,11 +659,34 @@ CClient::handleHello(const CEvent&, void*)
 		return;
 	}
 
-	// say hello back
+	// say hello back, offering the capabilities we support.  they
+	// must be in the same message as the rest of the reply.
+	CCapabilityList capabilities;
+	capabilities.push_back(kCapMotionBatch);
+	capabilities.push_back(kMaxMotionBatch);
+	capabilities.push_back(kCapCompactInput);
+	capabilities.push_back(1);
+	capabilities.push_back(kCapKeyRepeat);
+	capabilities.push_back(1);
+	if (m_streamFilterFactory == NULL) {
+		// datagrams would bypass the stream filters
+		capabilities.push_back(kCapMotionChannel);
+		capabilities.push_back(1);
+	}
+	if (!canResume()) {
+		// too late to resume the last session
+		m_session = 0;
+	}
+	capabilities.push_back(kCapResume);
+	capabilities.push_back(m_session != 0 ? m_session : 1);
+	capabilities.push_back(kCapNoAck);
+	capabilities.push_back(1);
 	LOG((CLOG_DEBUG1 "say hello version %d.%d", kProtocolMajorVersion, kProtocolMinorVersion));
-	CProtocolUtil::writef(m_stream, kMsgHelloBack,
+	CString format(kMsgHelloBack);
+	format += kMsgHelloCapabilities;
+	CProtocolUtil::writef(m_stream, format.c_str(),
 							kProtocolMajorVersion,
-							kProtocolMinorVersion, &m_name);
+							kProtocolMinorVersion, &m_name, &capabilities);
 
 	// now connected but waiting to complete handshake
 	setupScreen();
@@ -23,6 +23,7 @@ class CEventQueueTimer;
 class CScreen;
 class CServerProxy;
 class IDataSocket;
+class IDatagramSocket;
 class ISocketFactory;
 class IStream;
 class IStreamFilterFactory;
@@ -72,6 +73,14 @@ public:
 	*/
 	void				handshakeComplete();
 
+	//! Set session
+	/*!
+	Notifies the client of the session token sent by the server, 0 if
+	none.  Returns true if the server resumed the client's previous
+	session, in which case the connection handshake is complete.
+	*/
+	bool				setSession(UInt32 token);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -96,6 +105,13 @@ public:
 	*/
 	CNetworkAddress		getServerAddress() const;
 
+	//! Create a datagram socket
+	/*!
+	Returns a new unbound datagram socket from the client's socket
+	factory, for the motion side channel.
+	*/
+	IDatagramSocket*	createDatagramSocket() const;
+
 	//! Get connected event type
 	/*!
 	Returns the connected event type.  This is sent when the client has
@@ -153,6 +169,7 @@ private:
 	void				sendClipboard(ClipboardID);
 	void				sendEvent(CEvent::Type, void*);
 	void				sendConnectionFailedEvent(const char* msg);
+	bool				canResume() const;
 	void				setupConnecting();
 	void				setupConnection();
 	void				setupScreen();
@@ -185,6 +202,9 @@ private:
 	bool					m_active;
 	bool					m_suspended;
 	bool					m_connectOnResume;
+	bool					m_serverReached;
+	UInt32					m_session;
+	double					m_sessionLost;
 	bool				m_ownClipboard[kClipboardEnd];
 	bool				m_sentClipboard[kClipboardEnd];
 	IClipboard::Time	m_timeClipboard[kClipboardEnd];
@@ -18,6 +18,7 @@
 #include "CProtocolUtil.h"
 #include "OptionTypes.h"
 #include "ProtocolTypes.h"
+#include "IDatagramSocket.h"
 #include "IStream.h"
 #include "CLog.h"
 #include "IEventQueue.h"
@@ -35,14 +36,38 @@ CServerProxy::CServerProxy(CClient* client, IStream* stream) :
 	m_seqNum(0),
 	m_compressMouse(false),
 	m_compressMouseRelative(false),
+	m_compressWheel(false),
 	m_xMouse(0),
 	m_yMouse(0),
 	m_dxMouse(0),
 	m_dyMouse(0),
+	m_xWheel(0),
+	m_yWheel(0),
+	m_xCompact(0),
+	m_yCompact(0),
 	m_ignoreMouse(false),
 	m_keepAliveAlarm(0.0),
 	m_keepAliveAlarmTimer(NULL),
-	m_parser(&CServerProxy::parseHandshakeMessage)
+	m_ackEveryMessage(true),
+	m_unacked(false),
+	m_ackTimer(NULL),
+	m_ackWaiting(false),
+	m_parser(&CServerProxy::parseHandshakeMessage),
+	m_compactInput(false),
+	m_repeatTimer(NULL),
+	m_repeatDelayed(false),
+	m_repeatInterval(0.0),
+	m_repeatID(kKeyNone),
+	m_repeatMask(0),
+	m_repeatButton(0),
+	m_motionSocket(NULL),
+	m_motionTimer(NULL),
+	m_motionToken(0),
+	m_motionSeq(0),
+	m_motionAbsSeq(0),
+	m_dxMotion(0),
+	m_dyMotion(0),
+	m_active(false)
 {
 	assert(m_client != NULL);
 	assert(m_stream != NULL);
@@ -63,19 +88,35 @@ CServerProxy::CServerProxy(CClient* client, IStream* stream) :
 
 CServerProxy::~CServerProxy()
 {
+	stopKeyRepeat();
+	closeMotionChannel();
 	setKeepAliveRate(-1.0);
+	if (m_ackTimer != NULL) {
+		EVENTQUEUE->removeHandler(CEvent::kTimer, m_ackTimer);
+		EVENTQUEUE->deleteTimer(m_ackTimer);
+	}
 	EVENTQUEUE->removeHandler(IStream::getInputReadyEvent(),
 							m_stream->getEventTarget());
 }
 
 void
 CServerProxy::resetKeepAliveAlarm()
+{
+	// restart the alarm in place
+	if (m_keepAliveAlarmTimer != NULL) {
+		EVENTQUEUE->resetTimer(m_keepAliveAlarmTimer);
+	}
+}
+
+void
+CServerProxy::setKeepAliveRate(double rate)
 {
 	if (m_keepAliveAlarmTimer != NULL) {
 		EVENTQUEUE->removeHandler(CEvent::kTimer, m_keepAliveAlarmTimer);
 		EVENTQUEUE->deleteTimer(m_keepAliveAlarmTimer);
 		m_keepAliveAlarmTimer = NULL;
 	}
+	m_keepAliveAlarm = rate * kKeepAlivesUntilDeath;
 	if (m_keepAliveAlarm > 0.0) {
 		m_keepAliveAlarmTimer =
 			EVENTQUEUE->newOneShotTimer(m_keepAliveAlarm, NULL);
@@ -85,116 +126,167 @@ CServerProxy::resetKeepAliveAlarm()
 	}
 }
 
-void
-CServerProxy::setKeepAliveRate(double rate)
-{
-	m_keepAliveAlarm = rate * kKeepAlivesUntilDeath;
-	resetKeepAliveAlarm();
-}
-
 void
 CServerProxy::handleData(const CEvent&, void*)
 {
-	// handle messages until there are no more.  first read message code.
+	// handle messages until there are no more.  first read the first
+	// byte of the message code, which may instead be the opcode of a
+	// compact input record.
 	UInt8 code[4];
-	UInt32 n = m_stream->read(code, 4);
+	UInt32 n = m_stream->read(code, 1);
 	while (n != 0) {
-		// verify we got an entire code
-		if (n != 4) {
-			LOG((CLOG_ERR "incomplete message from server: %d bytes", n));
-			m_client->disconnect("incomplete message from server");
-			return;
+		EResult result;
+		if (m_compactInput && code[0] < kCompactLast) {
+			result = parseCompactMessage(code[0]);
+			if (result == kUnknown) {
+				LOG((CLOG_ERR "invalid compact record from server: %d", code[0]));
+				m_client->disconnect("invalid message from server");
+				return;
+			}
 		}
-
-		// parse message
-		LOG((CLOG_DEBUG2 "msg from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
-		switch ((this->*m_parser)(code)) {
-		case kOkay:
-			break;
-
-		case kUnknown:
-			LOG((CLOG_ERR "invalid message from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
-			m_client->disconnect("invalid message from server");
-			return;
-
-		case kDisconnect:
+		else {
+			// verify we got an entire code
+			n += m_stream->read(code + 1, 3);
+			if (n != 4) {
+				LOG((CLOG_ERR "incomplete message from server: %d bytes", n));
+				m_client->disconnect("incomplete message from server");
+				return;
+			}
+
+			// parse message
+			LOG((CLOG_DEBUG2 "msg from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
+			result = (this->*m_parser)(CProtocolUtil::getCode(code));
+			if (result == kUnknown) {
+				LOG((CLOG_ERR "invalid message from server: %c%c%c%c", code[0], code[1], code[2], code[3]));
+				m_client->disconnect("invalid message from server");
+				return;
+			}
+		}
+		if (result == kDisconnect) {
 			return;
 		}
 
 		// next message
-		n = m_stream->read(code, 4);
+		n = m_stream->read(code, 1);
 	}
 
 	flushCompressedMouse();
+
+	// acknowledge the batch unless we've done so recently, in which
+	// case the timer will take care of it
+	if (m_unacked && !m_ackWaiting) {
+		sendAckAndWait();
+	}
+}
+
+void
+CServerProxy::sendAck()
+{
+	CProtocolUtil::writeMessage(m_stream, CMsgCNoop());
+	m_unacked = false;
+}
+
+void
+CServerProxy::sendAckAndWait()
+{
+	sendAck();
+
+	// the timer is made the first time and rearmed after that
+	if (m_ackTimer == NULL) {
+		m_ackTimer = EVENTQUEUE->newOneShotTimer(kAckInterval, NULL);
+		EVENTQUEUE->adoptHandler(CEvent::kTimer, m_ackTimer,
+							new TMethodEventJob<CServerProxy>(this,
+								&CServerProxy::handleAckTimer));
+	}
+	else {
+		EVENTQUEUE->resetTimer(m_ackTimer);
+	}
+	m_ackWaiting = true;
+}
+
+void
+CServerProxy::handleAckTimer(const CEvent&, void*)
+{
+	// acknowledge anything that arrived since the last ack and wait
+	// again before sending another
+	m_ackWaiting = false;
+	if (m_unacked) {
+		sendAckAndWait();
+	}
 }
 
 CServerProxy::EResult
-CServerProxy::parseHandshakeMessage(const UInt8* code)
+CServerProxy::parseHandshakeMessage(UInt32 code)
 {
-	if (memcmp(code, kMsgQInfo, 4) == 0) {
+	switch (code) {
+	case kCodeQInfo:
 		queryInfo();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
+	case kCodeCInfoAck:
 		infoAcknowledgment();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
+	case kCodeDSetOptions:
 		setOptions();
 
 		// handshake is complete
 		m_parser = &CServerProxy::parseMessage;
 		m_client->handshakeComplete();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
+	case kCodeCResetOptions:
 		resetOptions();
-	}
+		break;
+
+	case kCodeDCapabilities:
+		setCapabilities();
+		break;
 
-	else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
+	case kCodeCMotionChannel:
+		motionChannel();
+		break;
+
+	case kCodeCKeepAlive:
 		// echo keep alives and reset alarm
-		CProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+		CProtocolUtil::writeMessage(m_stream, CMsgCKeepAlive());
 		resetKeepAliveAlarm();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCNoop, 4) == 0) {
+	case kCodeCNoop:
 		// accept and discard no-op
-	}
+		break;
 
-	else if (memcmp(code, kMsgCClose, 4) == 0) {
+	case kCodeCClose:
 		// server wants us to hangup
 		LOG((CLOG_DEBUG1 "recv close"));
 		m_client->disconnect(NULL);
 		return kDisconnect;
-	}
 
-	else if (memcmp(code, kMsgEIncompatible, 4) == 0) {
-		SInt32 major, minor;
-		CProtocolUtil::readf(m_stream,
-						kMsgEIncompatible + 4, &major, &minor);
-		LOG((CLOG_ERR "server has incompatible version %d.%d", major, minor));
+	case kCodeEIncompatible: {
+		CMsgEIncompatible msg;
+		CProtocolUtil::readMessage(m_stream, msg);
+		LOG((CLOG_ERR "server has incompatible version %d.%d", msg.m_major, msg.m_minor));
 		m_client->disconnect("server has incompatible version");
 		return kDisconnect;
 	}
 
-	else if (memcmp(code, kMsgEBusy, 4) == 0) {
+	case kCodeEBusy:
 		LOG((CLOG_ERR "server already has a connected client with name \"%s\"", m_client->getName().c_str()));
 		m_client->disconnect("server already has a connected client with our name");
 		return kDisconnect;
-	}
 
-	else if (memcmp(code, kMsgEUnknown, 4) == 0) {
+	case kCodeEUnknown:
 		LOG((CLOG_ERR "server refused client with name \"%s\"", m_client->getName().c_str()));
 		m_client->disconnect("server refused client with our name");
 		return kDisconnect;
-	}
 
-	else if (memcmp(code, kMsgEBad, 4) == 0) {
+	case kCodeEBad:
 		LOG((CLOG_ERR "server disconnected due to a protocol error"));
 		m_client->disconnect("server reported a protocol error");
 		return kDisconnect;
-	}
-	else {
+
+	default:
 		return kUnknown;
 	}
 
@@ -202,111 +294,186 @@ CServerProxy::parseHandshakeMessage(const UInt8* code)
 }
 
 CServerProxy::EResult
-CServerProxy::parseMessage(const UInt8* code)
+CServerProxy::parseMessage(UInt32 code)
 {
-	if (memcmp(code, kMsgDMouseMove, 4) == 0) {
+	switch (code) {
+	case kCodeDMouseMove:
 		mouseMove();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDMouseRelMove, 4) == 0) {
+	case kCodeDMouseRelMove:
 		mouseRelativeMove();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDMouseWheel, 4) == 0) {
+	case kCodeDMouseRelMoveBatch:
+		mouseRelativeMoveBatch();
+		break;
+
+	case kCodeDMouseWheel:
 		mouseWheel();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDKeyDown, 4) == 0) {
+	case kCodeDMotionSync:
+		motionSync();
+		break;
+
+	case kCodeDKeyDown:
 		keyDown();
-	}
+		break;
+
+	case kCodeDKeyDownRepeat:
+		keyDownRepeat();
+		break;
 
-	else if (memcmp(code, kMsgDKeyUp, 4) == 0) {
+	case kCodeDKeyUp:
 		keyUp();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDMouseDown, 4) == 0) {
+	case kCodeDMouseDown:
 		mouseDown();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDMouseUp, 4) == 0) {
+	case kCodeDMouseUp:
 		mouseUp();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDKeyRepeat, 4) == 0) {
+	case kCodeDKeyRepeat:
 		keyRepeat();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
+	case kCodeCKeepAlive:
 		// echo keep alives and reset alarm
-		CProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+		CProtocolUtil::writeMessage(m_stream, CMsgCKeepAlive());
 		resetKeepAliveAlarm();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCNoop, 4) == 0) {
+	case kCodeCNoop:
 		// accept and discard no-op
-	}
+		break;
 
-	else if (memcmp(code, kMsgCEnter, 4) == 0) {
+	case kCodeCEnter:
 		enter();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCLeave, 4) == 0) {
+	case kCodeCLeave:
 		leave();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCClipboard, 4) == 0) {
+	case kCodeCClipboard:
 		grabClipboard();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCScreenSaver, 4) == 0) {
+	case kCodeCScreenSaver:
 		screensaver();
-	}
+		break;
 
-	else if (memcmp(code, kMsgQInfo, 4) == 0) {
+	case kCodeQInfo:
 		queryInfo();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCInfoAck, 4) == 0) {
+	case kCodeCInfoAck:
 		infoAcknowledgment();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDClipboard, 4) == 0) {
+	case kCodeDClipboard:
 		setClipboard();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCResetOptions, 4) == 0) {
+	case kCodeCResetOptions:
 		resetOptions();
-	}
+		break;
 
-	else if (memcmp(code, kMsgDSetOptions, 4) == 0) {
+	case kCodeDSetOptions:
 		setOptions();
-	}
+		break;
 
-	else if (memcmp(code, kMsgCClose, 4) == 0) {
+	case kCodeCMotionChannel:
+		// a resumed session skips the rest of the handshake
+		motionChannel();
+		break;
+
+	case kCodeCClose:
 		// server wants us to hangup
 		LOG((CLOG_DEBUG1 "recv close"));
 		m_client->disconnect(NULL);
 		return kDisconnect;
-	}
-	else if (memcmp(code, kMsgEBad, 4) == 0) {
+
+	case kCodeEBad:
 		LOG((CLOG_ERR "server disconnected due to a protocol error"));
 		m_client->disconnect("server reported a protocol error");
 		return kDisconnect;
+
+	default:
+		return kUnknown;
 	}
-	else {
+
+	acknowledge();
+	return kOkay;
+}
+
+CServerProxy::EResult
+CServerProxy::parseCompactMessage(UInt8 opcode)
+{
+	bool okay;
+	switch (opcode) {
+	case kCompactMouseMove:
+		okay = compactMouseMove();
+		break;
+
+	case kCompactMouseRelMove:
+		okay = compactMouseRelativeMove(false);
+		break;
+
+	case kCompactMouseRelMoveTimed:
+		okay = compactMouseRelativeMove(true);
+		break;
+
+	case kCompactMouseWheel:
+		okay = compactMouseWheel();
+		break;
+
+	case kCompactKeyDown:
+	case kCompactKeyDownRepeat:
+	case kCompactKeyRepeat:
+	case kCompactKeyUp:
+		okay = compactKey(opcode);
+		break;
+
+	case kCompactMouseDown:
+	case kCompactMouseUp:
+		okay = compactMouseButton(opcode);
+		break;
+
+	default:
+		okay = false;
+		break;
+	}
+	if (!okay) {
 		return kUnknown;
 	}
 
+	acknowledge();
+	return kOkay;
+}
+
+void
+CServerProxy::acknowledge()
+{
 	// send a reply.  this is intended to work around a delay when
 	// running a linux server and an OS X (any BSD?) client.  the
 	// client waits to send an ACK (if the system control flag
 	// net.inet.tcp.delayed_ack is 1) in hopes of piggybacking it
 	// on a data packet.  we provide that packet here.  i don't
 	// know why a delayed ACK should cause the server to wait since
-	// TCP_NODELAY is enabled.
-	CProtocolUtil::writef(m_stream, kMsgCNoop);
-
-	return kOkay;
+	// TCP_NODELAY is enabled.  servers that don't need this turn on
+	// kCapNoAck and we then send at most one reply per kAckInterval
+	// from handleData().
+	if (m_ackEveryMessage) {
+		CProtocolUtil::writeMessage(m_stream, CMsgCNoop());
+	}
+	else {
+		m_unacked = true;
+	}
 }
 
 void
@@ -331,7 +498,7 @@ bool
 CServerProxy::onGrabClipboard(ClipboardID id)
 {
 	LOG((CLOG_DEBUG1 "sending clipboard %d changed", id));
-	CProtocolUtil::writef(m_stream, kMsgCClipboard, id, m_seqNum);
+	CProtocolUtil::writeMessage(m_stream, CMsgCClipboard(id, m_seqNum));
 	return true;
 }
 
@@ -343,6 +510,17 @@ CServerProxy::onClipboardChanged(ClipboardID id, const IClipboard* clipboard)
 	CProtocolUtil::writef(m_stream, kMsgDClipboard, id, m_seqNum, &data);
 }
 
+UInt32
+CServerProxy::getCapability(CapabilityID id) const
+{
+	for (UInt32 i = 0; i + 1 < m_capabilities.size(); i += 2) {
+		if (m_capabilities[i] == id) {
+			return m_capabilities[i + 1];
+		}
+	}
+	return 0;
+}
+
 void
 CServerProxy::flushCompressedMouse()
 {
@@ -356,16 +534,162 @@ CServerProxy::flushCompressedMouse()
 		m_dxMouse = 0;
 		m_dyMouse = 0;
 	}
+	if (m_compressWheel) {
+		m_compressWheel = false;
+		m_client->mouseWheel(m_xWheel, m_yWheel);
+		m_xWheel = 0;
+		m_yWheel = 0;
+	}
+}
+
+void
+CServerProxy::startKeyRepeat(KeyID id, KeyModifierMask mask,
+				KeyButton button, double delay, double interval)
+{
+	stopKeyRepeat();
+	if (delay <= 0.0 || interval <= 0.0) {
+		return;
+	}
+	m_repeatDelayed  = true;
+	m_repeatInterval = interval;
+	m_repeatID       = id;
+	m_repeatMask     = mask;
+	m_repeatButton   = button;
+	m_repeatTimer    = EVENTQUEUE->newOneShotTimer(delay, NULL);
+	EVENTQUEUE->adoptHandler(CEvent::kTimer, m_repeatTimer,
+							new TMethodEventJob<CServerProxy>(this,
+								&CServerProxy::handleKeyRepeatTimer));
+}
+
+void
+CServerProxy::stopKeyRepeat()
+{
+	if (m_repeatTimer != NULL) {
+		EVENTQUEUE->removeHandler(CEvent::kTimer, m_repeatTimer);
+		EVENTQUEUE->deleteTimer(m_repeatTimer);
+		m_repeatTimer = NULL;
+	}
+}
+
+void
+CServerProxy::handleKeyRepeatTimer(const CEvent& event, void*)
+{
+	UInt32 count = 1;
+	if (m_repeatDelayed) {
+		// the delay is over.  repeat every interval from now on.
+		m_repeatDelayed = false;
+		EVENTQUEUE->removeHandler(CEvent::kTimer, m_repeatTimer);
+		EVENTQUEUE->deleteTimer(m_repeatTimer);
+		m_repeatTimer = EVENTQUEUE->newTimer(m_repeatInterval, NULL);
+		EVENTQUEUE->adoptHandler(CEvent::kTimer, m_repeatTimer,
+							new TMethodEventJob<CServerProxy>(this,
+								&CServerProxy::handleKeyRepeatTimer));
+	}
+	else {
+		// catch up on any intervals we missed
+		const IEventQueue::CTimerEvent* timer =
+			reinterpret_cast<const IEventQueue::CTimerEvent*>(event.getData());
+		count = timer->m_count;
+	}
+
+	LOG((CLOG_DEBUG2 "repeat key id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", m_repeatID, m_repeatMask, count, m_repeatButton));
+	m_client->keyRepeat(m_repeatID, m_repeatMask,
+							static_cast<SInt32>(count), m_repeatButton);
+}
+
+void
+CServerProxy::sendMotionHello()
+{
+	UInt8 buffer[CMsgMotionHello::kSize];
+	CProtocolUtil::encode(buffer, CMsgMotionHello(m_motionToken));
+	m_motionSocket->send(buffer, sizeof(buffer), m_client->getServerAddress());
+}
+
+void
+CServerProxy::closeMotionChannel()
+{
+	if (m_motionTimer != NULL) {
+		EVENTQUEUE->removeHandler(CEvent::kTimer, m_motionTimer);
+		EVENTQUEUE->deleteTimer(m_motionTimer);
+		m_motionTimer = NULL;
+	}
+	if (m_motionSocket != NULL) {
+		EVENTQUEUE->removeHandler(IDatagramSocket::getInputReadyEvent(),
+							m_motionSocket->getEventTarget());
+		delete m_motionSocket;
+		m_motionSocket = NULL;
+	}
+}
+
+void
+CServerProxy::applyMotionUpdate(UInt32 seq, UInt32 absSeq,
+				SInt32 x, SInt32 y, SInt32 dx, SInt32 dy)
+{
+	// ignore updates older than the last we forwarded.  the numbers
+	// wrap.
+	if (!m_active || static_cast<SInt32>(seq - m_motionSeq) <= 0) {
+		return;
+	}
+	m_motionSeq = seq;
+
+	// move to the absolute position if it's new then by the relative
+	// motion since it that we haven't forwarded
+	if (absSeq != m_motionAbsSeq) {
+		LOG((CLOG_DEBUG2 "recv mouse move %d,%d at motion %u", x, y, absSeq));
+		m_motionAbsSeq = absSeq;
+		m_dxMotion     = 0;
+		m_dyMotion     = 0;
+		absoluteMove(x, y);
+	}
+	const SInt32 xRel = static_cast<SInt32>(static_cast<UInt32>(dx) -
+								static_cast<UInt32>(m_dxMotion));
+	const SInt32 yRel = static_cast<SInt32>(static_cast<UInt32>(dy) -
+								static_cast<UInt32>(m_dyMotion));
+	if (xRel != 0 || yRel != 0) {
+		LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d at motion %u", xRel, yRel, seq));
+		m_dxMotion = dx;
+		m_dyMotion = dy;
+		relativeMove(xRel, yRel);
+	}
+}
+
+void
+CServerProxy::handleMotionData(const CEvent&, void*)
+{
+	// forward the motion in every waiting datagram.  anyone can send us
+	// datagrams so check them.  motion compresses as on the stream when
+	// more input follows.
+	UInt8 buffer[CMsgMotionUpdate::kSize];
+	UInt32 n;
+	while ((n = m_motionSocket->receive(buffer, sizeof(buffer), NULL)) != 0) {
+		CMsgMotionUpdate msg;
+		if (n != CMsgMotionUpdate::kSize ||
+			CProtocolUtil::getCode(buffer) != kCodeMotionUpdate ||
+			!CProtocolUtil::decode(buffer + 4, n - 4, msg) ||
+			msg.m_token != m_motionToken) {
+			LOG((CLOG_DEBUG1 "bad motion datagram"));
+			continue;
+		}
+		applyMotionUpdate(msg.m_seq, msg.m_absSeq,
+							msg.m_x, msg.m_y, msg.m_dx, msg.m_dy);
+	}
+	flushCompressedMouse();
+}
+
+void
+CServerProxy::handleMotionHelloTimer(const CEvent&, void*)
+{
+	sendMotionHello();
 }
 
 void
 CServerProxy::sendInfo(const CClientInfo& info)
 {
 	LOG((CLOG_DEBUG1 "sending info shape=%d,%d %dx%d", info.m_x, info.m_y, info.m_w, info.m_h));
-	CProtocolUtil::writef(m_stream, kMsgDInfo,
-								info.m_x, info.m_y,
-								info.m_w, info.m_h, 0,
-								info.m_mx, info.m_my);
+	CProtocolUtil::writeMessage(m_stream,
+								CMsgDInfo(info.m_x, info.m_y,
+										info.m_w, info.m_h, 0,
+										info.m_mx, info.m_my));
 }
 
 KeyID
@@ -481,19 +805,30 @@ void
 CServerProxy::enter()
 {
 	// parse
-	SInt16 x, y;
-	UInt16 mask;
-	UInt32 seqNum;
-	CProtocolUtil::readf(m_stream, kMsgCEnter + 4, &x, &y, &seqNum, &mask);
+	CMsgCEnter msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	SInt32 x = msg.m_x, y = msg.m_y;
+	UInt16 mask   = msg.m_mask;
+	UInt32 seqNum = msg.m_seqNum;
 	LOG((CLOG_DEBUG1 "recv enter, %d,%d %d %04x", x, y, seqNum, mask));
 
-	// discard old compressed mouse motion, if any
+	// discard old compressed mouse motion, if any, and stop any key
+	// repeat left from the last time we had the screen
+	stopKeyRepeat();
 	m_compressMouse         = false;
 	m_compressMouseRelative = false;
+	m_compressWheel         = false;
 	m_dxMouse               = 0;
 	m_dyMouse               = 0;
+	m_xWheel                = 0;
+	m_yWheel                = 0;
 	m_seqNum                = seqNum;
 
+	// compact motion is relative to the entry point
+	m_xCompact              = x;
+	m_yCompact              = y;
+	m_active                = true;
+
 	// forward
 	m_client->enter(x, y, seqNum, static_cast<KeyModifierMask>(mask), false);
 }
@@ -506,6 +841,10 @@ CServerProxy::leave()
 
 	// send last mouse motion
 	flushCompressedMouse();
+	m_active = false;
+
+	// the key we were repeating won't be released here
+	stopKeyRepeat();
 
 	// forward
 	m_client->leave();
@@ -536,9 +875,9 @@ void
 CServerProxy::grabClipboard()
 {
 	// parse
-	ClipboardID id;
-	UInt32 seqNum;
-	CProtocolUtil::readf(m_stream, kMsgCClipboard + 4, &id, &seqNum);
+	CMsgCClipboard msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	ClipboardID id = msg.m_id;
 	LOG((CLOG_DEBUG "recv grab clipboard %d", id));
 
 	// validate
@@ -557,8 +896,9 @@ CServerProxy::keyDown()
 	flushCompressedMouse();
 
 	// parse
-	UInt16 id, mask, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyDown + 4, &id, &mask, &button);
+	CMsgDKeyDown msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	UInt16 id = msg.m_id, mask = msg.m_mask, button = msg.m_button;
 	LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
 	// translate
@@ -569,8 +909,35 @@ CServerProxy::keyDown()
 		mask2 != static_cast<KeyModifierMask>(mask))
 		LOG((CLOG_DEBUG1 "key down translated to id=0x%08x, mask=0x%04x", id2, mask2));
 
-	// forward
+	// forward.  pressing a key stops the repeat of any other key.
+	stopKeyRepeat();
+	m_client->keyDown(id2, mask2, button);
+}
+
+void
+CServerProxy::keyDownRepeat()
+{
+	// get mouse up to date
+	flushCompressedMouse();
+
+	// parse
+	CMsgDKeyDownRepeat msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	UInt16 id = msg.m_id, mask = msg.m_mask, button = msg.m_button;
+	LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x, repeat %d/%dms", id, mask, button, msg.m_delay, msg.m_interval));
+
+	// translate
+	KeyID id2             = translateKey(static_cast<KeyID>(id));
+	KeyModifierMask mask2 = translateModifierMask(
+								static_cast<KeyModifierMask>(mask));
+	if (id2   != static_cast<KeyID>(id) ||
+		mask2 != static_cast<KeyModifierMask>(mask))
+		LOG((CLOG_DEBUG1 "key down translated to id=0x%08x, mask=0x%04x", id2, mask2));
+
+	// forward and repeat until the key is released
 	m_client->keyDown(id2, mask2, button);
+	startKeyRepeat(id2, mask2, button,
+							1.0e-3 * msg.m_delay, 1.0e-3 * msg.m_interval);
 }
 
 void
@@ -580,9 +947,10 @@ CServerProxy::keyRepeat()
 	flushCompressedMouse();
 
 	// parse
-	UInt16 id, mask, count, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyRepeat + 4,
-								&id, &mask, &count, &button);
+	CMsgDKeyRepeat msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	UInt16 id    = msg.m_id,    mask   = msg.m_mask;
+	UInt16 count = msg.m_count, button = msg.m_button;
 	LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
 
 	// translate
@@ -604,8 +972,9 @@ CServerProxy::keyUp()
 	flushCompressedMouse();
 
 	// parse
-	UInt16 id, mask, button;
-	CProtocolUtil::readf(m_stream, kMsgDKeyUp + 4, &id, &mask, &button);
+	CMsgDKeyUp msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	UInt16 id = msg.m_id, mask = msg.m_mask, button = msg.m_button;
 	LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
 
 	// translate
@@ -617,6 +986,9 @@ CServerProxy::keyUp()
 		LOG((CLOG_DEBUG1 "key up translated to id=0x%08x, mask=0x%04x", id2, mask2));
 
 	// forward
+	if (m_repeatTimer != NULL && button == m_repeatButton) {
+		stopKeyRepeat();
+	}
 	m_client->keyUp(id2, mask2, button);
 }
 
@@ -627,8 +999,9 @@ CServerProxy::mouseDown()
 	flushCompressedMouse();
 
 	// parse
-	SInt8 id;
-	CProtocolUtil::readf(m_stream, kMsgDMouseDown + 4, &id);
+	CMsgDMouseDown msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	SInt8 id = static_cast<SInt8>(msg.m_id);
 	LOG((CLOG_DEBUG1 "recv mouse down id=%d", id));
 
 	// forward
@@ -642,8 +1015,9 @@ CServerProxy::mouseUp()
 	flushCompressedMouse();
 
 	// parse
-	SInt8 id;
-	CProtocolUtil::readf(m_stream, kMsgDMouseUp + 4, &id);
+	CMsgDMouseUp msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	SInt8 id = static_cast<SInt8>(msg.m_id);
 	LOG((CLOG_DEBUG1 "recv mouse up id=%d", id));
 
 	// forward
@@ -654,12 +1028,28 @@ void
 CServerProxy::mouseMove()
 {
 	// parse
-	bool ignore;
-	SInt16 x, y;
-	CProtocolUtil::readf(m_stream, kMsgDMouseMove + 4, &x, &y);
+	CMsgDMouseMove msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	LOG((CLOG_DEBUG2 "recv mouse move %d,%d", msg.m_x, msg.m_y));
+
+	// forward
+	absoluteMove(msg.m_x, msg.m_y);
+}
+
+void
+CServerProxy::absoluteMove(SInt32 x, SInt32 y)
+{
+	// compact motion is relative to this position
+	m_xCompact = x;
+	m_yCompact = y;
+
+	// scrolling before the move goes first
+	if (m_compressWheel) {
+		flushCompressedMouse();
+	}
 
 	// note if we should ignore the move
-	ignore = m_ignoreMouse;
+	bool ignore = m_ignoreMouse;
 
 	// compress mouse motion events if more input follows
 	if (!ignore && !m_compressMouse && m_stream->isReady()) {
@@ -675,7 +1065,6 @@ CServerProxy::mouseMove()
 		m_dxMouse = 0;
 		m_dyMouse = 0;
 	}
-	LOG((CLOG_DEBUG2 "recv mouse move %d,%d", x, y));
 
 	// forward
 	if (!ignore) {
@@ -687,12 +1076,54 @@ void
 CServerProxy::mouseRelativeMove()
 {
 	// parse
-	bool ignore;
-	SInt16 dx, dy;
-	CProtocolUtil::readf(m_stream, kMsgDMouseRelMove + 4, &dx, &dy);
+	CMsgDMouseRelMove msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d", msg.m_dx, msg.m_dy));
+
+	// forward
+	relativeMove(msg.m_dx, msg.m_dy);
+}
+
+void
+CServerProxy::mouseRelativeMoveBatch()
+{
+	// parse the header
+	CMsgDMouseRelMoveBatch msg;
+	if (!CProtocolUtil::readMessage(m_stream, msg)) {
+		return;
+	}
+	LOG((CLOG_DEBUG2 "recv %d mouse relative moves", msg.m_count / 3));
+
+	// forward the samples straight out of the packet.  each is dx, dy
+	// and the time since the previous sample.  we can't tell the
+	// screen when motion happened so the time is only logged.  values
+	// that don't make up a whole sample are discarded.
+	const UInt32 size = 2 * msg.m_count;
+	if (m_stream->getSize() < size) {
+		return;
+	}
+	const UInt8* sample = static_cast<const UInt8*>(m_stream->peek(size));
+	for (UInt32 i = msg.m_count / 3; i > 0; --i) {
+		SInt16 dx = static_cast<SInt16>((sample[0] << 8) | sample[1]);
+		SInt16 dy = static_cast<SInt16>((sample[2] << 8) | sample[3]);
+		UInt16 us = static_cast<UInt16>((sample[4] << 8) | sample[5]);
+		LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d after %dus", dx, dy, us));
+		relativeMove(dx, dy);
+		sample += 6;
+	}
+	m_stream->read(NULL, size);
+}
+
+void
+CServerProxy::relativeMove(SInt32 dx, SInt32 dy)
+{
+	// scrolling before the move goes first
+	if (m_compressWheel) {
+		flushCompressedMouse();
+	}
 
 	// note if we should ignore the move
-	ignore = m_ignoreMouse;
+	bool ignore = m_ignoreMouse;
 
 	// compress mouse motion events if more input follows
 	if (!ignore && !m_compressMouseRelative && m_stream->isReady()) {
@@ -705,7 +1136,6 @@ CServerProxy::mouseRelativeMove()
 		m_dxMouse += dx;
 		m_dyMouse += dy;
 	}
-	LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d", dx, dy));
 
 	// forward
 	if (!ignore) {
@@ -713,27 +1143,230 @@ CServerProxy::mouseRelativeMove()
 	}
 }
 
-void
-CServerProxy::mouseWheel()
+bool
+CServerProxy::compactMouseMove()
+{
+	// parse
+	SInt32 dx, dy;
+	if (!CProtocolUtil::readSignedVarint(m_stream, dx) ||
+		!CProtocolUtil::readSignedVarint(m_stream, dy)) {
+		return false;
+	}
+	LOG((CLOG_DEBUG2 "recv compact mouse move %+d,%+d", dx, dy));
+
+	// forward
+	absoluteMove(m_xCompact + dx, m_yCompact + dy);
+	return true;
+}
+
+bool
+CServerProxy::compactMouseRelativeMove(bool timed)
+{
+	// parse.  we can't tell the screen when motion happened so the
+	// time is only logged.
+	SInt32 dx, dy;
+	UInt32 us = 0;
+	if (!CProtocolUtil::readSignedVarint(m_stream, dx) ||
+		!CProtocolUtil::readSignedVarint(m_stream, dy) ||
+		(timed && !CProtocolUtil::readVarint(m_stream, us))) {
+		return false;
+	}
+	LOG((CLOG_DEBUG2 "recv mouse relative move %d,%d after %dus", dx, dy, us));
+
+	// forward
+	relativeMove(dx, dy);
+	return true;
+}
+
+bool
+CServerProxy::compactMouseWheel()
+{
+	// parse
+	SInt32 xDelta, yDelta;
+	if (!CProtocolUtil::readSignedVarint(m_stream, xDelta) ||
+		!CProtocolUtil::readSignedVarint(m_stream, yDelta)) {
+		return false;
+	}
+	LOG((CLOG_DEBUG2 "recv mouse wheel %+d,%+d", xDelta, yDelta));
+
+	// forward
+	wheel(xDelta, yDelta);
+	return true;
+}
+
+bool
+CServerProxy::compactKey(UInt8 opcode)
 {
 	// get mouse up to date
 	flushCompressedMouse();
 
 	// parse
-	SInt16 xDelta, yDelta;
-	CProtocolUtil::readf(m_stream, kMsgDMouseWheel + 4, &xDelta, &yDelta);
+	UInt32 id, mask, count = 1, button, delay = 0, interval = 0;
+	if (!CProtocolUtil::readVarint(m_stream, id) ||
+		!CProtocolUtil::readVarint(m_stream, mask) ||
+		(opcode == kCompactKeyRepeat &&
+			!CProtocolUtil::readVarint(m_stream, count)) ||
+		!CProtocolUtil::readVarint(m_stream, button) ||
+		(opcode == kCompactKeyDownRepeat &&
+			(!CProtocolUtil::readVarint(m_stream, delay) ||
+			 !CProtocolUtil::readVarint(m_stream, interval)))) {
+		return false;
+	}
+
+	// translate
+	KeyID id2             = translateKey(static_cast<KeyID>(id));
+	KeyModifierMask mask2 = translateModifierMask(
+								static_cast<KeyModifierMask>(mask));
+
+	// forward
+	switch (opcode) {
+	case kCompactKeyDown:
+		LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
+		stopKeyRepeat();
+		m_client->keyDown(id2, mask2, static_cast<KeyButton>(button));
+		break;
+
+	case kCompactKeyDownRepeat:
+		LOG((CLOG_DEBUG1 "recv key down id=0x%08x, mask=0x%04x, button=0x%04x, repeat %d/%dms", id, mask, button, delay, interval));
+		m_client->keyDown(id2, mask2, static_cast<KeyButton>(button));
+		startKeyRepeat(id2, mask2, static_cast<KeyButton>(button),
+							1.0e-3 * delay, 1.0e-3 * interval);
+		break;
+
+	case kCompactKeyRepeat:
+		LOG((CLOG_DEBUG1 "recv key repeat id=0x%08x, mask=0x%04x, count=%d, button=0x%04x", id, mask, count, button));
+		m_client->keyRepeat(id2, mask2, static_cast<SInt32>(count),
+								static_cast<KeyButton>(button));
+		break;
+
+	default:
+		LOG((CLOG_DEBUG1 "recv key up id=0x%08x, mask=0x%04x, button=0x%04x", id, mask, button));
+		if (m_repeatTimer != NULL && button == m_repeatButton) {
+			stopKeyRepeat();
+		}
+		m_client->keyUp(id2, mask2, static_cast<KeyButton>(button));
+		break;
+	}
+	return true;
+}
+
+bool
+CServerProxy::compactMouseButton(UInt8 opcode)
+{
+	// get mouse up to date
+	flushCompressedMouse();
+
+	// parse
+	UInt32 id;
+	if (!CProtocolUtil::readVarint(m_stream, id)) {
+		return false;
+	}
+
+	// forward
+	if (opcode == kCompactMouseDown) {
+		LOG((CLOG_DEBUG1 "recv mouse down id=%d", id));
+		m_client->mouseDown(static_cast<ButtonID>(id));
+	}
+	else {
+		LOG((CLOG_DEBUG1 "recv mouse up id=%d", id));
+		m_client->mouseUp(static_cast<ButtonID>(id));
+	}
+	return true;
+}
+
+void
+CServerProxy::mouseWheel()
+{
+	// parse
+	CMsgDMouseWheel msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	SInt16 xDelta = msg.m_xDelta, yDelta = msg.m_yDelta;
 	LOG((CLOG_DEBUG2 "recv mouse wheel %+d,%+d", xDelta, yDelta));
 
 	// forward
-	m_client->mouseWheel(xDelta, yDelta);
+	wheel(xDelta, yDelta);
+}
+
+void
+CServerProxy::wheel(SInt32 xDelta, SInt32 yDelta)
+{
+	// get mouse up to date
+	if (!m_compressWheel) {
+		flushCompressedMouse();
+	}
+
+	// compress scrolling if more input follows.  the screen then
+	// injects a burst of small deltas as one scroll.
+	if (!m_compressWheel && m_stream->isReady()) {
+		m_compressWheel = true;
+	}
+
+	// if compressing then add up the scrolling, otherwise forward it
+	if (m_compressWheel) {
+		m_xWheel += xDelta;
+		m_yWheel += yDelta;
+	}
+	else {
+		m_client->mouseWheel(xDelta, yDelta);
+	}
+}
+
+void
+CServerProxy::motionChannel()
+{
+	// parse
+	CMsgCMotionChannel msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	LOG((CLOG_DEBUG1 "recv motion channel"));
+
+	// say hello from a datagram socket so the server learns where to
+	// send motion.  if we can't then motion keeps coming on the stream.
+	closeMotionChannel();
+	try {
+		m_motionSocket = m_client->createDatagramSocket();
+	}
+	catch (XBase& e) {
+		LOG((CLOG_WARN "cannot open motion channel: %s", e.what()));
+		return;
+	}
+	m_motionToken  = msg.m_token;
+	m_motionSeq    = 0;
+	m_motionAbsSeq = 0;
+	m_dxMotion     = 0;
+	m_dyMotion     = 0;
+	EVENTQUEUE->adoptHandler(IDatagramSocket::getInputReadyEvent(),
+							m_motionSocket->getEventTarget(),
+							new TMethodEventJob<CServerProxy>(this,
+								&CServerProxy::handleMotionData));
+
+	// keep saying hello in case it's lost or our address changes
+	m_motionTimer = EVENTQUEUE->newTimer(kMotionHelloInterval, NULL);
+	EVENTQUEUE->adoptHandler(CEvent::kTimer, m_motionTimer,
+							new TMethodEventJob<CServerProxy>(this,
+								&CServerProxy::handleMotionHelloTimer));
+	sendMotionHello();
+}
+
+void
+CServerProxy::motionSync()
+{
+	// parse
+	CMsgDMotionSync msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	LOG((CLOG_DEBUG2 "recv motion sync at motion %u", msg.m_seq));
+
+	// forward motion we haven't seen
+	applyMotionUpdate(msg.m_seq, msg.m_absSeq,
+							msg.m_x, msg.m_y, msg.m_dx, msg.m_dy);
 }
 
 void
 CServerProxy::screensaver()
 {
 	// parse
-	SInt8 on;
-	CProtocolUtil::readf(m_stream, kMsgCScreenSaver + 4, &on);
+	CMsgCScreenSaver msg;
+	CProtocolUtil::readMessage(m_stream, msg);
+	SInt8 on = static_cast<SInt8>(msg.m_on);
 	LOG((CLOG_DEBUG1 "recv screen saver on=%d", on));
 
 	// forward
@@ -799,6 +1432,29 @@ CServerProxy::setOptions()
 	}
 }
 
+void
+CServerProxy::setCapabilities()
+{
+	// parse
+	m_capabilities.clear();
+	CProtocolUtil::readf(m_stream, kMsgDCapabilities + 4, &m_capabilities);
+	for (UInt32 i = 0; i + 1 < m_capabilities.size(); i += 2) {
+		const UInt32 id = m_capabilities[i];
+		LOG((CLOG_DEBUG1 "recv capability %c%c%c%c=%d", (id >> 24) & 0xff, (id >> 16) & 0xff, (id >> 8) & 0xff, id & 0xff, m_capabilities[i + 1]));
+	}
+	m_compactInput = (getCapability(kCapCompactInput) != 0);
+	m_ackEveryMessage = (getCapability(kCapNoAck) == 0);
+
+	// the handshake is complete if the server resumed our session
+	if (m_client->setSession(getCapability(kCapResume))) {
+		m_parser = &CServerProxy::parseMessage;
+		m_client->handshakeComplete();
+
+		// our screen may have changed while we were away
+		queryInfo();
+	}
+}
+
 void
 CServerProxy::queryInfo()
 {
@@ -17,12 +17,14 @@
 
 #include "ClipboardTypes.h"
 #include "KeyTypes.h"
+#include "ProtocolTypes.h"
 #include "CEvent.h"
 
 class CClient;
 class CClientInfo;
 class CEventQueueTimer;
 class IClipboard;
+class IDatagramSocket;
 class IStream;
 
 //! Proxy for server
@@ -47,21 +49,68 @@ public:
 	void				onClipboardChanged(ClipboardID, const IClipboard*);
 
 	//@}
+	//! @name accessors
+	//@{
+
+	//! Get capability
+	/*!
+	Returns the value the server chose for capability \p id or 0 if
+	the capability is off.
+	*/
+	UInt32				getCapability(CapabilityID id) const;
+
+	//@}
 
 protected:
 	enum EResult { kOkay, kUnknown, kDisconnect };
-	EResult				parseHandshakeMessage(const UInt8* code);
-	EResult				parseMessage(const UInt8* code);
+	EResult				parseHandshakeMessage(UInt32 code);
+	EResult				parseMessage(UInt32 code);
+	EResult				parseCompactMessage(UInt8 opcode);
 
 private:
-	// if compressing mouse motion then send the last motion now
+	// if compressing mouse motion or scrolling then send it now
 	void				flushCompressedMouse();
 
+	// forward absolute motion, compressing it if more input follows
+	void				absoluteMove(SInt32 x, SInt32 y);
+
+	// forward relative motion, compressing it if more input follows
+	void				relativeMove(SInt32 dx, SInt32 dy);
+
+	// forward scrolling, compressing it if more input follows
+	void				wheel(SInt32 xDelta, SInt32 yDelta);
+
 	void				sendInfo(const CClientInfo&);
 
 	void				resetKeepAliveAlarm();
 	void				setKeepAliveRate(double);
 
+	// send a kMsgCNoop acknowledging the messages received so far
+	void				sendAck();
+
+	// send a kMsgCNoop and start the kAckInterval wait before the next
+	void				sendAckAndWait();
+
+	// acknowledge a message now or note that it needs acknowledging
+	void				acknowledge();
+
+	// repeat a key locally, first after delay seconds and then every
+	// interval seconds, until stopKeyRepeat()
+	void				startKeyRepeat(KeyID, KeyModifierMask, KeyButton,
+							double delay, double interval);
+	void				stopKeyRepeat();
+
+	// send a kMsgMotionHello datagram to the server
+	void				sendMotionHello();
+
+	// close the motion side channel, if open
+	void				closeMotionChannel();
+
+	// forward the motion in a side channel update we haven't already
+	// forwarded
+	void				applyMotionUpdate(UInt32 seq, UInt32 absSeq,
+							SInt32 x, SInt32 y, SInt32 dx, SInt32 dy);
+
 	// modifier key translation
 	KeyID				translateKey(KeyID) const;
 	KeyModifierMask		translateModifierMask(KeyModifierMask) const;
@@ -69,6 +118,10 @@ private:
 	// event handlers
 	void				handleData(const CEvent&, void*);
 	void				handleKeepAliveAlarm(const CEvent&, void*);
+	void				handleAckTimer(const CEvent&, void*);
+	void				handleKeyRepeatTimer(const CEvent&, void*);
+	void				handleMotionData(const CEvent&, void*);
+	void				handleMotionHelloTimer(const CEvent&, void*);
 
 	// message handlers
 	void				enter();
@@ -76,21 +129,34 @@ private:
 	void				setClipboard();
 	void				grabClipboard();
 	void				keyDown();
+	void				keyDownRepeat();
 	void				keyRepeat();
 	void				keyUp();
 	void				mouseDown();
 	void				mouseUp();
 	void				mouseMove();
 	void				mouseRelativeMove();
+	void				mouseRelativeMoveBatch();
 	void				mouseWheel();
+	void				motionChannel();
+	void				motionSync();
 	void				screensaver();
 	void				resetOptions();
 	void				setOptions();
+	void				setCapabilities();
 	void				queryInfo();
 	void				infoAcknowledgment();
 
+	// compact input record handlers.  these return false if the
+	// record is malformed.
+	bool				compactMouseMove();
+	bool				compactMouseRelativeMove(bool timed);
+	bool				compactMouseWheel();
+	bool				compactKey(UInt8 opcode);
+	bool				compactMouseButton(UInt8 opcode);
+
 private:
-	typedef EResult (CServerProxy::*MessageParser)(const UInt8*);
+	typedef EResult (CServerProxy::*MessageParser)(UInt32);
 
 	CClient*			m_client;
 	IStream*			m_stream;
@@ -99,8 +165,13 @@ private:
 
 	bool				m_compressMouse;
 	bool				m_compressMouseRelative;
+	bool				m_compressWheel;
 	SInt32				m_xMouse, m_yMouse;
 	SInt32				m_dxMouse, m_dyMouse;
+	SInt32				m_xWheel, m_yWheel;
+
+	// last absolute position received, the base for compact motion
+	SInt32				m_xCompact, m_yCompact;
 
 	bool				m_ignoreMouse;
 
@@ -109,7 +180,36 @@ private:
 	double				m_keepAliveAlarm;
 	CEventQueueTimer*	m_keepAliveAlarmTimer;
 
+	bool				m_ackEveryMessage;
+	bool				m_unacked;
+	CEventQueueTimer*	m_ackTimer;
+	bool				m_ackWaiting;
+
 	MessageParser		m_parser;
+
+	CCapabilityList		m_capabilities;
+	bool				m_compactInput;
+
+	// key we're repeating locally, if any
+	CEventQueueTimer*	m_repeatTimer;
+	bool				m_repeatDelayed;
+	double				m_repeatInterval;
+	KeyID				m_repeatID;
+	KeyModifierMask		m_repeatMask;
+	KeyButton			m_repeatButton;
+
+	// motion side channel socket, the timer for resending our hello,
+	// our token, the numbers of the last motion and last absolute
+	// motion forwarded, the relative motion forwarded since and whether
+	// we have the screen.  updates arriving without the screen are
+	// dropped but not counted as forwarded.
+	IDatagramSocket*	m_motionSocket;
+	CEventQueueTimer*	m_motionTimer;
+	UInt32				m_motionToken;
+	UInt32				m_motionSeq;
+	UInt32				m_motionAbsSeq;
+	SInt32				m_dxMotion, m_dyMotion;
+	bool				m_active;
 };
 
 #endif
@@ -13,23 +13,31 @@
  */
 
 #include "CStreamBuffer.h"
+#include <cstring>
 
 //
 // CStreamBuffer
 //
 
-const UInt32			CStreamBuffer::kChunkSize = 4096;
+const UInt32			CStreamBuffer::kChunkSize     = 4096;
+const UInt32			CStreamBuffer::kMaxFreeChunks = 16;
 
 CStreamBuffer::CStreamBuffer() :
-	m_size(0),
-	m_headUsed(0)
+	m_head(0),
+	m_count(0),
+	m_size(0)
 {
 	// do nothing
 }
 
 CStreamBuffer::~CStreamBuffer()
 {
-	// do nothing
+	while (m_count > 0) {
+		delete[] popChunk();
+	}
+	for (FreeList::iterator i = m_free.begin(); i != m_free.end(); ++i) {
+		delete[] *i;
+	}
 }
 
 const void*
@@ -38,24 +46,49 @@ CStreamBuffer::peek(UInt32 n)
 	assert(n <= m_size);
 
 	// if requesting no data then return NULL so we don't try to access
-	// an empty list.
+	// an empty ring.
 	if (n == 0) {
 		return NULL;
 	}
 
-	// reserve space in first chunk
-	ChunkList::iterator head = m_chunks.begin();
-	head->reserve(n + m_headUsed);
+	// return a pointer into the head chunk if it has all n bytes
+	const CChunk& head = getChunk(0);
+	if (head.m_end - head.m_begin >= n) {
+		return head.m_data + head.m_begin;
+	}
 
-	// consolidate chunks into the first chunk until it has n bytes
-	ChunkList::iterator scan = head;
-	++scan;
-	while (head->size() - m_headUsed < n && scan != m_chunks.end()) {
-		head->insert(head->end(), scan->begin(), scan->end());
-		scan = m_chunks.erase(scan);
+	// otherwise gather the bytes into the peek buffer
+	m_peek.resize(n);
+	UInt8* dst = &m_peek[0];
+	for (UInt32 i = 0; n > 0; ++i) {
+		const CChunk& chunk = getChunk(i);
+		UInt32 count = chunk.m_end - chunk.m_begin;
+		if (count > n) {
+			count = n;
+		}
+		memcpy(dst, chunk.m_data + chunk.m_begin, count);
+		dst += count;
+		n   -= count;
 	}
+	return &m_peek[0];
+}
+
+UInt32
+CStreamBuffer::peekChunks(IArchNetwork::CIOVec* vec, UInt32 num) const
+{
+	assert(vec != NULL || num == 0);
 
-	return reinterpret_cast<const void*>(&(head->begin()[m_headUsed]));
+	// skip empty chunks.  only the tail chunk can be empty.
+	UInt32 n = 0;
+	for (UInt32 i = 0; n < num && i < m_count; ++i) {
+		const CChunk& chunk = getChunk(i);
+		if (chunk.m_end != chunk.m_begin) {
+			vec[n].m_data = chunk.m_data + chunk.m_begin;
+			vec[n].m_size = chunk.m_end - chunk.m_begin;
+			++n;
+		}
+	}
+	return n;
 }
 
 void
@@ -63,29 +96,52 @@ CStreamBuffer::pop(UInt32 n)
 {
 	// discard all chunks if n is greater than or equal to m_size
 	if (n >= m_size) {
-		m_size     = 0;
-		m_headUsed = 0;
-		m_chunks.clear();
+		while (m_count > 0) {
+			freeChunk(popChunk());
+		}
+		m_size = 0;
 		return;
 	}
 
 	// update size
 	m_size -= n;
 
-	// discard chunks until more than n bytes would've been discarded
-	ChunkList::iterator scan = m_chunks.begin();
-	assert(scan != m_chunks.end());
-	while (scan->size() - m_headUsed <= n) {
-		n         -= scan->size() - m_headUsed;
-		m_headUsed = 0;
-		scan       = m_chunks.erase(scan);
-		assert(scan != m_chunks.end());
+	// discard chunks until more than n bytes would've been discarded.
+	// there's always data left over since n < m_size.
+	while (n > 0) {
+		CChunk& head = getChunk(0);
+		if (head.m_end - head.m_begin <= n) {
+			n -= head.m_end - head.m_begin;
+			freeChunk(popChunk());
+		}
+		else {
+			// remove left over bytes from the head chunk
+			head.m_begin += n;
+			n             = 0;
+		}
 	}
+}
 
-	// remove left over bytes from the head chunk
-	if (n > 0) {
-		m_headUsed += n;
+void
+CStreamBuffer::read(void* vdata, UInt32 n)
+{
+	assert(vdata != NULL || n == 0);
+	assert(n <= m_size);
+
+	// copy out of each chunk in turn
+	UInt8* data = reinterpret_cast<UInt8*>(vdata);
+	UInt32 left = n;
+	for (UInt32 i = 0; left > 0; ++i) {
+		const CChunk& chunk = getChunk(i);
+		UInt32 count = chunk.m_end - chunk.m_begin;
+		if (count > left) {
+			count = left;
+		}
+		memcpy(data, chunk.m_data + chunk.m_begin, count);
+		data += count;
+		left -= count;
 	}
+	pop(n);
 }
 
 void
@@ -93,45 +149,95 @@ CStreamBuffer::write(const void* vdata, UInt32 n)
 {
 	assert(vdata != NULL);
 
-	// ignore if no data, otherwise update size
-	if (n == 0) {
-		return;
-	}
-	m_size += n;
-
 	// cast data to bytes
 	const UInt8* data = reinterpret_cast<const UInt8*>(vdata);
 
-	// point to last chunk if it has space, otherwise append an empty chunk
-	ChunkList::iterator scan = m_chunks.end();
-	if (scan != m_chunks.begin()) {
-		--scan;
-		if (scan->size() >= kChunkSize) {
-			++scan;
+	// append data, adding a chunk whenever the tail chunk is full
+	m_size += n;
+	while (n > 0) {
+		if (m_count == 0 || getChunk(m_count - 1).m_end == kChunkSize) {
+			pushChunk();
 		}
-	}
-	if (scan == m_chunks.end()) {
-		scan = m_chunks.insert(scan, Chunk());
-	}
 
-	// append data in chunks
-	while (n > 0) {
-		// choose number of bytes for next chunk
-		assert(scan->size() <= kChunkSize);
-		UInt32 count = kChunkSize - scan->size();
-		if (count > n)
+		// choose number of bytes for the tail chunk
+		CChunk& tail = getChunk(m_count - 1);
+		UInt32 count = kChunkSize - tail.m_end;
+		if (count > n) {
 			count = n;
+		}
 
 		// transfer data
-		scan->insert(scan->end(), data, data + count);
-		n    -= count;
-		data += count;
+		memcpy(tail.m_data + tail.m_end, data, count);
+		tail.m_end += count;
+		n          -= count;
+		data       += count;
+	}
+}
+
+void*
+CStreamBuffer::reserve(UInt32& n)
+{
+	if (m_count == 0 || getChunk(m_count - 1).m_end == kChunkSize) {
+		pushChunk();
+	}
+	CChunk& tail = getChunk(m_count - 1);
+	n = kChunkSize - tail.m_end;
+	return tail.m_data + tail.m_end;
+}
+
+void
+CStreamBuffer::commit(UInt32 n)
+{
+	if (n == 0) {
+		return;
+	}
+
+	CChunk& tail = getChunk(m_count - 1);
+	assert(tail.m_end + n <= kChunkSize);
+	tail.m_end += n;
+	m_size     += n;
+}
+
+void
+CStreamBuffer::splice(CStreamBuffer& src, UInt32 n)
+{
+	assert(&src != this);
+
+	if (n > src.m_size) {
+		n = src.m_size;
+	}
 
-		// append another empty chunk if we're not done yet
-		if (n > 0) {
-			++scan;
-			scan = m_chunks.insert(scan, Chunk());
+	// move whole chunks
+	while (n > 0) {
+		const CChunk& head = src.getChunk(0);
+		UInt32 count = head.m_end - head.m_begin;
+		if (count > n) {
+			break;
 		}
+		pushChunk(head.m_data, head.m_begin, head.m_end);
+		m_size     += count;
+		src.m_size -= count;
+		n          -= count;
+		src.popChunk();
+	}
+
+	// copy what's left of the range.  it's less than a chunk.
+	if (n > 0) {
+		const CChunk& head = src.getChunk(0);
+		write(head.m_data + head.m_begin, n);
+		src.pop(n);
+	}
+
+	// drop src's chunks if it's now empty so it starts afresh
+	if (src.m_size == 0) {
+		src.pop(0);
+	}
+
+	// src will need chunks to replace the ones we took and we'll have
+	// spare chunks once our data is read so give it ours
+	while (!m_free.empty() && src.m_free.size() < kMaxFreeChunks) {
+		src.m_free.push_back(m_free.back());
+		m_free.pop_back();
 	}
 }
 
@@ -140,3 +246,75 @@ CStreamBuffer::getSize() const
 {
 	return m_size;
 }
+
+CStreamBuffer::CChunk&
+CStreamBuffer::getChunk(UInt32 index)
+{
+	assert(index < m_count);
+	return m_ring[(m_head + index) & (m_ring.size() - 1)];
+}
+
+const CStreamBuffer::CChunk&
+CStreamBuffer::getChunk(UInt32 index) const
+{
+	assert(index < m_count);
+	return m_ring[(m_head + index) & (m_ring.size() - 1)];
+}
+
+void
+CStreamBuffer::pushChunk(UInt8* data, UInt32 begin, UInt32 end)
+{
+	// grow the ring if it's full, unwrapping the chunks as we go
+	if (m_count == m_ring.size()) {
+		ChunkList ring(m_ring.empty() ? 4 : 2 * m_ring.size());
+		for (UInt32 i = 0; i < m_count; ++i) {
+			ring[i] = getChunk(i);
+		}
+		m_ring.swap(ring);
+		m_head = 0;
+	}
+
+	CChunk& chunk = m_ring[(m_head + m_count) & (m_ring.size() - 1)];
+	chunk.m_data  = data;
+	chunk.m_begin = begin;
+	chunk.m_end   = end;
+	++m_count;
+}
+
+void
+CStreamBuffer::pushChunk()
+{
+	// reuse a free chunk if we have one
+	UInt8* data;
+	if (!m_free.empty()) {
+		data = m_free.back();
+		m_free.pop_back();
+	}
+	else {
+		data = new UInt8[kChunkSize];
+	}
+	pushChunk(data, 0, 0);
+}
+
+UInt8*
+CStreamBuffer::popChunk()
+{
+	assert(m_count > 0);
+
+	UInt8* data = m_ring[m_head].m_data;
+	m_head = (m_head + 1) & (m_ring.size() - 1);
+	--m_count;
+	return data;
+}
+
+void
+CStreamBuffer::freeChunk(UInt8* data)
+{
+	// keep the chunk for reuse unless we already have plenty
+	if (m_free.size() < kMaxFreeChunks) {
+		m_free.push_back(data);
+	}
+	else {
+		delete[] data;
+	}
+}
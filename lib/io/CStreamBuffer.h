@@ -16,12 +16,14 @@
 #define CSTREAMBUFFER_H
 
 #include "BasicTypes.h"
-#include "stdlist.h"
+#include "IArchNetwork.h"
 #include "stdvector.h"
 
 //! FIFO of bytes
 /*!
-This class maintains a FIFO (first-in, last-out) buffer of bytes.
+This class maintains a FIFO (first-in, last-out) buffer of bytes.  The
+data is kept in a ring of fixed size chunks.  Chunks that empty out are
+kept for reuse so a buffer with steady traffic stops allocating.
 */
 class CStreamBuffer {
 public:
@@ -35,10 +37,21 @@ public:
 	/*!
 	Return a pointer to memory with the next \c n bytes in the buffer
 	(which must be <= getSize()).  The caller must not modify the returned
-	memory nor delete it.
+	memory nor delete it and it's only valid until the buffer is next
+	changed.  This doesn't copy unless the bytes span more than one chunk.
 	*/
 	const void*			peek(UInt32 n);
 
+	//! Read data without removing from buffer or copying
+	/*!
+	Fills in up to \c num entries of \c vec with the buffer's chunks
+	of data, in order, and returns the number of entries filled in.
+	Unlike \c peek() this never moves data.  The caller must not modify
+	the memory nor delete it and it's only valid until the buffer is
+	next changed.
+	*/
+	UInt32				peekChunks(IArchNetwork::CIOVec* vec, UInt32 num) const;
+
 	//! Discard data
 	/*!
 	Discards the next \c n bytes.  If \c n >= getSize() then the buffer
@@ -46,12 +59,46 @@ public:
 	*/
 	void				pop(UInt32 n);
 
+	//! Read data
+	/*!
+	Copies the next \c n bytes (which must be <= getSize()) to \c data
+	and discards them.  Unlike \c peek() this copies straight out of the
+	chunks even if the bytes span more than one.
+	*/
+	void				read(void* data, UInt32 n);
+
 	//! Write data to buffer
 	/*!
 	Appends \c n bytes from \c data to the buffer.
 	*/
 	void				write(const void* data, UInt32 n);
 
+	//! Get space to write into
+	/*!
+	Returns a pointer to free space at the end of the buffer and sets
+	\c n to the number of bytes available there, which is never zero.
+	Bytes stored there become part of the buffer when passed to
+	\c commit().  The space is only valid until the buffer is next
+	changed.
+	*/
+	void*				reserve(UInt32& n);
+
+	//! Append reserved space
+	/*!
+	Appends the first \c n bytes of the space returned by the last call
+	to \c reserve().
+	*/
+	void				commit(UInt32 n);
+
+	//! Move data from another buffer
+	/*!
+	Removes the first \c n bytes of \c src (or all of it if \c n >=
+	src.getSize()) and appends them to this buffer.  Whole chunks are
+	moved rather than copied, so only a partial chunk at the end of the
+	range is copied.
+	*/
+	void				splice(CStreamBuffer& src, UInt32 n);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -64,15 +111,43 @@ public:
 
 	//@}
 
+private:
+	// not implemented
+	CStreamBuffer(const CStreamBuffer&);
+	CStreamBuffer&		operator=(const CStreamBuffer&);
+
+	class CChunk {
+	public:
+		UInt8*			m_data;
+		UInt32			m_begin;
+		UInt32			m_end;
+	};
+	typedef std::vector<CChunk> ChunkList;
+	typedef std::vector<UInt8*> FreeList;
+
+	CChunk&				getChunk(UInt32 index);
+	const CChunk&		getChunk(UInt32 index) const;
+	void				pushChunk(UInt8* data, UInt32 begin, UInt32 end);
+	void				pushChunk();
+	UInt8*				popChunk();
+	void				freeChunk(UInt8*);
+
 private:
 	static const UInt32	kChunkSize;
+	static const UInt32	kMaxFreeChunks;
+
+	// ring of chunks.  m_ring.size() is zero or a power of two.
+	ChunkList			m_ring;
+	UInt32				m_head;
+	UInt32				m_count;
+
+	// chunks available for reuse
+	FreeList			m_free;
 
-	typedef std::vector<UInt8> Chunk;
-	typedef std::list<Chunk> ChunkList;
+	// holds the result of peek() when it spans chunks
+	std::vector<UInt8>	m_peek;
 
-	ChunkList			m_chunks;
 	UInt32				m_size;
-	UInt32				m_headUsed;
 };
 
 #endif
@@ -51,6 +51,18 @@ CStreamFilter::read(void* buffer, UInt32 n)
 	return getStream()->read(buffer, n);
 }
 
+UInt32
+CStreamFilter::readInto(CStreamBuffer& buffer)
+{
+	return getStream()->readInto(buffer);
+}
+
+const void*
+CStreamFilter::peek(UInt32 n)
+{
+	return getStream()->peek(n);
+}
+
 void
 CStreamFilter::write(const void* buffer, UInt32 n)
 {
@@ -93,6 +105,12 @@ CStreamFilter::getSize() const
 	return getStream()->getSize();
 }
 
+UInt32
+CStreamFilter::getOutputSize() const
+{
+	return getStream()->getOutputSize();
+}
+
 IStream*
 CStreamFilter::getStream() const
 {
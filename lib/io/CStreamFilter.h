@@ -37,6 +37,8 @@ public:
 	// Override as necessary.  getEventTarget returns a pointer to this.
 	virtual void		close();
 	virtual UInt32		read(void* buffer, UInt32 n);
+	virtual UInt32		readInto(CStreamBuffer& buffer);
+	virtual const void*	peek(UInt32 n);
 	virtual void		write(const void* buffer, UInt32 n);
 	virtual void		flush();
 	virtual void		shutdownInput();
@@ -44,6 +46,7 @@ public:
 	virtual void*		getEventTarget() const;
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
+	virtual UInt32		getOutputSize() const;
 
 protected:
 	//! Get the stream
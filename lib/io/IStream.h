@@ -18,6 +18,8 @@
 #include "IInterface.h"
 #include "CEvent.h"
 
+class CStreamBuffer;
+
 //! Bidirectional stream interface
 /*!
 Defines the interface for all streams.
@@ -45,6 +47,26 @@ public:
 	*/
 	virtual UInt32		read(void* buffer, UInt32 n) = 0;
 
+	//! Read from stream into a buffer
+	/*!
+	Moves all the data an immediate \c read() could return onto the end
+	of \p buffer, returning the number of bytes moved.  Streams that
+	buffer their input hand over the buffered data without copying it
+	where possible.
+	*/
+	virtual UInt32		readInto(CStreamBuffer& buffer) = 0;
+
+	//! Look at buffered input
+	/*!
+	Returns a pointer to the next \p n bytes an immediate \c read()
+	would return without removing them, or NULL if \p n is zero.
+	\p n must be no more than \c getSize().  The memory belongs to the
+	stream and is only valid until the next read.  Streams that buffer
+	their input point into the buffer, copying only if the bytes are
+	split across its chunks.
+	*/
+	virtual const void*	peek(UInt32 n) = 0;
+
 	//! Write to stream
 	/*!
 	Write \c n bytes from \c buffer to the stream.  If this can't
@@ -103,6 +125,16 @@ public:
 	*/
 	virtual UInt32		getSize() const = 0;
 
+	//! Get bytes waiting to be written
+	/*!
+	Returns the number of bytes written to the stream that are queued
+	because the underlying transport can't take them yet.  A stream
+	where this grows is falling behind.  Streams that can't tell return
+	zero.  When the queue empties the stream sends an output flushed
+	event.
+	*/
+	virtual UInt32		getOutputSize() const = 0;
+
 	//! Get input ready event type
 	/*!
 	Returns the input ready event type.  A stream sends this event
@@ -0,0 +1,120 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CLossyDatagramSocket.h"
+#include "CLog.h"
+#include "CArch.h"
+
+//
+// CLossyDatagramSocket
+//
+
+CLossyDatagramSocket::CLossyDatagramSocket(
+				IDatagramSocket* socket, double loss) :
+	m_socket(socket),
+	m_count(0),
+	m_dropped(0)
+{
+	assert(m_socket != NULL);
+
+	// drop a datagram when a random 32-bit number is below the threshold
+	if (loss <= 0.0) {
+		m_threshold = 0;
+	}
+	else if (loss >= 1.0) {
+		m_threshold = 0xffffffffu;
+	}
+	else {
+		m_threshold = static_cast<UInt32>(loss * 4294967296.0);
+	}
+	ARCH->getRandom(&m_random, sizeof(m_random));
+	if (m_random == 0) {
+		m_random = 1;
+	}
+	LOG((CLOG_NOTE "dropping %.0f%% of datagrams", 100.0 * loss));
+}
+
+CLossyDatagramSocket::~CLossyDatagramSocket()
+{
+	LOG((CLOG_DEBUG "dropped %d of %d datagrams", m_dropped, m_count));
+	delete m_socket;
+}
+
+UInt32
+CLossyDatagramSocket::getCount() const
+{
+	return m_count;
+}
+
+UInt32
+CLossyDatagramSocket::getDroppedCount() const
+{
+	return m_dropped;
+}
+
+void
+CLossyDatagramSocket::bind(const CNetworkAddress& addr)
+{
+	m_socket->bind(addr);
+}
+
+void
+CLossyDatagramSocket::close()
+{
+	m_socket->close();
+}
+
+void*
+CLossyDatagramSocket::getEventTarget() const
+{
+	// the wrapped socket sends the events
+	return m_socket->getEventTarget();
+}
+
+bool
+CLossyDatagramSocket::send(const void* buffer, UInt32 n,
+				const CNetworkAddress& addr)
+{
+	if (drop()) {
+		// a lost datagram looks sent to the sender
+		return true;
+	}
+	return m_socket->send(buffer, n, addr);
+}
+
+UInt32
+CLossyDatagramSocket::receive(void* buffer, UInt32 n, CNetworkAddress* addr)
+{
+	UInt32 size;
+	while ((size = m_socket->receive(buffer, n, addr)) != 0 && drop()) {
+		// discard and try the next datagram
+	}
+	return size;
+}
+
+bool
+CLossyDatagramSocket::drop()
+{
+	++m_count;
+
+	// xorshift is plenty random for simulating loss
+	m_random ^= m_random << 13;
+	m_random ^= m_random >> 17;
+	m_random ^= m_random << 5;
+	if (m_random < m_threshold) {
+		++m_dropped;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,77 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CLOSSYDATAGRAMSOCKET_H
+#define CLOSSYDATAGRAMSOCKET_H
+
+#include "IDatagramSocket.h"
+
+//! Lossy datagram socket
+/*!
+A datagram socket that drops a fraction of the datagrams sent and
+received through another datagram socket.  It's for testing how the
+motion side channel copes with packet loss over loopback, where
+nothing is ever lost.  Debug builds wrap every datagram socket the
+TCP socket factory makes in one when SYNERGY_DATAGRAM_LOSS is set to
+the percentage of datagrams to drop.
+*/
+class CLossyDatagramSocket : public IDatagramSocket {
+public:
+	/*!
+	Drops the fraction \p loss, from 0 to 1, of datagrams sent or
+	received through \p adoptedSocket.
+	*/
+	CLossyDatagramSocket(IDatagramSocket* adoptedSocket, double loss);
+	~CLossyDatagramSocket();
+
+	//! @name accessors
+	//@{
+
+	//! Get number of datagrams
+	/*!
+	Returns the number of datagrams sent and received.
+	*/
+	UInt32				getCount() const;
+
+	//! Get number of dropped datagrams
+	/*!
+	Returns the number of datagrams dropped.
+	*/
+	UInt32				getDroppedCount() const;
+
+	//@}
+
+	// ISocket overrides
+	virtual void		bind(const CNetworkAddress&);
+	virtual void		close();
+	virtual void*		getEventTarget() const;
+
+	// IDatagramSocket overrides
+	virtual bool		send(const void* buffer, UInt32 n,
+							const CNetworkAddress& address);
+	virtual UInt32		receive(void* buffer, UInt32 n,
+							CNetworkAddress* address);
+
+private:
+	bool				drop();
+
+private:
+	IDatagramSocket*	m_socket;
+	UInt32				m_threshold;
+	UInt32				m_random;
+	UInt32				m_count;
+	UInt32				m_dropped;
+};
+
+#endif
@@ -43,6 +43,14 @@ CNetworkAddress::CNetworkAddress(int port) :
 	ARCH->setAddrPort(m_address, m_port);
 }
 
+CNetworkAddress::CNetworkAddress(CArchNetAddress addr) :
+	m_address(ARCH->copyAddr(addr)),
+	m_hostname(ARCH->addrToString(addr)),
+	m_port(ARCH->getAddrPort(addr))
+{
+	// do nothing
+}
+
 CNetworkAddress::CNetworkAddress(const CNetworkAddress& addr) :
 	m_address(addr.m_address != NULL ? ARCH->copyAddr(addr.m_address) : NULL),
 	m_hostname(addr.m_hostname),
@@ -174,6 +182,21 @@ CNetworkAddress::operator!=(const CNetworkAddress& addr) const
 	return !operator==(addr);
 }
 
+bool
+CNetworkAddress::isSameHost(const CNetworkAddress& addr) const
+{
+	if (!isValid() || !addr.isValid()) {
+		return false;
+	}
+
+	// compare with a copy of addr on our port
+	CArchNetAddress tmp = ARCH->copyAddr(addr.m_address);
+	ARCH->setAddrPort(tmp, ARCH->getAddrPort(m_address));
+	const bool same = ARCH->isEqualAddr(m_address, tmp);
+	ARCH->closeAddr(tmp);
+	return same;
+}
+
 bool
 CNetworkAddress::isValid() const
 {
@@ -48,6 +48,13 @@ public:
 	*/
 	CNetworkAddress(const CString& hostname, int port);
 
+	/*!
+	Construct a copy of the platform's native network address structure
+	\c address, such as the sender of a datagram.  The hostname is the
+	address in numerical form.
+	*/
+	CNetworkAddress(CArchNetAddress address);
+
 	CNetworkAddress(const CNetworkAddress&);
 
 	~CNetworkAddress();
@@ -82,6 +89,13 @@ public:
 	*/
 	bool				operator!=(const CNetworkAddress& address) const;
 
+	//! Check host equality
+	/*!
+	Returns true if this address and \p address are valid and are the
+	same host, whatever their ports.
+	*/
+	bool				isSameHost(const CNetworkAddress& address) const;
+
 	//! Check address validity
 	/*!
 	Returns true if this is not the invalid address.
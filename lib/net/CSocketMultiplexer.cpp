@@ -38,10 +38,20 @@ CSocketMultiplexer::CSocketMultiplexer() :
 	m_jobListLock(new CCondVar<bool>(m_mutex, false)),
 	m_jobListLockLocked(new CCondVar<bool>(m_mutex, false)),
 	m_jobListLocker(NULL),
-	m_jobListLockLocker(NULL)
+	m_jobListLockLocker(NULL),
+	m_pollSet(NULL)
 {
 	assert(s_instance == NULL);
 
+	// use a persistent poll set if the platform has one
+	try {
+		m_pollSet = ARCH->newPollSet();
+	}
+	catch (XArchNetwork& e) {
+		LOG((CLOG_WARN "cannot create poll set: %s", e.what().c_str()));
+		m_pollSet = NULL;
+	}
+
 	// this pointer just has to be unique and not NULL.  it will
 	// never be dereferenced.  it's used to identify cursor nodes
 	// in the jobs list.
@@ -66,6 +76,9 @@ CSocketMultiplexer::~CSocketMultiplexer()
 	delete m_jobListLocker;
 	delete m_jobListLockLocker;
 	delete m_mutex;
+	if (m_pollSet != NULL) {
+		ARCH->closePollSet(m_pollSet);
+	}
 
 	// clean up jobs
 	for (CSocketJobMap::iterator i = m_socketJobMap.begin();
@@ -98,22 +111,31 @@ CSocketMultiplexer::addSocket(ISocket* socket, ISocketMultiplexerJob* job)
 	lockJobList();
 
 	// insert/replace job
-	CSocketJobMap::iterator i = m_socketJobMap.find(socket);
-	if (i == m_socketJobMap.end()) {
-		// we *must* put the job at the end so the order of jobs in
-		// the list continue to match the order of jobs in pfds in
-		// serviceThread().
-		CJobCursor j = m_socketJobs.insert(m_socketJobs.end(), job);
-		m_update     = true;
-		m_socketJobMap.insert(std::make_pair(socket, j));
-	}
-	else {
-		CJobCursor j = i->second;
-		if (*j != job) {
-			delete *j;
-			*j = job;
+	{
+		CLock lock(m_mutex);
+		CSocketJobMap::iterator i = m_socketJobMap.find(socket);
+		if (i == m_socketJobMap.end()) {
+			// we *must* put the job at the end so the order of jobs in
+			// the list continue to match the order of jobs in pfds in
+			// serviceThread().
+			CJobCursor j = m_socketJobs.insert(m_socketJobs.end(), job);
+			m_update     = true;
+			m_socketJobMap.insert(std::make_pair(socket, j));
+			updatePollSet(&*j);
+		}
+		else {
+			CJobCursor j = i->second;
+			if (*j != job) {
+				if (m_pollSet != NULL && *j != NULL &&
+					(*j)->getSocket() != job->getSocket()) {
+					ARCH->removePollSetSocket(m_pollSet, (*j)->getSocket());
+				}
+				delete *j;
+				*j = job;
+			}
+			m_update = true;
+			updatePollSet(&*j);
 		}
-		m_update = true;
 	}
 
 	// unlock the job list
@@ -137,12 +159,19 @@ CSocketMultiplexer::removeSocket(ISocket* socket)
 	// remove job.  rather than removing it from the map we put NULL
 	// in the list instead so the order of jobs in the list continues
 	// to match the order of jobs in pfds in serviceThread().
-	CSocketJobMap::iterator i = m_socketJobMap.find(socket);
-	if (i != m_socketJobMap.end()) {
-		if (*(i->second) != NULL) {
-			delete *(i->second);
-			*(i->second) = NULL;
-			m_update     = true;
+	{
+		CLock lock(m_mutex);
+		CSocketJobMap::iterator i = m_socketJobMap.find(socket);
+		if (i != m_socketJobMap.end()) {
+			if (*(i->second) != NULL) {
+				if (m_pollSet != NULL) {
+					ARCH->removePollSetSocket(m_pollSet,
+									(*(i->second))->getSocket());
+				}
+				delete *(i->second);
+				*(i->second) = NULL;
+				m_update     = true;
+			}
 		}
 	}
 
@@ -150,11 +179,46 @@ CSocketMultiplexer::removeSocket(ISocket* socket)
 	unlockJobList();
 }
 
+bool
+CSocketMultiplexer::setJobInterest(ISocket* socket,
+				ISocketMultiplexerJob* job, bool readable, bool writable)
+{
+	assert(socket != NULL);
+	assert(job    != NULL);
+
+	CLock lock(m_mutex);
+
+	// the job must be installed.  we can't touch a job that's not in
+	// the list because it may have been deleted.
+	CSocketJobMap::iterator i = m_socketJobMap.find(socket);
+	if (i == m_socketJobMap.end() || *(i->second) != job) {
+		return false;
+	}
+
+	// nothing to do if the interest isn't changing
+	if (job->isReadable() == readable && job->isWritable() == writable) {
+		return true;
+	}
+	job->setInterest(readable, writable);
+
+	// change the interest in place in the poll set.  without a poll
+	// set the service thread must rebuild its poll entries.
+	if (m_pollSet != NULL) {
+		updatePollSet(&*(i->second));
+	}
+	else {
+		m_update = true;
+		m_thread->unblockPollSocket();
+	}
+	return true;
+}
+
 void
 CSocketMultiplexer::serviceThread(void*)
 {
 	std::vector<IArchNetwork::CPollEntry> pfds;
 	IArchNetwork::CPollEntry pfd;
+	std::vector<IArchNetwork::CPollSetEntry> ready(64);
 
 	// service the connections
 	for (;;) {
@@ -172,9 +236,13 @@ CSocketMultiplexer::serviceThread(void*)
 		lockJobListLock();
 		lockJobList();
 
-		// collect poll entries
-		if (m_update) {
-			m_update = false;
+		// with a poll set the interest of each socket is already
+		// registered so we only have to wait and run the ready jobs.
+		// otherwise collect poll entries.
+		if (m_pollSet != NULL) {
+			servicePollSet(&ready[0], ready.size());
+		}
+		else if (checkUpdate()) {
 			pfds.clear();
 			pfds.reserve(m_socketJobMap.size());
 
@@ -183,6 +251,8 @@ CSocketMultiplexer::serviceThread(void*)
 			while (jobCursor != m_socketJobs.end()) {
 				ISocketMultiplexerJob* job = *jobCursor;
 				if (job != NULL) {
+					// interest can change in setJobInterest()
+					CLock lock(m_mutex);
 					pfd.m_socket = job->getSocket();
 					pfd.m_events = 0;
 					if (job->isReadable()) {
@@ -201,7 +271,11 @@ CSocketMultiplexer::serviceThread(void*)
 		int status;
 		try {
 			// check for status
-			if (!pfds.empty()) {
+			if (m_pollSet != NULL) {
+				// already serviced
+				status = 0;
+			}
+			else if (!pfds.empty()) {
 				status = ARCH->pollSocket(&pfds[0], pfds.size(), -1);
 			}
 			else {
@@ -249,14 +323,18 @@ CSocketMultiplexer::serviceThread(void*)
 		}
 
 		// delete any removed socket jobs
-		for (CSocketJobMap::iterator i = m_socketJobMap.begin();
-							i != m_socketJobMap.end();) {
-			if (*(i->second) == NULL) {
-				m_socketJobMap.erase(i++);
-				m_update = true;
-			}
-			else {
-				++i;
+		{
+			CLock lock(m_mutex);
+			for (CSocketJobMap::iterator i = m_socketJobMap.begin();
+								i != m_socketJobMap.end();) {
+				if (*(i->second) == NULL) {
+					m_socketJobs.erase(i->second);
+					m_socketJobMap.erase(i++);
+					m_update = true;
+				}
+				else {
+					++i;
+				}
 			}
 		}
 
@@ -265,6 +343,83 @@ CSocketMultiplexer::serviceThread(void*)
 	}
 }
 
+void
+CSocketMultiplexer::servicePollSet(IArchNetwork::CPollSetEntry* ready, int num)
+{
+	int n;
+	try {
+		n = ARCH->waitPollSet(m_pollSet, ready, num, -1);
+	}
+	catch (XArchNetwork& e) {
+		LOG((CLOG_WARN "error in socket multiplexer: %s", e.what().c_str()));
+		n = 0;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		ISocketMultiplexerJob** slot =
+			reinterpret_cast<ISocketMultiplexerJob**>(ready[i].m_userData);
+
+		// skip jobs removed since the wait began
+		ISocketMultiplexerJob* job = *slot;
+		if (job == NULL) {
+			continue;
+		}
+
+		// get poll state
+		unsigned short revents = ready[i].m_revents;
+		bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
+		bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
+		bool error = ((revents & (IArchNetwork::kPOLLERR |
+								  IArchNetwork::kPOLLNVAL)) != 0);
+
+		// run job
+		ISocketMultiplexerJob* newJob = job->run(read, write, error);
+
+		// save job, if different, and update its interest in place
+		if (newJob != job) {
+			CLock lock(m_mutex);
+			if (newJob == NULL || newJob->getSocket() != job->getSocket()) {
+				ARCH->removePollSetSocket(m_pollSet, job->getSocket());
+			}
+			delete job;
+			*slot = newJob;
+			updatePollSet(slot);
+		}
+	}
+}
+
+void
+CSocketMultiplexer::updatePollSet(ISocketMultiplexerJob** slot)
+{
+	ISocketMultiplexerJob* job = *slot;
+	if (m_pollSet == NULL || job == NULL) {
+		return;
+	}
+
+	unsigned short events = 0;
+	if (job->isReadable()) {
+		events |= IArchNetwork::kPOLLIN;
+	}
+	if (job->isWritable()) {
+		events |= IArchNetwork::kPOLLOUT;
+	}
+	try {
+		ARCH->setPollSetEvents(m_pollSet, job->getSocket(), events, slot);
+	}
+	catch (XArchNetwork& e) {
+		LOG((CLOG_WARN "error in socket multiplexer: %s", e.what().c_str()));
+	}
+}
+
+bool
+CSocketMultiplexer::checkUpdate()
+{
+	CLock lock(m_mutex);
+	bool update = m_update;
+	m_update    = false;
+	return update;
+}
+
 CSocketMultiplexer::CJobCursor
 CSocketMultiplexer::newCursor()
 {
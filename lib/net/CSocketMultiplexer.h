@@ -42,6 +42,20 @@ public:
 
 	void				removeSocket(ISocket*);
 
+	//! Change the interest of a socket's job in place
+	/*!
+	Changes the readability and writability interest of \c job, the
+	job for \c socket, without allocating a new job and without
+	locking the job list.  Returns false and changes nothing if \c job
+	isn't the job currently installed for \c socket, for example if
+	it was just returned from \c run() and hasn't replaced the old job
+	yet.  The caller must then install a new job with \c addSocket().
+	Unlike \c addSocket() this may be called from a job's \c run().
+	*/
+	bool				setJobInterest(ISocket* socket,
+							ISocketMultiplexerJob* job,
+							bool readable, bool writable);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -62,9 +76,25 @@ private:
 	// service sockets.  the service thread will only access m_sockets
 	// and m_update while m_pollable and m_polling are true.  all other
 	// threads must only modify these when m_pollable and m_polling are
-	// false.  only the service thread sets m_polling.
+	// false.  only the service thread sets m_polling.  the job map,
+	// the jobs in the job list and m_update are also only changed with
+	// m_mutex locked so setJobInterest() can use them without locking
+	// the job list.
 	void				serviceThread(void*);
 
+	// wait on and service the sockets in m_pollSet.  only ready jobs
+	// are run.  the job list must be locked.
+	void				servicePollSet(IArchNetwork::CPollSetEntry* ready,
+							int num);
+
+	// register the interest of the job in list slot \c slot with
+	// m_pollSet.  does nothing if there's no poll set or no job.  the
+	// job list must be locked.
+	void				updatePollSet(ISocketMultiplexerJob** slot);
+
+	// return m_update and clear it
+	bool				checkUpdate();
+
 	// create, iterate, and destroy a cursor.  a cursor is used to
 	// safely iterate through the job list while other threads modify
 	// the list.  it works by inserting a dummy item in the list and
@@ -105,6 +135,12 @@ private:
 	CSocketJobMap		m_socketJobMap;
 	ISocketMultiplexerJob*	m_cursorMark;
 
+	// persistent poll set or NULL if the platform doesn't support them.
+	// each job's socket is registered with the address of its slot in
+	// m_socketJobs as the user data.  list nodes don't move so the
+	// slot address is stable until the node is erased.
+	CArchPollSet		m_pollSet;
+
 	static CSocketMultiplexer*	s_instance;
 };
 
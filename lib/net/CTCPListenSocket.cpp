@@ -102,8 +102,14 @@ IDataSocket*
 CTCPListenSocket::accept()
 {
 	try {
-		IDataSocket* socket =
-			new CTCPSocket(ARCH->acceptSocket(m_socket, NULL));
+		CArchNetAddress addr = NULL;
+		CArchSocket s = ARCH->acceptSocket(m_socket, &addr);
+		CNetworkAddress peer;
+		if (addr != NULL) {
+			peer = CNetworkAddress(addr);
+			ARCH->closeAddr(addr);
+		}
+		IDataSocket* socket = new CTCPSocket(s, peer);
 		if (socket != NULL) {
 			CSocketMultiplexer::getInstance()->addSocket(this,
 							new TSocketMultiplexerMethodJob<CTCPListenSocket>(
@@ -43,9 +43,10 @@ CTCPSocket::CTCPSocket() :
 	init();
 }
 
-CTCPSocket::CTCPSocket(CArchSocket socket) :
+CTCPSocket::CTCPSocket(CArchSocket socket, const CNetworkAddress& peer) :
 	m_mutex(),
 	m_socket(socket),
+	m_peer(peer),
 	m_flushed(&m_mutex, true)
 {
 	assert(m_socket != NULL);
@@ -87,6 +88,12 @@ CTCPSocket::close()
 	setJob(NULL);
 
 	CLock lock(&m_mutex);
+	m_job = NULL;
+	if (m_writeCount > 0) {
+		LOG((CLOG_DEBUG1 "socket wrote %u of %u writes without queueing", m_writeThroughCount, m_writeCount));
+		m_writeCount        = 0;
+		m_writeThroughCount = 0;
+	}
 
 	// clear buffers and enter disconnected state
 	if (m_connected) {
@@ -123,24 +130,39 @@ CTCPSocket::read(void* buffer, UInt32 n)
 	if (n > size) {
 		n = size;
 	}
-	if (buffer != NULL && n != 0) {
-		memcpy(buffer, m_inputBuffer.peek(n), n);
+	if (buffer != NULL) {
+		m_inputBuffer.read(buffer, n);
 	}
-	m_inputBuffer.pop(n);
-
-	// if no more data and we cannot read or write then send disconnected
-	if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
-		sendEvent(getDisconnectedEvent());
-		m_connected = false;
+	else {
+		m_inputBuffer.pop(n);
 	}
+	onInputRead(n);
+	return n;
+}
 
+UInt32
+CTCPSocket::readInto(CStreamBuffer& buffer)
+{
+	// hand over our input buffer's chunks
+	CLock lock(&m_mutex);
+	UInt32 n = m_inputBuffer.getSize();
+	buffer.splice(m_inputBuffer, n);
+	onInputRead(n);
 	return n;
 }
 
+const void*
+CTCPSocket::peek(UInt32 n)
+{
+	CLock lock(&m_mutex);
+	return m_inputBuffer.peek(n);
+}
+
 void
 CTCPSocket::write(const void* buffer, UInt32 n)
 {
-	bool wasEmpty;
+	bool useNewJob = false;
+	ISocketMultiplexerJob* job = NULL;
 	{
 		CLock lock(&m_mutex);
 
@@ -154,18 +176,50 @@ CTCPSocket::write(const void* buffer, UInt32 n)
 		if (n == 0) {
 			return;
 		}
+		++m_writeCount;
+
+		// if nothing is queued then try writing directly to the socket.
+		// that saves copying the data and waking the multiplexer thread.
+		// we don't send an output flushed event if everything is written
+		// since the output buffer never had anything in it.
+		bool wasEmpty = (m_outputBuffer.getSize() == 0);
+		if (wasEmpty && m_connected) {
+			IArchNetwork::CIOVec vec;
+			vec.m_data      = buffer;
+			vec.m_size      = n;
+			bool needNewJob = false;
+			UInt32 written  = writeSocket(&vec, 1, needNewJob);
+			if (needNewJob) {
+				// output was shutdown so the data is discarded
+				job       = newJob();
+				useNewJob = true;
+				written   = n;
+			}
+			else if (written == n) {
+				++m_writeThroughCount;
+			}
+			buffer = static_cast<const UInt8*>(buffer) + written;
+			n     -= written;
+		}
 
-		// copy data to the output buffer
-		wasEmpty = (m_outputBuffer.getSize() == 0);
-		m_outputBuffer.write(buffer, n);
+		// queue whatever the socket wouldn't take
+		if (n > 0) {
+			// copy data to the output buffer
+			m_outputBuffer.write(buffer, n);
 
-		// there's data to write
-		m_flushed = false;
-	}
+			// there's data to write
+			m_flushed = false;
 
-	// make sure we're waiting to write
-	if (wasEmpty) {
-		setJob(newJob());
+			// make sure we're waiting to write.  this normally just turns
+			// on write interest in our current job.
+			if (wasEmpty && !updateJob()) {
+				job       = newJob();
+				useNewJob = true;
+			}
+		}
+	}
+	if (useNewJob) {
+		setJob(job);
 	}
 }
 
@@ -182,6 +236,7 @@ void
 CTCPSocket::shutdownInput()
 {
 	bool useNewJob = false;
+	ISocketMultiplexerJob* job = NULL;
 	{
 		CLock lock(&m_mutex);
 
@@ -197,11 +252,12 @@ CTCPSocket::shutdownInput()
 		if (m_readable) {
 			sendEvent(getInputShutdownEvent());
 			onInputShutdown();
+			job       = newJob();
 			useNewJob = true;
 		}
 	}
 	if (useNewJob) {
-		setJob(newJob());
+		setJob(job);
 	}
 }
 
@@ -209,6 +265,7 @@ void
 CTCPSocket::shutdownOutput()
 {
 	bool useNewJob = false;
+	ISocketMultiplexerJob* job = NULL;
 	{
 		CLock lock(&m_mutex);
 
@@ -224,11 +281,12 @@ CTCPSocket::shutdownOutput()
 		if (m_writable) {
 			sendEvent(getOutputShutdownEvent());
 			onOutputShutdown();
+			job       = newJob();
 			useNewJob = true;
 		}
 	}
 	if (useNewJob) {
-		setJob(newJob());
+		setJob(job);
 	}
 }
 
@@ -246,9 +304,17 @@ CTCPSocket::getSize() const
 	return m_inputBuffer.getSize();
 }
 
+UInt32
+CTCPSocket::getOutputSize() const
+{
+	CLock lock(&m_mutex);
+	return m_outputBuffer.getSize();
+}
+
 void
 CTCPSocket::connect(const CNetworkAddress& addr)
 {
+	ISocketMultiplexerJob* job = NULL;
 	{
 		CLock lock(&m_mutex);
 
@@ -258,6 +324,7 @@ CTCPSocket::connect(const CNetworkAddress& addr)
 			return;
 		}
 
+		m_peer = addr;
 		try {
 			if (ARCH->connectSocket(m_socket, addr.getAddress())) {
 				sendEvent(getConnectedEvent());
@@ -271,17 +338,35 @@ CTCPSocket::connect(const CNetworkAddress& addr)
 		catch (XArchNetwork& e) {
 			throw XSocketConnect(e.what());
 		}
+		job = newJob();
 	}
-	setJob(newJob());
+	setJob(job);
+}
+
+CNetworkAddress
+CTCPSocket::getPeerAddress() const
+{
+	CLock lock(&m_mutex);
+	return m_peer;
+}
+
+UInt32
+CTCPSocket::getWriteThroughCount() const
+{
+	CLock lock(&m_mutex);
+	return m_writeThroughCount;
 }
 
 void
 CTCPSocket::init()
 {
 	// default state
-	m_connected = false;
-	m_readable  = false;
-	m_writable  = false;
+	m_job               = NULL;
+	m_connected         = false;
+	m_readable          = false;
+	m_writable          = false;
+	m_writeCount        = 0;
+	m_writeThroughCount = 0;
 
 	try {
 		// turn off Nagle algorithm.  we send lots of very short messages
@@ -318,27 +403,53 @@ CTCPSocket::newJob()
 {
 	// note -- must have m_mutex locked on entry
 
+	// remember the job so we can change its interest later
 	if (m_socket == NULL) {
-		return NULL;
+		m_job = NULL;
 	}
 	else if (!m_connected) {
 		assert(!m_readable);
 		if (!(m_readable || m_writable)) {
-			return NULL;
+			m_job = NULL;
 		}
-		return new TSocketMultiplexerMethodJob<CTCPSocket>(
+		else {
+			m_job = new TSocketMultiplexerMethodJob<CTCPSocket>(
 								this, &CTCPSocket::serviceConnecting,
 								m_socket, m_readable, m_writable);
+		}
 	}
 	else {
 		if (!(m_readable || (m_writable && (m_outputBuffer.getSize() > 0)))) {
-			return NULL;
+			m_job = NULL;
 		}
-		return new TSocketMultiplexerMethodJob<CTCPSocket>(
+		else {
+			m_job = new TSocketMultiplexerMethodJob<CTCPSocket>(
 								this, &CTCPSocket::serviceConnected,
 								m_socket, m_readable,
 								m_writable && (m_outputBuffer.getSize() > 0));
+		}
 	}
+	return m_job;
+}
+
+bool
+CTCPSocket::updateJob()
+{
+	// note -- must have m_mutex locked on entry
+
+	// change the interest of our current job in place.  this avoids
+	// allocating a new job and locking the multiplexer's job list.
+	// we can only do that for a connected job that's still wanted.
+	if (m_job == NULL || !m_connected) {
+		return false;
+	}
+	bool readable = m_readable;
+	bool writable = (m_writable && (m_outputBuffer.getSize() > 0));
+	if (!(readable || writable)) {
+		return false;
+	}
+	return CSocketMultiplexer::getInstance()->setJobInterest(
+								this, m_job, readable, writable);
 }
 
 void
@@ -383,6 +494,18 @@ CTCPSocket::onOutputShutdown()
 	m_flushed.broadcast();
 }
 
+void
+CTCPSocket::onInputRead(UInt32 n)
+{
+	// note -- must have m_mutex locked on entry
+
+	// if no more data and we cannot read or write then send disconnected
+	if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
+		sendEvent(getDisconnectedEvent());
+		m_connected = false;
+	}
+}
+
 void
 CTCPSocket::onDisconnected()
 {
@@ -392,6 +515,47 @@ CTCPSocket::onDisconnected()
 	m_connected = false;
 }
 
+UInt32
+CTCPSocket::writeSocket(const IArchNetwork::CIOVec* vec, UInt32 num,
+				bool& needNewJob)
+{
+	// note -- must have m_mutex locked on entry
+
+	try {
+		if (num == 1) {
+			return (UInt32)ARCH->writeSocket(m_socket,
+								vec[0].m_data, vec[0].m_size);
+		}
+		return (UInt32)ARCH->writevSocket(m_socket, vec, num);
+	}
+	catch (XArchNetworkShutdown&) {
+		// remote read end of stream hungup.  our output side
+		// has therefore shutdown.
+		onOutputShutdown();
+		sendEvent(getOutputShutdownEvent());
+		if (!m_readable && m_inputBuffer.getSize() == 0) {
+			sendEvent(getDisconnectedEvent());
+			m_connected = false;
+		}
+		needNewJob = true;
+	}
+	catch (XArchNetworkDisconnected&) {
+		// stream hungup
+		onDisconnected();
+		sendEvent(getDisconnectedEvent());
+		needNewJob = true;
+	}
+	catch (XArchNetwork& e) {
+		// other write error
+		LOG((CLOG_WARN "error writing socket: %s", e.what().c_str()));
+		onDisconnected();
+		sendEvent(getOutputErrorEvent());
+		sendEvent(getDisconnectedEvent());
+		needNewJob = true;
+	}
+	return 0;
+}
+
 ISocketMultiplexerJob*
 CTCPSocket::serviceConnecting(ISocketMultiplexerJob* job,
 				bool, bool write, bool error)
@@ -451,61 +615,38 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 	bool needNewJob = false;
 
 	if (write) {
-		try {
-			// write data
-			UInt32 n = m_outputBuffer.getSize();
-			const void* buffer = m_outputBuffer.peek(n);
-			n = (UInt32)ARCH->writeSocket(m_socket, buffer, n);
-
-			// discard written data
-			if (n > 0) {
-				m_outputBuffer.pop(n);
-				if (m_outputBuffer.getSize() == 0) {
-					sendEvent(getOutputFlushedEvent());
-					m_flushed = true;
-					m_flushed.broadcast();
-					needNewJob = true;
-				}
-			}
-		}
-		catch (XArchNetworkShutdown&) {
-			// remote read end of stream hungup.  our output side
-			// has therefore shutdown.
-			onOutputShutdown();
-			sendEvent(getOutputShutdownEvent());
-			if (!m_readable && m_inputBuffer.getSize() == 0) {
-				sendEvent(getDisconnectedEvent());
-				m_connected = false;
+		// write data straight from the buffer's chunks.  this avoids
+		// consolidating a large backlog into one piece of memory.
+		IArchNetwork::CIOVec vec[64];
+		UInt32 n = m_outputBuffer.peekChunks(vec, sizeof(vec) / sizeof(vec[0]));
+		n = writeSocket(vec, n, needNewJob);
+
+		// discard written data
+		if (n > 0) {
+			m_outputBuffer.pop(n);
+			if (m_outputBuffer.getSize() == 0) {
+				sendEvent(getOutputFlushedEvent());
+				m_flushed = true;
+				m_flushed.broadcast();
+				needNewJob = true;
 			}
-			needNewJob = true;
-		}
-		catch (XArchNetworkDisconnected&) {
-			// stream hungup
-			onDisconnected();
-			sendEvent(getDisconnectedEvent());
-			needNewJob = true;
-		}
-		catch (XArchNetwork& e) {
-			// other write error
-			LOG((CLOG_WARN "error writing socket: %s", e.what().c_str()));
-			onDisconnected();
-			sendEvent(getOutputErrorEvent());
-			sendEvent(getDisconnectedEvent());
-			needNewJob = true;
 		}
 	}
 
 	if (read && m_readable) {
 		try {
-			UInt8 buffer[4096];
-			size_t n = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+			// read straight into the input buffer
+			bool wasEmpty = (m_inputBuffer.getSize() == 0);
+			UInt32 size;
+			void* buffer = m_inputBuffer.reserve(size);
+			size_t n = ARCH->readSocket(m_socket, buffer, size);
+			m_inputBuffer.commit((UInt32)n);
 			if (n > 0) {
-				bool wasEmpty = (m_inputBuffer.getSize() == 0);
-
 				// slurp up as much as possible
 				do {
-					m_inputBuffer.write(buffer, n);
-					n = ARCH->readSocket(m_socket, buffer, sizeof(buffer));
+					buffer = m_inputBuffer.reserve(size);
+					n      = ARCH->readSocket(m_socket, buffer, size);
+					m_inputBuffer.commit((UInt32)n);
 				} while (n > 0);
 
 				// send input ready if input buffer was empty
@@ -538,5 +679,9 @@ CTCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 		}
 	}
 
-	return needNewJob ? newJob() : job;
+	// keep the same job if we can just change its interest
+	if (needNewJob && (job != m_job || !updateJob())) {
+		return newJob();
+	}
+	return job;
 }
@@ -32,7 +32,7 @@ A data socket using TCP.
 class CTCPSocket : public IDataSocket {
 public:
 	CTCPSocket();
-	CTCPSocket(CArchSocket);
+	CTCPSocket(CArchSocket, const CNetworkAddress& peer);
 	~CTCPSocket();
 
 	// ISocket overrides
@@ -42,27 +42,42 @@ public:
 
 	// IStream overrides
 	virtual UInt32		read(void* buffer, UInt32 n);
+	virtual UInt32		readInto(CStreamBuffer& buffer);
+	virtual const void*	peek(UInt32 n);
 	virtual void		write(const void* buffer, UInt32 n);
 	virtual void		flush();
 	virtual void		shutdownInput();
 	virtual void		shutdownOutput();
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
+	virtual UInt32		getOutputSize() const;
 
 	// IDataSocket overrides
 	virtual void		connect(const CNetworkAddress&);
+	virtual CNetworkAddress	getPeerAddress() const;
+
+	//! Get write-through count
+	/*!
+	Returns the number of writes that were sent directly to the socket
+	without being queued for the multiplexer thread.
+	*/
+	UInt32				getWriteThroughCount() const;
 
 private:
 	void				init();
 
 	void				setJob(ISocketMultiplexerJob*);
 	ISocketMultiplexerJob*	newJob();
+	bool				updateJob();
+	UInt32				writeSocket(const IArchNetwork::CIOVec*, UInt32 num,
+							bool& needNewJob);
 	void				sendConnectionFailedEvent(const char*);
 	void				sendEvent(CEvent::Type);
 
 	void				onConnected();
 	void				onInputShutdown();
 	void				onOutputShutdown();
+	void				onInputRead(UInt32 n);
 	void				onDisconnected();
 
 	ISocketMultiplexerJob*
@@ -75,12 +90,16 @@ private:
 private:
 	CMutex				m_mutex;
 	CArchSocket			m_socket;
+	CNetworkAddress		m_peer;
+	ISocketMultiplexerJob*	m_job;
 	CStreamBuffer		m_inputBuffer;
 	CStreamBuffer		m_outputBuffer;
 	CCondVar<bool>		m_flushed;
 	bool				m_connected;
 	bool				m_readable;
 	bool				m_writable;
+	UInt32				m_writeCount;
+	UInt32				m_writeThroughCount;
 };
 
 #endif
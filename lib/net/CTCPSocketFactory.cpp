@@ -15,6 +15,9 @@
 #include "CTCPSocketFactory.h"
 #include "CTCPSocket.h"
 #include "CTCPListenSocket.h"
+#include "CUDPSocket.h"
+#include "CLossyDatagramSocket.h"
+#include <stdlib.h>
 
 //
 // CTCPSocketFactory
@@ -41,3 +44,17 @@ CTCPSocketFactory::createListen() const
 {
 	return new CTCPListenSocket;
 }
+
+IDatagramSocket*
+CTCPSocketFactory::createDatagram() const
+{
+	IDatagramSocket* socket = new CUDPSocket;
+#if !defined(NDEBUG)
+	// debug builds can simulate packet loss for testing
+	const char* loss = getenv("SYNERGY_DATAGRAM_LOSS");
+	if (loss != NULL) {
+		socket = new CLossyDatagramSocket(socket, atof(loss) / 100.0);
+	}
+#endif
+	return socket;
+}
@@ -26,6 +26,7 @@ public:
 	// ISocketFactory overrides
 	virtual IDataSocket*	create() const;
 	virtual IListenSocket*	createListen() const;
+	virtual IDatagramSocket*	createDatagram() const;
 };
 
 #endif
@@ -0,0 +1,201 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CUDPSocket.h"
+#include "CNetworkAddress.h"
+#include "CSocketMultiplexer.h"
+#include "TSocketMultiplexerMethodJob.h"
+#include "XSocket.h"
+#include "XIO.h"
+#include "CLock.h"
+#include "CMutex.h"
+#include "IEventQueue.h"
+#include "CArch.h"
+#include "XArch.h"
+
+//
+// CUDPSocket
+//
+
+CUDPSocket::CUDPSocket() :
+	m_bound(false),
+	m_polling(false)
+{
+	m_mutex = new CMutex;
+	try {
+		m_socket = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kDGRAM);
+	}
+	catch (XArchNetwork& e) {
+		delete m_mutex;
+		throw XSocketCreate(e.what());
+	}
+}
+
+CUDPSocket::~CUDPSocket()
+{
+	try {
+		if (m_socket != NULL) {
+			CSocketMultiplexer::getInstance()->removeSocket(this);
+			ARCH->closeSocket(m_socket);
+		}
+	}
+	catch (...) {
+		// ignore
+	}
+	delete m_mutex;
+}
+
+void
+CUDPSocket::bind(const CNetworkAddress& addr)
+{
+	ISocketMultiplexerJob* job;
+	try {
+		CLock lock(m_mutex);
+		ARCH->bindSocket(m_socket, addr.getAddress());
+		m_bound = true;
+		job     = newJob();
+	}
+	catch (XArchNetworkAddressInUse& e) {
+		throw XSocketAddressInUse(e.what());
+	}
+	catch (XArchNetwork& e) {
+		throw XSocketBind(e.what());
+	}
+	if (job != NULL) {
+		CSocketMultiplexer::getInstance()->addSocket(this, job);
+	}
+}
+
+void
+CUDPSocket::close()
+{
+	CLock lock(m_mutex);
+	if (m_socket == NULL) {
+		throw XIOClosed();
+	}
+	try {
+		CSocketMultiplexer::getInstance()->removeSocket(this);
+		ARCH->closeSocket(m_socket);
+		m_socket  = NULL;
+		m_polling = false;
+	}
+	catch (XArchNetwork& e) {
+		throw XSocketIOClose(e.what());
+	}
+}
+
+void*
+CUDPSocket::getEventTarget() const
+{
+	return const_cast<void*>(reinterpret_cast<const void*>(this));
+}
+
+bool
+CUDPSocket::send(const void* buffer, UInt32 n, const CNetworkAddress& addr)
+{
+	bool sent = false;
+	ISocketMultiplexerJob* job = NULL;
+	{
+		CLock lock(m_mutex);
+		if (m_socket == NULL || !addr.isValid()) {
+			return false;
+		}
+		try {
+			sent = (ARCH->writeToSocket(m_socket, buffer, n,
+								addr.getAddress()) == n);
+		}
+		catch (XArchNetwork&) {
+			// datagrams are unreliable anyway so just drop it
+		}
+
+		// sending gives an unbound socket an address so start
+		// watching for replies
+		if (!m_bound) {
+			m_bound = true;
+			job     = newJob();
+		}
+	}
+	if (job != NULL) {
+		CSocketMultiplexer::getInstance()->addSocket(this, job);
+	}
+	return sent;
+}
+
+UInt32
+CUDPSocket::receive(void* buffer, UInt32 n, CNetworkAddress* addr)
+{
+	size_t size = 0;
+	CArchNetAddress from = NULL;
+	ISocketMultiplexerJob* job = NULL;
+	{
+		CLock lock(m_mutex);
+		if (m_socket == NULL) {
+			return 0;
+		}
+		try {
+			size = ARCH->readFromSocket(m_socket, buffer, n,
+								(addr != NULL) ? &from : NULL);
+		}
+		catch (XArchNetwork&) {
+			// treat as nothing waiting
+			size = 0;
+			from = NULL;
+		}
+
+		// once everything has been read watch for more input
+		if (size == 0 && m_bound && !m_polling) {
+			job = newJob();
+		}
+	}
+	if (job != NULL) {
+		CSocketMultiplexer::getInstance()->addSocket(this, job);
+	}
+	if (from != NULL) {
+		*addr = CNetworkAddress(from);
+		ARCH->closeAddr(from);
+	}
+	return static_cast<UInt32>(size);
+}
+
+ISocketMultiplexerJob*
+CUDPSocket::newJob()
+{
+	// note -- must have m_mutex locked on entry
+	m_polling = true;
+	return new TSocketMultiplexerMethodJob<CUDPSocket>(
+								this, &CUDPSocket::serviceReadable,
+								m_socket, true, false);
+}
+
+ISocketMultiplexerJob*
+CUDPSocket::serviceReadable(ISocketMultiplexerJob* job,
+							bool read, bool, bool error)
+{
+	if (error) {
+		close();
+		return NULL;
+	}
+	if (read) {
+		{
+			CLock lock(m_mutex);
+			m_polling = false;
+		}
+		EVENTQUEUE->addEvent(CEvent(getInputReadyEvent(), this, NULL));
+
+		// stop polling on this socket until the client has received
+		// everything waiting
+		return NULL;
+	}
+	return job;
+}
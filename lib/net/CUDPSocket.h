@@ -0,0 +1,61 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CUDPSOCKET_H
+#define CUDPSOCKET_H
+
+#include "IDatagramSocket.h"
+#include "IArchNetwork.h"
+
+class CMutex;
+class ISocketMultiplexerJob;
+
+//! UDP datagram socket
+/*!
+A datagram socket using UDP.
+*/
+class CUDPSocket : public IDatagramSocket {
+public:
+	CUDPSocket();
+	~CUDPSocket();
+
+	// ISocket overrides
+	virtual void		bind(const CNetworkAddress&);
+	virtual void		close();
+	virtual void*		getEventTarget() const;
+
+	// IDatagramSocket overrides
+	virtual bool		send(const void* buffer, UInt32 n,
+							const CNetworkAddress& address);
+	virtual UInt32		receive(void* buffer, UInt32 n,
+							CNetworkAddress* address);
+
+private:
+	ISocketMultiplexerJob*
+						newJob();
+	ISocketMultiplexerJob*
+						serviceReadable(ISocketMultiplexerJob*,
+							bool, bool, bool);
+
+private:
+	CArchSocket			m_socket;
+	CMutex*				m_mutex;
+
+	// true if the socket has an address, either from bind() or from
+	// the first send(), and if the multiplexer is watching for input
+	bool				m_bound;
+	bool				m_polling;
+};
+
+#endif
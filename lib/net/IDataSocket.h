@@ -17,6 +17,7 @@
 
 #include "ISocket.h"
 #include "IStream.h"
+#include "CNetworkAddress.h"
 
 //! Data stream socket interface
 /*!
@@ -47,6 +48,15 @@ public:
 	//! @name accessors
 	//@{
 
+	//! Get peer address
+	/*!
+	Returns the address of the remote endpoint.  That's the address
+	passed to \c connect() or, for a socket accepted by a listen
+	socket, the address the connection came from.  Returns the invalid
+	address if there's no remote endpoint yet.
+	*/
+	virtual CNetworkAddress	getPeerAddress() const = 0;
+
 	//! Get connected event type
 	/*!
 	Returns the socket connected event type.  A socket sends this
@@ -75,12 +85,15 @@ public:
 
 	// IStream overrides
 	virtual UInt32		read(void* buffer, UInt32 n) = 0;
+	virtual UInt32		readInto(CStreamBuffer& buffer) = 0;
+	virtual const void*	peek(UInt32 n) = 0;
 	virtual void		write(const void* buffer, UInt32 n) = 0;
 	virtual void		flush() = 0;
 	virtual void		shutdownInput() = 0;
 	virtual void		shutdownOutput() = 0;
 	virtual bool		isReady() const = 0;
 	virtual UInt32		getSize() const = 0;
+	virtual UInt32		getOutputSize() const = 0;
 
 private:
 	static CEvent::Type	s_connectedEvent;
@@ -0,0 +1,28 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "IDatagramSocket.h"
+
+//
+// IDatagramSocket
+//
+
+CEvent::Type			IDatagramSocket::s_inputReadyEvent = CEvent::kUnknown;
+
+CEvent::Type
+IDatagramSocket::getInputReadyEvent()
+{
+	return CEvent::registerTypeOnce(s_inputReadyEvent,
+							"IDatagramSocket::inputReady");
+}
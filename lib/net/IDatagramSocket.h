@@ -0,0 +1,74 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef IDATAGRAMSOCKET_H
+#define IDATAGRAMSOCKET_H
+
+#include "ISocket.h"
+#include "BasicTypes.h"
+
+//! Datagram socket interface
+/*!
+This interface defines the methods common to all network sockets that
+send and receive unreliable datagrams.  Datagrams may be lost,
+duplicated or delivered out of order.
+*/
+class IDatagramSocket : public ISocket {
+public:
+	//! @name manipulators
+	//@{
+
+	//! Send datagram
+	/*!
+	Send \c n bytes from \c buffer as a single datagram to \c address.
+	Returns false if the datagram could not be sent now, in which case
+	it's dropped.
+	*/
+	virtual bool		send(const void* buffer, UInt32 n,
+							const CNetworkAddress& address) = 0;
+
+	//! Receive datagram
+	/*!
+	Read the next waiting datagram into \c buffer and return its size.
+	At most \c n bytes are read and the rest of the datagram is
+	discarded.  The sender's address is returned in \c address if it's
+	not NULL.  Returns 0 if no datagram is waiting.  An input ready
+	event is sent when datagrams arrive after this has returned 0.
+	*/
+	virtual UInt32		receive(void* buffer, UInt32 n,
+							CNetworkAddress* address) = 0;
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get input ready event type
+	/*!
+	Returns the input ready event type.  A socket sends this event
+	when datagrams are waiting to be received.
+	*/
+	static CEvent::Type	getInputReadyEvent();
+
+	//@}
+
+	// ISocket overrides
+	virtual void		bind(const CNetworkAddress&) = 0;
+	virtual void		close() = 0;
+	virtual void*		getEventTarget() const = 0;
+
+private:
+	static CEvent::Type	s_inputReadyEvent;
+};
+
+#endif
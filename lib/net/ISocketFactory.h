@@ -18,6 +18,7 @@
 #include "IInterface.h"
 
 class IDataSocket;
+class IDatagramSocket;
 class IListenSocket;
 
 //! Socket factory
@@ -36,6 +37,9 @@ public:
 	//! Create listen socket
 	virtual IListenSocket*	createListen() const = 0;
 
+	//! Create datagram socket
+	virtual IDatagramSocket*	createDatagram() const = 0;
+
 	//@}
 };
 
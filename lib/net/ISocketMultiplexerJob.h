@@ -45,6 +45,14 @@ public:
 	virtual ISocketMultiplexerJob*
 						run(bool readable, bool writable, bool error) = 0;
 
+	//! Change interest
+	/*!
+	Changes the job's interest in readability and writability.  Only
+	the multiplexer should call this;  clients should use
+	\c CSocketMultiplexer::setJobInterest() so the change takes effect.
+	*/
+	virtual void		setInterest(bool readable, bool writable) = 0;
+
 	//@}
 	//! @name accessors
 	//@{
@@ -36,6 +36,7 @@ public:
 	// IJob overrides
 	virtual ISocketMultiplexerJob*
 						run(bool readable, bool writable, bool error);
+	virtual void		setInterest(bool readable, bool writable);
 	virtual CArchSocket	getSocket() const;
 	virtual bool		isReadable() const;
 	virtual bool		isWritable() const;
@@ -81,6 +82,15 @@ TSocketMultiplexerMethodJob<T>::run(bool read, bool write, bool error)
 	return NULL;
 }
 
+template <class T>
+inline
+void
+TSocketMultiplexerMethodJob<T>::setInterest(bool readable, bool writable)
+{
+	m_readable = readable;
+	m_writable = writable;
+}
+
 template <class T>
 inline
 CArchSocket
@@ -1211,8 +1211,8 @@ CMSWindowsScreen::onHotKey(WPARAM wParam, LPARAM lParam)
 	}
 
 	// generate event
-	EVENTQUEUE->addEvent(CEvent(type, getEventTarget(),
-							CHotKeyInfo::alloc(i->second)));
+	EVENTQUEUE->addEvent(CEvent::withCopy(type, getEventTarget(),
+							CHotKeyInfo::make(i->second)));
 
 	return true;
 }
@@ -1240,15 +1240,17 @@ CMSWindowsScreen::onMouseButton(WPARAM wParam, LPARAM lParam)
 		if (pressed) {
 			LOG((CLOG_DEBUG1 "event: button press button=%d", button));
 			if (button != kButtonNone) {
-				sendEvent(getButtonDownEvent(),
-								CButtonInfo::alloc(button, mask));
+				EVENTQUEUE->addEvent(CEvent::withCopy(getButtonDownEvent(),
+									getEventTarget(),
+									CButtonInfo::make(button, mask)));
 			}
 		}
 		else {
 			LOG((CLOG_DEBUG1 "event: button release button=%d", button));
 			if (button != kButtonNone) {
-				sendEvent(getButtonUpEvent(),
-								CButtonInfo::alloc(button, mask));
+				EVENTQUEUE->addEvent(CEvent::withCopy(getButtonUpEvent(),
+									getEventTarget(),
+									CButtonInfo::make(button, mask)));
 			}
 		}
 	}
@@ -1276,8 +1278,9 @@ CMSWindowsScreen::onMouseMove(SInt32 mx, SInt32 my)
 
 	if (m_isOnScreen) {
 		// motion on primary screen
-		sendEvent(getMotionOnPrimaryEvent(),
-							CMotionInfo::alloc(m_xCursor, m_yCursor));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getMotionOnPrimaryEvent(),
+							getEventTarget(),
+							CMotionInfo::make(m_xCursor, m_yCursor)));
 	}
 	else {
 		// motion on secondary screen.  warp mouse back to
@@ -1298,7 +1301,8 @@ CMSWindowsScreen::onMouseMove(SInt32 mx, SInt32 my)
 		}
 		else {
 			// send motion
-			sendEvent(getMotionOnSecondaryEvent(), CMotionInfo::alloc(x, y));
+			EVENTQUEUE->addEvent(CEvent::withCopy(getMotionOnSecondaryEvent(),
+								getEventTarget(), CMotionInfo::make(x, y)));
 		}
 	}
 
@@ -1311,7 +1315,9 @@ CMSWindowsScreen::onMouseWheel(SInt32 xDelta, SInt32 yDelta)
 	// ignore message if posted prior to last mark change
 	if (!ignore()) {
 		LOG((CLOG_DEBUG1 "event: button wheel delta=%+d,%+d", xDelta, yDelta));
-		sendEvent(getWheelEvent(), CWheelInfo::alloc(xDelta, yDelta));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getWheelEvent(),
+							getEventTarget(),
+							CWheelInfo::make(xDelta, yDelta)));
 	}
 	return true;
 }
@@ -62,6 +62,8 @@ COSXScreen::COSXScreen(bool isPrimary) :
 	m_isPrimary(isPrimary),
 	m_isOnScreen(m_isPrimary),
 	m_cursorPosValid(false),
+	m_xWheel(0),
+	m_yWheel(0),
 	m_cursorHidden(false),
 	m_dragNumButtonsDown(0),
 	m_dragTimer(NULL),
@@ -537,9 +539,20 @@ COSXScreen::fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const
 void
 COSXScreen::fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const
 {
-	if (xDelta != 0 || yDelta != 0) {
-		CGPostScrollWheelEvent(2, mapScrollWheelFromSynergy(yDelta),
-								-mapScrollWheelFromSynergy(xDelta));
+	// add to the scrolling too small to make a step before.  high
+	// resolution wheels and touchpads send deltas that would round
+	// to nothing one at a time.
+	m_xWheel += xDelta;
+	m_yWheel += yDelta;
+	const SInt32 dx = mapScrollWheelFromSynergy(m_xWheel);
+	const SInt32 dy = mapScrollWheelFromSynergy(m_yWheel);
+	if (dx != 0 || dy != 0) {
+		CGPostScrollWheelEvent(2, dy, -dx);
+
+		// keep what the steps didn't use.  this is the inverse of
+		// mapScrollWheelFromSynergy().
+		m_xWheel -= dx * 120 / 3;
+		m_yWheel -= dy * 120 / 3;
 	}
 }
 
@@ -628,6 +641,11 @@ COSXScreen::enter()
 			m_buttons[i] = false;
 		}
 
+		// don't finish a scroll step started the last time we had
+		// the screen
+		m_xWheel = 0;
+		m_yWheel = 0;
+
 		// avoid suppression of local hardware events
 		// stkamp@users.sourceforge.net
 		CGSetLocalEventsFilterDuringSupressionState(
@@ -977,8 +995,9 @@ COSXScreen::onMouseMove(SInt32 mx, SInt32 my)
 
 	if (m_isOnScreen) {
 		// motion on primary screen
-		sendEvent(getMotionOnPrimaryEvent(),
-							CMotionInfo::alloc(m_xCursor, m_yCursor));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getMotionOnPrimaryEvent(),
+							getEventTarget(),
+							CMotionInfo::make(m_xCursor, m_yCursor)));
 	}
 	else {
 		// motion on secondary screen.  warp mouse back to
@@ -999,7 +1018,8 @@ COSXScreen::onMouseMove(SInt32 mx, SInt32 my)
 		}
 		else {
 			// send motion
-			sendEvent(getMotionOnSecondaryEvent(), CMotionInfo::alloc(x, y));
+			EVENTQUEUE->addEvent(CEvent::withCopy(getMotionOnSecondaryEvent(),
+								getEventTarget(), CMotionInfo::make(x, y)));
 		}
 	}
 
@@ -1016,14 +1036,18 @@ COSXScreen::onMouseButton(bool pressed, UInt16 macButton)
 		LOG((CLOG_DEBUG1 "event: button press button=%d", button));
 		if (button != kButtonNone) {
 			KeyModifierMask mask = m_keyState->getActiveModifiers();
-			sendEvent(getButtonDownEvent(), CButtonInfo::alloc(button, mask));
+			EVENTQUEUE->addEvent(CEvent::withCopy(getButtonDownEvent(),
+								getEventTarget(),
+								CButtonInfo::make(button, mask)));
 		}
 	}
 	else {
 		LOG((CLOG_DEBUG1 "event: button release button=%d", button));
 		if (button != kButtonNone) {
 			KeyModifierMask mask = m_keyState->getActiveModifiers();
-			sendEvent(getButtonUpEvent(), CButtonInfo::alloc(button, mask));
+			EVENTQUEUE->addEvent(CEvent::withCopy(getButtonUpEvent(),
+								getEventTarget(),
+								CButtonInfo::make(button, mask)));
 		}
 	}
 
@@ -1050,7 +1074,8 @@ bool
 COSXScreen::onMouseWheel(SInt32 xDelta, SInt32 yDelta) const
 {
 	LOG((CLOG_DEBUG1 "event: button wheel delta=%+d,%+d", xDelta, yDelta));
-	sendEvent(getWheelEvent(), CWheelInfo::alloc(xDelta, yDelta));
+	EVENTQUEUE->addEvent(CEvent::withCopy(getWheelEvent(),
+						getEventTarget(), CWheelInfo::make(xDelta, yDelta)));
 	return true;
 }
 
@@ -1123,9 +1148,9 @@ COSXScreen::onKey(EventRef event)
 			if (m_modifierHotKeys.count(newMask) > 0) {
 				m_activeModifierHotKey     = m_modifierHotKeys[newMask];
 				m_activeModifierHotKeyMask = newMask;
-				EVENTQUEUE->addEvent(CEvent(getHotKeyDownEvent(),
+				EVENTQUEUE->addEvent(CEvent::withCopy(getHotKeyDownEvent(),
 								getEventTarget(),
-								CHotKeyInfo::alloc(m_activeModifierHotKey)));
+								CHotKeyInfo::make(m_activeModifierHotKey)));
 			}
 		}
 
@@ -1134,9 +1159,9 @@ COSXScreen::onKey(EventRef event)
 		else if (m_activeModifierHotKey != 0) {
 			KeyModifierMask mask = (newMask & m_activeModifierHotKeyMask);
 			if (mask != m_activeModifierHotKeyMask) {
-				EVENTQUEUE->addEvent(CEvent(getHotKeyUpEvent(),
+				EVENTQUEUE->addEvent(CEvent::withCopy(getHotKeyUpEvent(),
 								getEventTarget(),
-								CHotKeyInfo::alloc(m_activeModifierHotKey)));
+								CHotKeyInfo::make(m_activeModifierHotKey)));
 				m_activeModifierHotKey     = 0;
 				m_activeModifierHotKeyMask = 0;
 			}
@@ -1168,8 +1193,8 @@ COSXScreen::onKey(EventRef event)
 				return false;
 			}
 	
-			EVENTQUEUE->addEvent(CEvent(type, getEventTarget(),
-										CHotKeyInfo::alloc(id)));
+			EVENTQUEUE->addEvent(CEvent::withCopy(type, getEventTarget(),
+										CHotKeyInfo::make(id)));
 		
 			return true;
 		}
@@ -1241,8 +1266,8 @@ COSXScreen::onHotKey(EventRef event) const
 		return false;
 	}
 
-	EVENTQUEUE->addEvent(CEvent(type, getEventTarget(),
-								CHotKeyInfo::alloc(id)));
+	EVENTQUEUE->addEvent(CEvent::withCopy(type, getEventTarget(),
+								CHotKeyInfo::make(id)));
 
 	return true;
 }
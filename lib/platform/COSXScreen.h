@@ -193,6 +193,7 @@ private:
 	mutable SInt32		m_xCursor, m_yCursor;
 	mutable bool		m_cursorPosValid;
 	mutable boolean_t	m_buttons[5];
+	mutable SInt32		m_xWheel, m_yWheel;
 	bool				m_cursorHidden;
 	SInt32				m_dragNumButtonsDown;
 	Point				m_dragLastPoint;
@@ -80,6 +80,7 @@ CXWindowsScreen::CXWindowsScreen(const char* displayName, bool isPrimary) :
 	m_w(0), m_h(0),
 	m_xCenter(0), m_yCenter(0),
 	m_xCursor(0), m_yCursor(0),
+	m_yWheel(0),
 	m_keyState(NULL),
 	m_lastFocus(None),
 	m_lastFocusRevert(RevertToNone),
@@ -250,6 +251,10 @@ CXWindowsScreen::enter()
 		// cause the local server to generate their own auto-repeats of
 		// those keys.
 		XAutoRepeatOff(m_display);
+
+		// don't finish a wheel tick started the last time we had
+		// the screen
+		m_yWheel = 0;
 	}
 
 	// now on screen
@@ -791,15 +796,28 @@ CXWindowsScreen::fakeMouseWheel(SInt32, SInt32 yDelta) const
 		return;
 	}
 
+	// add to the part of a tick left over from before, dropping it
+	// if the direction changed.  high resolution wheels and touchpads
+	// send deltas much smaller than a tick that we'd lose otherwise.
+	if ((m_yWheel < 0) != (yDelta < 0)) {
+		m_yWheel = 0;
+	}
+	m_yWheel += yDelta;
+	SInt32 ticks = m_yWheel / 120;
+	if (ticks == 0) {
+		return;
+	}
+	m_yWheel -= 120 * ticks;
+
 	// choose button depending on rotation direction
 	const unsigned int xButton = mapButtonToX(static_cast<ButtonID>(
-												(yDelta >= 0) ? -1 : -2));
+												(ticks >= 0) ? -1 : -2));
 	if (xButton == 0) {
 		// If we get here, then the XServer does not support the scroll
 		// wheel buttons, so send PageUp/PageDown keystrokes instead.
 		// Patch by Tom Chadwick.
 		KeyCode keycode = 0;
-		if (yDelta >= 0) {
+		if (ticks >= 0) {
 			keycode = XKeysymToKeycode(m_display, XK_Page_Up);
 		}
 		else {
@@ -812,13 +830,13 @@ CXWindowsScreen::fakeMouseWheel(SInt32, SInt32 yDelta) const
 		return;
 	}
 
-	// now use absolute value of delta
-	if (yDelta < 0) {
-		yDelta = -yDelta;
+	// now use absolute value of ticks
+	if (ticks < 0) {
+		ticks = -ticks;
 	}
 
-	// send as many clicks as necessary
-	for (; yDelta >= 120; yDelta -= 120) {
+	// send as many clicks as necessary and flush them together
+	for (; ticks > 0; --ticks) {
 		XTestFakeButtonEvent(m_display, xButton, True, CurrentTime);
 		XTestFakeButtonEvent(m_display, xButton, False, CurrentTime);
 	}
@@ -1385,8 +1403,8 @@ CXWindowsScreen::onHotKey(XKeyEvent& xkey, bool isRepeat)
 
 	// generate event (ignore key repeats)
 	if (!isRepeat) {
-		EVENTQUEUE->addEvent(CEvent(type, getEventTarget(),
-								CHotKeyInfo::alloc(i->second)));
+		EVENTQUEUE->addEvent(CEvent::withCopy(type, getEventTarget(),
+								CHotKeyInfo::make(i->second)));
 	}
 	return true;
 }
@@ -1398,7 +1416,8 @@ CXWindowsScreen::onMousePress(const XButtonEvent& xbutton)
 	ButtonID button      = mapButtonFromX(&xbutton);
 	KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
 	if (button != kButtonNone) {
-		sendEvent(getButtonDownEvent(), CButtonInfo::alloc(button, mask));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getButtonDownEvent(),
+							getEventTarget(), CButtonInfo::make(button, mask)));
 	}
 }
 
@@ -1409,15 +1428,18 @@ CXWindowsScreen::onMouseRelease(const XButtonEvent& xbutton)
 	ButtonID button      = mapButtonFromX(&xbutton);
 	KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
 	if (button != kButtonNone) {
-		sendEvent(getButtonUpEvent(), CButtonInfo::alloc(button, mask));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getButtonUpEvent(),
+							getEventTarget(), CButtonInfo::make(button, mask)));
 	}
 	else if (xbutton.button == 4) {
 		// wheel forward (away from user)
-		sendEvent(getWheelEvent(), CWheelInfo::alloc(0, 120));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getWheelEvent(),
+							getEventTarget(), CWheelInfo::make(0, 120)));
 	}
 	else if (xbutton.button == 5) {
 		// wheel backward (toward user)
-		sendEvent(getWheelEvent(), CWheelInfo::alloc(0, -120));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getWheelEvent(),
+							getEventTarget(), CWheelInfo::make(0, -120)));
 	}
 	// XXX -- support x-axis scrolling
 }
@@ -1449,8 +1471,9 @@ CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 	}
 	else if (m_isOnScreen) {
 		// motion on primary screen
-		sendEvent(getMotionOnPrimaryEvent(),
-							CMotionInfo::alloc(m_xCursor, m_yCursor));
+		EVENTQUEUE->addEvent(CEvent::withCopy(getMotionOnPrimaryEvent(),
+							getEventTarget(),
+							CMotionInfo::make(m_xCursor, m_yCursor)));
 	}
 	else {
 		// motion on secondary screen.  warp mouse back to
@@ -1480,7 +1503,8 @@ CXWindowsScreen::onMouseMove(const XMotionEvent& xmotion)
 		// warping to the primary screen's enter position,
 		// effectively overriding it.
 		if (x != 0 || y != 0) {
-			sendEvent(getMotionOnSecondaryEvent(), CMotionInfo::alloc(x, y));
+			EVENTQUEUE->addEvent(CEvent::withCopy(getMotionOnSecondaryEvent(),
+								getEventTarget(), CMotionInfo::make(x, y)));
 		}
 	}
 }
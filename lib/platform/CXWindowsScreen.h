@@ -177,6 +177,9 @@ private:
 	// last mouse position
 	SInt32				m_xCursor, m_yCursor;
 
+	// scrolling too small to make a wheel tick yet
+	mutable SInt32		m_yWheel;
+
 	// keyboard stuff
 	CXWindowsKeyState*	m_keyState;
 
@@ -15,9 +15,11 @@
 #include "CClientListener.h"
 #include "CClientProxy.h"
 #include "CClientProxyUnknown.h"
+#include "CMotionChannel.h"
 #include "CPacketStreamFilter.h"
 #include "IStreamFilterFactory.h"
 #include "IDataSocket.h"
+#include "IDatagramSocket.h"
 #include "IListenSocket.h"
 #include "ISocketFactory.h"
 #include "XSocket.h"
@@ -34,6 +36,7 @@ CEvent::Type			CClientListener::s_connectedEvent = CEvent::kUnknown;
 CClientListener::CClientListener(const CNetworkAddress& address,
 				ISocketFactory* socketFactory,
 				IStreamFilterFactory* streamFilterFactory) :
+	m_motionChannel(NULL),
 	m_socketFactory(socketFactory),
 	m_streamFilterFactory(streamFilterFactory)
 {
@@ -61,6 +64,9 @@ CClientListener::CClientListener(const CNetworkAddress& address,
 	}
 	LOG((CLOG_DEBUG1 "listening for clients"));
 
+	// take datagrams on the same port for mouse motion
+	openMotionChannel(address);
+
 	// setup event handler
 	EVENTQUEUE->adoptHandler(IListenSocket::getConnectingEvent(), m_listen,
 							new TMethodEventJob<CClientListener>(this,
@@ -93,6 +99,12 @@ CClientListener::~CClientListener()
 
 	EVENTQUEUE->removeHandler(IListenSocket::getConnectingEvent(), m_listen);
 	delete m_listen;
+
+	// clients still using the motion channel keep it open
+	if (m_motionChannel != NULL) {
+		m_motionChannel->unref();
+	}
+
 	delete m_socketFactory;
 	delete m_streamFilterFactory;
 }
@@ -120,11 +132,13 @@ void
 CClientListener::handleClientConnecting(const CEvent&, void*)
 {
 	// accept client connection
-	IStream* stream = m_listen->accept();
-	if (stream == NULL) {
+	IDataSocket* socket = m_listen->accept();
+	if (socket == NULL) {
 		return;
 	}
 	LOG((CLOG_NOTE "accepted client connection"));
+	const CNetworkAddress peer = socket->getPeerAddress();
+	IStream* stream            = socket;
 
 	// filter socket messages, including a packetizing filter
 	if (m_streamFilterFactory != NULL) {
@@ -133,7 +147,8 @@ CClientListener::handleClientConnecting(const CEvent&, void*)
 	stream = new CPacketStreamFilter(stream, true);
 
 	// create proxy for unknown client
-	CClientProxyUnknown* client = new CClientProxyUnknown(stream, 30.0);
+	CClientProxyUnknown* client =
+		new CClientProxyUnknown(stream, 30.0, m_motionChannel, peer);
 	m_newClients.insert(client);
 
 	// watch for events from unknown client
@@ -192,3 +207,26 @@ CClientListener::handleClientDisconnected(const CEvent&, void* vclient)
 		}
 	}
 }
+
+void
+CClientListener::openMotionChannel(const CNetworkAddress& address)
+{
+	// datagrams don't go through the stream filters so don't use them
+	// if there are any
+	if (m_streamFilterFactory != NULL) {
+		return;
+	}
+
+	IDatagramSocket* socket = NULL;
+	try {
+		socket = m_socketFactory->createDatagram();
+		socket->bind(address);
+		m_motionChannel = new CMotionChannel(socket);
+		LOG((CLOG_DEBUG1 "listening for motion channel datagrams"));
+	}
+	catch (XBase& e) {
+		// clients will have to do without
+		delete socket;
+		LOG((CLOG_WARN "cannot open motion channel: %s", e.what()));
+	}
+}
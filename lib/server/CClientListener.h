@@ -22,6 +22,7 @@
 
 class CClientProxy;
 class CClientProxyUnknown;
+class CMotionChannel;
 class CNetworkAddress;
 class IListenSocket;
 class ISocketFactory;
@@ -60,11 +61,15 @@ private:
 	void				handleUnknownClient(const CEvent&, void*);
 	void				handleClientDisconnected(const CEvent&, void*);
 
+	// open the motion side channel on the listen address, if we can
+	void				openMotionChannel(const CNetworkAddress&);
+
 private:
 	typedef std::set<CClientProxyUnknown*> CNewClients;
 	typedef std::deque<CClientProxy*> CWaitingClients;
 
 	IListenSocket*			m_listen;
+	CMotionChannel*			m_motionChannel;
 	ISocketFactory*			m_socketFactory;
 	IStreamFilterFactory*	m_streamFilterFactory;
 	CNewClients				m_newClients;
@@ -23,6 +23,7 @@
 
 CEvent::Type			CClientProxy::s_readyEvent           = CEvent::kUnknown;
 CEvent::Type			CClientProxy::s_disconnectedEvent    = CEvent::kUnknown;
+CEvent::Type			CClientProxy::s_resumedEvent         = CEvent::kUnknown;
 CEvent::Type			CClientProxy::s_clipboardChangedEvent= CEvent::kUnknown;
 
 CClientProxy::CClientProxy(const CString& name, IStream* stream) :
@@ -47,12 +48,36 @@ CClientProxy::close(const char* msg)
 	getStream()->flush();
 }
 
+void
+CClientProxy::setCapabilities(const CCapabilityList& capabilities)
+{
+	m_capabilities = capabilities;
+}
+
+void
+CClientProxy::setStream(IStream* stream)
+{
+	delete m_stream;
+	m_stream = stream;
+}
+
 IStream*
 CClientProxy::getStream() const
 {
 	return m_stream;
 }
 
+UInt32
+CClientProxy::getCapability(CapabilityID id) const
+{
+	for (UInt32 i = 0; i + 1 < m_capabilities.size(); i += 2) {
+		if (m_capabilities[i] == id) {
+			return m_capabilities[i + 1];
+		}
+	}
+	return 0;
+}
+
 CEvent::Type
 CClientProxy::getReadyEvent()
 {
@@ -67,6 +92,13 @@ CClientProxy::getDisconnectedEvent()
 							"CClientProxy::disconnected");
 }
 
+CEvent::Type
+CClientProxy::getResumedEvent()
+{
+	return CEvent::registerTypeOnce(s_resumedEvent,
+							"CClientProxy::resumed");
+}
+
 CEvent::Type
 CClientProxy::getClipboardChangedEvent()
 {
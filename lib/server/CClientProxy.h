@@ -18,6 +18,7 @@
 #include "CBaseClientProxy.h"
 #include "CEvent.h"
 #include "CString.h"
+#include "ProtocolTypes.h"
 
 class IStream;
 
@@ -39,6 +40,13 @@ public:
 	*/
 	void				close(const char* msg);
 
+	//! Set capabilities
+	/*!
+	Sets the capabilities negotiated for the connection as id/value
+	pairs.  This should be called before the proxy is used.
+	*/
+	void				setCapabilities(const CCapabilityList&);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -49,6 +57,13 @@ public:
 	*/
 	IStream*			getStream() const;
 
+	//! Get capability
+	/*!
+	Returns the value negotiated for capability \p id or 0 if the
+	capability is off.
+	*/
+	UInt32				getCapability(CapabilityID id) const;
+
 	//! Get ready event type
 	/*!
 	Returns the ready event type.  This is sent when the client has
@@ -64,6 +79,14 @@ public:
 	*/
 	static CEvent::Type	getDisconnectedEvent();
 
+	//! Get resumed event type
+	/*!
+	Returns the resumed event type.  This is sent when a client that
+	disconnected has reconnected and resumed its session.  The target
+	is getEventTarget().
+	*/
+	static CEvent::Type	getResumedEvent();
+
 	//! Get clipboard changed event type
 	/*!
 	Returns the clipboard changed event type.  This is sent whenever the
@@ -102,11 +125,20 @@ public:
 	virtual void		resetOptions() = 0;
 	virtual void		setOptions(const COptionsList& options) = 0;
 
+protected:
+	//! Replace stream
+	/*!
+	Deletes the stream and uses \p adoptedStream in its place.
+	*/
+	void				setStream(IStream* adoptedStream);
+
 private:
 	IStream*			m_stream;
+	CCapabilityList		m_capabilities;
 
 	static CEvent::Type	s_readyEvent;
 	static CEvent::Type	s_disconnectedEvent;
+	static CEvent::Type	s_resumedEvent;
 	static CEvent::Type	s_clipboardChangedEvent;
 };
 
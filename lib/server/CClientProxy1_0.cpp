@@ -19,42 +19,32 @@
 #include "CLog.h"
 #include "IEventQueue.h"
 #include "TMethodEventJob.h"
-#include <cstring>
 
 //
 // CClientProxy1_0
 //
 
+const UInt32			CClientProxy1_0::kMaxOutputBacklog = 4096;
+
 CClientProxy1_0::CClientProxy1_0(const CString& name, IStream* stream) :
 	CClientProxy(name, stream),
 	m_heartbeatTimer(NULL),
-	m_parser(&CClientProxy1_0::parseHandshakeMessage)
-{
-	// install event handlers
-	EVENTQUEUE->adoptHandler(IStream::getInputReadyEvent(),
-							stream->getEventTarget(),
-							new TMethodEventJob<CClientProxy1_0>(this,
-								&CClientProxy1_0::handleData, NULL));
-	EVENTQUEUE->adoptHandler(IStream::getOutputErrorEvent(),
-							stream->getEventTarget(),
-							new TMethodEventJob<CClientProxy1_0>(this,
-								&CClientProxy1_0::handleWriteError, NULL));
-	EVENTQUEUE->adoptHandler(IStream::getInputShutdownEvent(),
-							stream->getEventTarget(),
-							new TMethodEventJob<CClientProxy1_0>(this,
-								&CClientProxy1_0::handleDisconnect, NULL));
-	EVENTQUEUE->adoptHandler(IStream::getOutputShutdownEvent(),
-							stream->getEventTarget(),
-							new TMethodEventJob<CClientProxy1_0>(this,
-								&CClientProxy1_0::handleWriteError, NULL));
-	EVENTQUEUE->adoptHandler(CEvent::kTimer, this,
-							new TMethodEventJob<CClientProxy1_0>(this,
-								&CClientProxy1_0::handleFlatline, NULL));
+	m_parser(&CClientProxy1_0::parseHandshakeMessage),
+	m_disconnected(false),
+	m_absHeld(false),
+	m_xAbsHeld(0),
+	m_yAbsHeld(0),
+	m_relHeld(false),
+	m_xRelHeld(0),
+	m_yRelHeld(0),
+	m_coalescedMotion(0)
+{
+	addHandlers();
 
 	setHeartbeatRate(kHeartRate, kHeartRate * kHeartBeatsUntilDeath);
 
 	LOG((CLOG_DEBUG1 "querying client \"%s\" info", getName().c_str()));
-	CProtocolUtil::writef(getStream(), kMsgQInfo);
+	CProtocolUtil::writeMessage(getStream(), CMsgQInfo());
 }
 
 CClientProxy1_0::~CClientProxy1_0()
@@ -65,11 +55,62 @@ CClientProxy1_0::~CClientProxy1_0()
 void
 CClientProxy1_0::disconnect()
 {
+	if (m_disconnected) {
+		return;
+	}
+	m_disconnected = true;
+	LOG((CLOG_DEBUG "client \"%s\" had %d bytes queued, %d moves coalesced", getName().c_str(), getOutputBacklog(), m_coalescedMotion));
 	removeHandlers();
 	getStream()->close();
 	EVENTQUEUE->addEvent(CEvent(getDisconnectedEvent(), getEventTarget()));
 }
 
+void
+CClientProxy1_0::reconnect(IStream* stream)
+{
+	disconnect();
+	setStream(stream);
+	m_disconnected = false;
+
+	// motion held back for the old link is stale
+	m_absHeld = false;
+	m_relHeld = false;
+
+	addHandlers();
+	if (m_parser == &CClientProxy1_0::parseMessage) {
+		addHeartbeatTimer();
+	}
+}
+
+void
+CClientProxy1_0::addHandlers()
+{
+	// install event handlers
+	EVENTQUEUE->adoptHandler(IStream::getInputReadyEvent(),
+							getStream()->getEventTarget(),
+							new TMethodEventJob<CClientProxy1_0>(this,
+								&CClientProxy1_0::handleData, NULL));
+	EVENTQUEUE->adoptHandler(IStream::getOutputErrorEvent(),
+							getStream()->getEventTarget(),
+							new TMethodEventJob<CClientProxy1_0>(this,
+								&CClientProxy1_0::handleWriteError, NULL));
+	EVENTQUEUE->adoptHandler(IStream::getInputShutdownEvent(),
+							getStream()->getEventTarget(),
+							new TMethodEventJob<CClientProxy1_0>(this,
+								&CClientProxy1_0::handleDisconnect, NULL));
+	EVENTQUEUE->adoptHandler(IStream::getOutputShutdownEvent(),
+							getStream()->getEventTarget(),
+							new TMethodEventJob<CClientProxy1_0>(this,
+								&CClientProxy1_0::handleWriteError, NULL));
+	EVENTQUEUE->adoptHandler(IStream::getOutputFlushedEvent(),
+							getStream()->getEventTarget(),
+							new TMethodEventJob<CClientProxy1_0>(this,
+								&CClientProxy1_0::handleOutputFlushed, NULL));
+	EVENTQUEUE->adoptHandler(CEvent::kTimer, this,
+							new TMethodEventJob<CClientProxy1_0>(this,
+								&CClientProxy1_0::handleFlatline, NULL));
+}
+
 void
 CClientProxy1_0::removeHandlers()
 {
@@ -82,6 +123,8 @@ CClientProxy1_0::removeHandlers()
 							getStream()->getEventTarget());
 	EVENTQUEUE->removeHandler(IStream::getOutputShutdownEvent(),
 							getStream()->getEventTarget());
+	EVENTQUEUE->removeHandler(IStream::getOutputFlushedEvent(),
+							getStream()->getEventTarget());
 	EVENTQUEUE->removeHandler(CEvent::kTimer, this);
 
 	// remove timer
@@ -108,9 +151,14 @@ CClientProxy1_0::removeHeartbeatTimer()
 void
 CClientProxy1_0::resetHeartbeatTimer()
 {
-	// reset the alarm
-	removeHeartbeatTimer();
-	addHeartbeatTimer();
+	// restart the alarm in place.  if there's no alarm yet then create
+	// just the alarm, not any other timers subclasses add.
+	if (m_heartbeatTimer != NULL) {
+		EVENTQUEUE->resetTimer(m_heartbeatTimer);
+	}
+	else {
+		CClientProxy1_0::addHeartbeatTimer();
+	}
 }
 
 void
@@ -141,7 +189,7 @@ CClientProxy1_0::handleData(const CEvent&, void*)
 
 		// parse message
 		LOG((CLOG_DEBUG2 "msg from \"%s\": %c%c%c%c", getName().c_str(), code[0], code[1], code[2], code[3]));
-		if (!(this->*m_parser)(code)) {
+		if (!(this->*m_parser)(CProtocolUtil::getCode(code))) {
 			LOG((CLOG_ERR "invalid message from client \"%s\": %c%c%c%c", getName().c_str(), code[0], code[1], code[2], code[3]));
 			disconnect();
 			return;
@@ -156,14 +204,15 @@ CClientProxy1_0::handleData(const CEvent&, void*)
 }
 
 bool
-CClientProxy1_0::parseHandshakeMessage(const UInt8* code)
+CClientProxy1_0::parseHandshakeMessage(UInt32 code)
 {
-	if (memcmp(code, kMsgCNoop, 4) == 0) {
+	switch (code) {
+	case kCodeCNoop:
 		// discard no-ops
 		LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
 		return true;
-	}
-	else if (memcmp(code, kMsgDInfo, 4) == 0) {
+
+	case kCodeDInfo:
 		// future messages get parsed by parseMessage
 		m_parser = &CClientProxy1_0::parseMessage;
 		if (recvInfo()) {
@@ -171,33 +220,39 @@ CClientProxy1_0::parseHandshakeMessage(const UInt8* code)
 			addHeartbeatTimer();
 			return true;
 		}
+		return false;
+
+	default:
+		return false;
 	}
-	return false;
 }
 
 bool
-CClientProxy1_0::parseMessage(const UInt8* code)
+CClientProxy1_0::parseMessage(UInt32 code)
 {
-	if (memcmp(code, kMsgDInfo, 4) == 0) {
+	switch (code) {
+	case kCodeCNoop:
+		// discard no-ops
+		LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
+		return true;
+
+	case kCodeDInfo:
 		if (recvInfo()) {
 			EVENTQUEUE->addEvent(
 							CEvent(getShapeChangedEvent(), getEventTarget()));
 			return true;
 		}
 		return false;
-	}
-	else if (memcmp(code, kMsgCNoop, 4) == 0) {
-		// discard no-ops
-		LOG((CLOG_DEBUG2 "no-op from", getName().c_str()));
-		return true;
-	}
-	else if (memcmp(code, kMsgCClipboard, 4) == 0) {
+
+	case kCodeCClipboard:
 		return recvGrabClipboard();
-	}
-	else if (memcmp(code, kMsgDClipboard, 4) == 0) {
+
+	case kCodeDClipboard:
 		return recvClipboard();
+
+	default:
+		return false;
 	}
-	return false;
 }
 
 void
@@ -222,6 +277,25 @@ CClientProxy1_0::handleFlatline(const CEvent&, void*)
 	disconnect();
 }
 
+void
+CClientProxy1_0::handleOutputFlushed(const CEvent&, void*)
+{
+	// the link caught up
+	sendHeldMotion();
+}
+
+UInt32
+CClientProxy1_0::getOutputBacklog() const
+{
+	return getStream()->getOutputSize();
+}
+
+UInt32
+CClientProxy1_0::getCoalescedMotionCount() const
+{
+	return m_coalescedMotion;
+}
+
 bool
 CClientProxy1_0::getClipboard(ClipboardID id, IClipboard* clipboard) const
 {
@@ -250,16 +324,18 @@ void
 CClientProxy1_0::enter(SInt32 xAbs, SInt32 yAbs,
 				UInt32 seqNum, KeyModifierMask mask, bool)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send enter to \"%s\", %d,%d %d %04x", getName().c_str(), xAbs, yAbs, seqNum, mask));
-	CProtocolUtil::writef(getStream(), kMsgCEnter,
-								xAbs, yAbs, seqNum, mask);
+	CProtocolUtil::writeMessage(getStream(),
+								CMsgCEnter1_3(xAbs, yAbs, seqNum, mask));
 }
 
 bool
 CClientProxy1_0::leave()
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send leave to \"%s\"", getName().c_str()));
-	CProtocolUtil::writef(getStream(), kMsgCLeave);
+	CProtocolUtil::writeMessage(getStream(), CMsgCLeave());
 
 	// we can never prevent the user from leaving
 	return true;
@@ -284,7 +360,7 @@ void
 CClientProxy1_0::grabClipboard(ClipboardID id)
 {
 	LOG((CLOG_DEBUG "send grab clipboard %d to \"%s\"", id, getName().c_str()));
-	CProtocolUtil::writef(getStream(), kMsgCClipboard, id, 0);
+	CProtocolUtil::writeMessage(getStream(), CMsgCClipboard(id, 0));
 
 	// this clipboard is now dirty
 	m_clipboard[id].m_dirty = true;
@@ -299,44 +375,53 @@ CClientProxy1_0::setClipboardDirty(ClipboardID id, bool dirty)
 void
 CClientProxy1_0::keyDown(KeyID key, KeyModifierMask mask, KeyButton)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
-	CProtocolUtil::writef(getStream(), kMsgDKeyDown1_0, key, mask);
+	CProtocolUtil::writeMessage(getStream(), CMsgDKeyDown1_0(key, mask));
 }
 
 void
 CClientProxy1_0::keyRepeat(KeyID key, KeyModifierMask mask,
 				SInt32 count, KeyButton)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d", getName().c_str(), key, mask, count));
-	CProtocolUtil::writef(getStream(), kMsgDKeyRepeat1_0, key, mask, count);
+	CProtocolUtil::writeMessage(getStream(),
+								CMsgDKeyRepeat1_0(key, mask, count));
 }
 
 void
 CClientProxy1_0::keyUp(KeyID key, KeyModifierMask mask, KeyButton)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
-	CProtocolUtil::writef(getStream(), kMsgDKeyUp1_0, key, mask);
+	CProtocolUtil::writeMessage(getStream(), CMsgDKeyUp1_0(key, mask));
 }
 
 void
 CClientProxy1_0::mouseDown(ButtonID button)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
-	CProtocolUtil::writef(getStream(), kMsgDMouseDown, button);
+	CProtocolUtil::writeMessage(getStream(), CMsgDMouseDown(button));
 }
 
 void
 CClientProxy1_0::mouseUp(ButtonID button)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
-	CProtocolUtil::writef(getStream(), kMsgDMouseUp, button);
+	CProtocolUtil::writeMessage(getStream(), CMsgDMouseUp(button));
 }
 
 void
 CClientProxy1_0::mouseMove(SInt32 xAbs, SInt32 yAbs)
 {
+	if (holdMouseMove(xAbs, yAbs)) {
+		return;
+	}
 	LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
-	CProtocolUtil::writef(getStream(), kMsgDMouseMove, xAbs, yAbs);
+	sendMouseMove(xAbs, yAbs);
 }
 
 void
@@ -349,22 +434,23 @@ void
 CClientProxy1_0::mouseWheel(SInt32, SInt32 yDelta)
 {
 	// clients prior to 1.3 only support the y axis
+	sendHeldMotion();
 	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d", getName().c_str(), yDelta));
-	CProtocolUtil::writef(getStream(), kMsgDMouseWheel1_0, yDelta);
+	CProtocolUtil::writeMessage(getStream(), CMsgDMouseWheel1_0(yDelta));
 }
 
 void
 CClientProxy1_0::screensaver(bool on)
 {
 	LOG((CLOG_DEBUG1 "send screen saver to \"%s\" on=%d", getName().c_str(), on ? 1 : 0));
-	CProtocolUtil::writef(getStream(), kMsgCScreenSaver, on ? 1 : 0);
+	CProtocolUtil::writeMessage(getStream(), CMsgCScreenSaver(on ? 1 : 0));
 }
 
 void
 CClientProxy1_0::resetOptions()
 {
 	LOG((CLOG_DEBUG1 "send reset options to \"%s\"", getName().c_str()));
-	CProtocolUtil::writef(getStream(), kMsgCResetOptions);
+	CProtocolUtil::writeMessage(getStream(), CMsgCResetOptions());
 
 	// reset heart rate and death
 	resetHeartbeatRate();
@@ -392,15 +478,142 @@ CClientProxy1_0::setOptions(const COptionsList& options)
 	}
 }
 
+void
+CClientProxy1_0::sendMouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	CProtocolUtil::writeMessage(getStream(), CMsgDMouseMove1_3(xAbs, yAbs));
+}
+
+void
+CClientProxy1_0::sendMouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+	// the message only has room for 16 bit deltas.  held motion can
+	// add up to more than that.
+	do {
+		const SInt16 dx = clampDelta(xRel);
+		const SInt16 dy = clampDelta(yRel);
+		CProtocolUtil::writeMessage(getStream(), CMsgDMouseRelMove(dx, dy));
+		xRel -= dx;
+		yRel -= dy;
+	} while (xRel != 0 || yRel != 0);
+}
+
+bool
+CClientProxy1_0::readInfo(CClientInfo& info)
+{
+	CMsgDInfo1_3 msg;
+	if (!CProtocolUtil::readMessage(getStream(), msg)) {
+		return false;
+	}
+	info.m_x  = msg.m_x;
+	info.m_y  = msg.m_y;
+	info.m_w  = msg.m_w;
+	info.m_h  = msg.m_h;
+	info.m_mx = msg.m_mx;
+	info.m_my = msg.m_my;
+	return true;
+}
+
+bool
+CClientProxy1_0::isOutputBackedUp() const
+{
+	return (getStream()->getOutputSize() >= kMaxOutputBacklog);
+}
+
+SInt16
+CClientProxy1_0::clampDelta(SInt32 delta)
+{
+	if (delta > 32767) {
+		return 32767;
+	}
+	if (delta < -32768) {
+		return -32768;
+	}
+	return static_cast<SInt16>(delta);
+}
+
+void
+CClientProxy1_0::addCoalescedMotion(UInt32 n)
+{
+	m_coalescedMotion += n;
+}
+
+bool
+CClientProxy1_0::holdMouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	if (!isOutputBackedUp()) {
+		sendHeldMotion();
+		return false;
+	}
+
+	// absolute motion supersedes anything held
+	if (m_absHeld || m_relHeld) {
+		++m_coalescedMotion;
+	}
+	else {
+		LOG((CLOG_DEBUG1 "client \"%s\" is backed up with %d bytes queued, holding mouse motion", getName().c_str(), getOutputBacklog()));
+	}
+	m_relHeld  = false;
+	m_absHeld  = true;
+	m_xAbsHeld = xAbs;
+	m_yAbsHeld = yAbs;
+	return true;
+}
+
+bool
+CClientProxy1_0::holdMouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+	if (!isOutputBackedUp()) {
+		sendHeldMotion();
+		return false;
+	}
+
+	// relative motion adds to relative motion already held
+	if (m_relHeld) {
+		++m_coalescedMotion;
+		m_xRelHeld += xRel;
+		m_yRelHeld += yRel;
+	}
+	else {
+		if (!m_absHeld) {
+			LOG((CLOG_DEBUG1 "client \"%s\" is backed up with %d bytes queued, holding mouse motion", getName().c_str(), getOutputBacklog()));
+		}
+		m_relHeld  = true;
+		m_xRelHeld = xRel;
+		m_yRelHeld = yRel;
+	}
+	return true;
+}
+
+void
+CClientProxy1_0::sendHeldMotion()
+{
+	if (!m_absHeld && !m_relHeld) {
+		return;
+	}
+
+	LOG((CLOG_DEBUG1 "send held mouse motion to \"%s\", %d moves coalesced so far", getName().c_str(), m_coalescedMotion));
+	if (m_absHeld) {
+		m_absHeld = false;
+		sendMouseMove(m_xAbsHeld, m_yAbsHeld);
+	}
+	if (m_relHeld) {
+		m_relHeld = false;
+		sendMouseRelativeMove(m_xRelHeld, m_yRelHeld);
+	}
+}
+
 bool
 CClientProxy1_0::recvInfo()
 {
 	// parse the message
-	SInt16 x, y, w, h, dummy1, mx, my;
-	if (!CProtocolUtil::readf(getStream(), kMsgDInfo + 4,
-							&x, &y, &w, &h, &dummy1, &mx, &my)) {
+	CClientInfo info;
+	if (!readInfo(info)) {
 		return false;
 	}
+	SInt32 x  = info.m_x,  y  = info.m_y;
+	SInt32 w  = info.m_w,  h  = info.m_h;
+	SInt32 mx = info.m_mx, my = info.m_my;
 	LOG((CLOG_DEBUG "received client \"%s\" info shape=%d,%d %dx%d at %d,%d", getName().c_str(), x, y, w, h, mx, my));
 
 	// validate
@@ -422,7 +635,7 @@ CClientProxy1_0::recvInfo()
 
 	// acknowledge receipt
 	LOG((CLOG_DEBUG1 "send info ack to \"%s\"", getName().c_str()));
-	CProtocolUtil::writef(getStream(), kMsgCInfoAck);
+	CProtocolUtil::writeMessage(getStream(), CMsgCInfoAck());
 	return true;
 }
 
@@ -462,11 +675,12 @@ bool
 CClientProxy1_0::recvGrabClipboard()
 {
 	// parse message
-	ClipboardID id;
-	UInt32 seqNum;
-	if (!CProtocolUtil::readf(getStream(), kMsgCClipboard + 4, &id, &seqNum)) {
+	CMsgCClipboard msg;
+	if (!CProtocolUtil::readMessage(getStream(), msg)) {
 		return false;
 	}
+	ClipboardID id = msg.m_id;
+	UInt32 seqNum  = msg.m_seqNum;
 	LOG((CLOG_DEBUG "received client \"%s\" grabbed clipboard %d seqnum=%d", getName().c_str(), id, seqNum));
 
 	// validate
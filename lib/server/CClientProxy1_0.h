@@ -28,6 +28,26 @@ public:
 	CClientProxy1_0(const CString& name, IStream* adoptedStream);
 	~CClientProxy1_0();
 
+	//! @name accessors
+	//@{
+
+	//! Get output backlog
+	/*!
+	Returns the number of bytes waiting to be sent to the client because
+	its link can't keep up.
+	*/
+	UInt32				getOutputBacklog() const;
+
+	//! Get coalesced motion count
+	/*!
+	Returns the number of mouse motion messages that were never sent
+	because a later position superseded them while the client's link
+	was backed up.
+	*/
+	UInt32				getCoalescedMotionCount() const;
+
+	//@}
+
 	// IScreen
 	virtual bool		getClipboard(ClipboardID id, IClipboard*) const;
 	virtual void		getShape(SInt32& x, SInt32& y,
@@ -56,8 +76,8 @@ public:
 	virtual void		setOptions(const COptionsList& options);
 
 protected:
-	virtual bool		parseHandshakeMessage(const UInt8* code);
-	virtual bool		parseMessage(const UInt8* code);
+	virtual bool		parseHandshakeMessage(UInt32 code);
+	virtual bool		parseMessage(UInt32 code);
 
 	virtual void		resetHeartbeatRate();
 	virtual void		setHeartbeatRate(double rate, double alarm);
@@ -65,21 +85,102 @@ protected:
 	virtual void		addHeartbeatTimer();
 	virtual void		removeHeartbeatTimer();
 
-private:
+	//! Send absolute motion
+	/*!
+	Writes a mouse move message in this protocol version's format.
+	*/
+	virtual void		sendMouseMove(SInt32 xAbs, SInt32 yAbs);
+
+	//! Send relative motion
+	/*!
+	Writes a relative mouse move message in this protocol version's
+	format, or several if the motion doesn't fit in one.  Only clients
+	implementing protocol 1.2 or later accept relative motion.
+	*/
+	virtual void		sendMouseRelativeMove(SInt32 xRel, SInt32 yRel);
+
+	//! Read screen info
+	/*!
+	Reads the parameters of a kMsgDInfo message, in this protocol
+	version's format, into \c info.  Returns false if the message
+	couldn't be read.
+	*/
+	virtual bool		readInfo(CClientInfo& info);
+
+	//! Test if the client's link is backed up
+	/*!
+	Returns true if so much output is waiting to be written to the
+	client that mouse motion should be held back.
+	*/
+	bool				isOutputBackedUp() const;
+
+	//! Clamp a delta to 16 bits
+	/*!
+	Returns \c delta clamped to fit the 16 bit deltas of the relative
+	motion and wheel messages.  Bigger deltas must be sent in steps.
+	*/
+	static SInt16		clampDelta(SInt32 delta);
+
+	//! Note coalesced motion
+	/*!
+	Adds \c n to the count returned by \c getCoalescedMotionCount().
+	*/
+	void				addCoalescedMotion(UInt32 n);
+
+	//! Hold back absolute motion
+	/*!
+	If the client's link is backed up then remembers the motion to send
+	later, replacing any motion already held, and returns true.
+	Otherwise sends any held motion and returns false.
+	*/
+	bool				holdMouseMove(SInt32 xAbs, SInt32 yAbs);
+
+	//! Hold back relative motion
+	/*!
+	Like \c holdMouseMove() except relative motion accumulates on top of
+	any held motion.
+	*/
+	bool				holdMouseRelativeMove(SInt32 xRel, SInt32 yRel);
+
+	//! Send held motion
+	/*!
+	Sends any motion held back by \c holdMouseMove() or
+	\c holdMouseRelativeMove().  This must be called before sending
+	any other input so the client sees events in order.
+	*/
+	virtual void		sendHeldMotion();
+
+	//! Disconnect
+	/*!
+	Stops handling the stream, closes it and sends the disconnected
+	event.  Does nothing if already disconnected.
+	*/
 	void				disconnect();
+
+	//! Reconnect
+	/*!
+	Disconnects if not already disconnected then uses \p adoptedStream,
+	a new connection from the same client that has completed the
+	greeting handshake, in place of the old stream.
+	*/
+	void				reconnect(IStream* adoptedStream);
+
+private:
+	void				addHandlers();
 	void				removeHandlers();
 
 	void				handleData(const CEvent&, void*);
 	void				handleDisconnect(const CEvent&, void*);
 	void				handleWriteError(const CEvent&, void*);
 	void				handleFlatline(const CEvent&, void*);
+	void				handleOutputFlushed(const CEvent&, void*);
 
 	bool				recvInfo();
 	bool				recvClipboard();
 	bool				recvGrabClipboard();
 
 private:
-	typedef bool (CClientProxy1_0::*MessageParser)(const UInt8*);
+	typedef bool (CClientProxy1_0::*MessageParser)(UInt32);
 	struct CClientClipboard {
 	public:
 		CClientClipboard();
@@ -95,6 +196,17 @@ private:
 	double				m_heartbeatAlarm;
 	CEventQueueTimer*	m_heartbeatTimer;
 	MessageParser		m_parser;
+	bool				m_disconnected;
+
+	// motion held back while the client's link is backed up
+	static const UInt32	kMaxOutputBacklog;
+	bool				m_absHeld;
+	SInt32				m_xAbsHeld;
+	SInt32				m_yAbsHeld;
+	bool				m_relHeld;
+	SInt32				m_xRelHeld;
+	SInt32				m_yRelHeld;
+	UInt32				m_coalescedMotion;
 };
 
 #endif
@@ -35,21 +35,25 @@ CClientProxy1_1::~CClientProxy1_1()
 void
 CClientProxy1_1::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
-	CProtocolUtil::writef(getStream(), kMsgDKeyDown, key, mask, button);
+	CProtocolUtil::writeMessage(getStream(), CMsgDKeyDown(key, mask, button));
 }
 
 void
 CClientProxy1_1::keyRepeat(KeyID key, KeyModifierMask mask,
 				SInt32 count, KeyButton button)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d, button=0x%04x", getName().c_str(), key, mask, count, button));
-	CProtocolUtil::writef(getStream(), kMsgDKeyRepeat, key, mask, count, button);
+	CProtocolUtil::writeMessage(getStream(),
+								CMsgDKeyRepeat(key, mask, count, button));
 }
 
 void
 CClientProxy1_1::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
-	CProtocolUtil::writef(getStream(), kMsgDKeyUp, key, mask, button);
+	CProtocolUtil::writeMessage(getStream(), CMsgDKeyUp(key, mask, button));
 }
@@ -34,6 +34,9 @@ CClientProxy1_2::~CClientProxy1_2()
 void
 CClientProxy1_2::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
 {
+	if (holdMouseRelativeMove(xRel, yRel)) {
+		return;
+	}
 	LOG((CLOG_DEBUG2 "send mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
-	CProtocolUtil::writef(getStream(), kMsgDMouseRelMove, xRel, yRel);
+	sendMouseRelativeMove(xRel, yRel);
 }
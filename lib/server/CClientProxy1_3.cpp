@@ -39,20 +39,22 @@ CClientProxy1_3::~CClientProxy1_3()
 void
 CClientProxy1_3::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
+	sendHeldMotion();
 	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
-	CProtocolUtil::writef(getStream(), kMsgDMouseWheel, xDelta, yDelta);
+	CProtocolUtil::writeMessage(getStream(), CMsgDMouseWheel(xDelta, yDelta));
 }
 
 bool
-CClientProxy1_3::parseMessage(const UInt8* code)
+CClientProxy1_3::parseMessage(UInt32 code)
 {
 	// process message
-	if (memcmp(code, kMsgCKeepAlive, 4) == 0) {
+	switch (code) {
+	case kCodeCKeepAlive:
 		// reset alarm
 		resetHeartbeatTimer();
 		return true;
-	}
-	else {
+
+	default:
 		return CClientProxy1_2::parseMessage(code);
 	}
 }
@@ -70,14 +72,6 @@ CClientProxy1_3::setHeartbeatRate(double rate, double)
 	CClientProxy1_2::setHeartbeatRate(rate, rate * kKeepAlivesUntilDeath);
 }
 
-void
-CClientProxy1_3::resetHeartbeatTimer()
-{
-	// reset the alarm but not the keep alive timer
-	CClientProxy1_2::removeHeartbeatTimer();
-	CClientProxy1_2::addHeartbeatTimer();
-}
-
 void
 CClientProxy1_3::addHeartbeatTimer()
 {
@@ -110,5 +104,5 @@ CClientProxy1_3::removeHeartbeatTimer()
 void
 CClientProxy1_3::handleKeepAlive(const CEvent&, void*)
 {
-	CProtocolUtil::writef(getStream(), kMsgCKeepAlive);
+	CProtocolUtil::writeMessage(getStream(), CMsgCKeepAlive());
 }
@@ -28,10 +28,9 @@ public:
 
 protected:
 	// CClientProxy overrides
-	virtual bool		parseMessage(const UInt8* code);
+	virtual bool		parseMessage(UInt32 code);
 	virtual void		resetHeartbeatRate();
 	virtual void		setHeartbeatRate(double rate, double alarm);
-	virtual void		resetHeartbeatTimer();
 	virtual void		addHeartbeatTimer();
 	virtual void		removeHeartbeatTimer();
 
@@ -0,0 +1,737 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CClientProxy1_4.h"
+#include "CMotionChannel.h"
+#include "CProtocolUtil.h"
+#include "CLog.h"
+#include "IEventQueue.h"
+#include "TMethodEventJob.h"
+#include "CArch.h"
+
+// key repeat delay and interval assumed until we've seen the primary
+// repeat a key and the range of believable values
+static const double		kDefaultRepeatDelay    = 0.5;
+static const double		kDefaultRepeatInterval = 1.0 / 30.0;
+static const double		kMinRepeatTime         = 0.005;
+static const double		kMaxRepeatTime         = 2.0;
+
+//
+// CClientProxy1_4
+//
+
+CClientProxy1_4::CSessionMap	CClientProxy1_4::s_sessions;
+
+CClientProxy1_4::CClientProxy1_4(const CString& name, IStream* stream) :
+	CClientProxy1_3(name, stream),
+	m_batchSize(0),
+	m_flushPending(false),
+	m_wheelHeld(false),
+	m_xWheel(0),
+	m_yWheel(0),
+	m_wheelCount(0),
+	m_xCompact(0),
+	m_yCompact(0),
+	m_repeatButton(0),
+	m_repeatLocal(false),
+	m_repeatCount(0),
+	m_repeatTime(0.0),
+	m_repeatDelay(0.0),
+	m_repeatInterval(0.0),
+	m_motionChannel(NULL),
+	m_motionToken(0),
+	m_motionSeq(0),
+	m_motionAbsSeq(0),
+	m_xMotion(0),
+	m_yMotion(0),
+	m_dxMotion(0),
+	m_dyMotion(0),
+	m_motionSync(false),
+	m_session(0)
+{
+	EVENTQUEUE->adoptHandler(CEvent::kFlush, this,
+							new TMethodEventJob<CClientProxy1_4>(this,
+								&CClientProxy1_4::handleFlush));
+}
+
+CClientProxy1_4::~CClientProxy1_4()
+{
+	EVENTQUEUE->removeHandler(CEvent::kFlush, this);
+	if (m_motionChannel != NULL) {
+		m_motionChannel->removeClient(m_motionToken);
+		m_motionChannel->unref();
+	}
+	setResumable(false);
+}
+
+void
+CClientProxy1_4::setMotionChannel(CMotionChannel* channel,
+				const CNetworkAddress& peer)
+{
+	assert(m_motionChannel == NULL);
+	assert(channel != NULL);
+
+	m_motionChannel = channel;
+	m_motionChannel->ref();
+	m_motionToken   = m_motionChannel->addClient(peer);
+	LOG((CLOG_DEBUG1 "send motion channel to \"%s\"", getName().c_str()));
+	CProtocolUtil::writeMessage(getStream(),
+							CMsgCMotionChannel(m_motionToken));
+}
+
+void
+CClientProxy1_4::setSession(UInt32 token, const CNetworkAddress& peer)
+{
+	assert(m_session == 0);
+
+	m_session     = token;
+	m_sessionPeer = peer;
+}
+
+void
+CClientProxy1_4::setResumable(bool resumable)
+{
+	if (m_session == 0) {
+		return;
+	}
+	CSessionMap::iterator i = s_sessions.find(m_session);
+	if (resumable) {
+		assert(i == s_sessions.end() || i->second == this);
+		s_sessions[m_session] = this;
+	}
+	else if (i != s_sessions.end() && i->second == this) {
+		s_sessions.erase(i);
+	}
+}
+
+void
+CClientProxy1_4::resume(IStream* stream)
+{
+	LOG((CLOG_NOTE "client \"%s\" has resumed its session", getName().c_str()));
+	reconnect(stream);
+
+	// input held for the old link is stale
+	m_batchSize    = 0;
+	m_wheelHeld    = false;
+	m_wheelCount   = 0;
+	m_repeatButton = 0;
+
+	// the client opens a new motion channel, if any
+	if (m_motionChannel != NULL) {
+		m_motionChannel->removeClient(m_motionToken);
+		m_motionChannel->unref();
+		m_motionChannel = NULL;
+		m_motionToken   = 0;
+	}
+	m_motionSeq    = 0;
+	m_motionAbsSeq = 0;
+	m_motionSync   = false;
+
+	EVENTQUEUE->addEvent(CEvent(getResumedEvent(), getEventTarget()));
+}
+
+CClientProxy1_4*
+CClientProxy1_4::findSession(UInt32 token, const CNetworkAddress& peer)
+{
+	CSessionMap::const_iterator i = s_sessions.find(token);
+	if (i == s_sessions.end() || !peer.isSameHost(i->second->m_sessionPeer)) {
+		return NULL;
+	}
+	return i->second;
+}
+
+UInt32
+CClientProxy1_4::newSessionToken(UInt32 other)
+{
+	// a token lets a connection take over the client's session so each
+	// is drawn independently and can't be worked out from another
+	UInt32 token;
+	do {
+		ARCH->getRandom(&token, sizeof(token));
+	} while (token <= 1 || token == other || s_sessions.count(token) != 0);
+	return token;
+}
+
+void
+CClientProxy1_4::enter(SInt32 xAbs, SInt32 yAbs,
+				UInt32 seqNum, KeyModifierMask mask, bool)
+{
+	sendHeldMotion();
+	LOG((CLOG_DEBUG1 "send enter to \"%s\", %d,%d %d %04x", getName().c_str(), xAbs, yAbs, seqNum, mask));
+	CProtocolUtil::writeMessage(getStream(),
+								CMsgCEnter(xAbs, yAbs, seqNum, mask));
+	m_xCompact = xAbs;
+	m_yCompact = yAbs;
+
+	// the enter counts as absolute motion on the side channel
+	if (m_motionChannel != NULL) {
+		m_motionAbsSeq = nextMotionSeq();
+		m_xMotion      = xAbs;
+		m_yMotion      = yAbs;
+		m_dxMotion     = 0;
+		m_dyMotion     = 0;
+	}
+}
+
+void
+CClientProxy1_4::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+	// note the press so we can time the primary's repeat
+	m_repeatButton = button;
+	m_repeatLocal  = isLocalRepeat(key);
+	m_repeatCount  = 0;
+	m_repeatTime   = ARCH->time();
+
+	if (m_repeatLocal) {
+		sendKeyDownRepeat(key, mask, button);
+		return;
+	}
+	if (!isCompact()) {
+		CClientProxy1_3::keyDown(key, mask, button);
+		return;
+	}
+	sendHeldMotion();
+	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+	sendCompactKey(kCompactKeyDown, key, mask, 1, button);
+}
+
+void
+CClientProxy1_4::keyRepeat(KeyID key, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	// the client repeats the key last pressed itself
+	timeKeyRepeat(button, count);
+	if (button == m_repeatButton && m_repeatLocal) {
+		return;
+	}
+
+	if (!isCompact()) {
+		CClientProxy1_3::keyRepeat(key, mask, count, button);
+		return;
+	}
+	sendHeldMotion();
+	LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d, button=0x%04x", getName().c_str(), key, mask, count, button));
+	sendCompactKey(kCompactKeyRepeat, key, mask, count, button);
+}
+
+void
+CClientProxy1_4::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+	if (button == m_repeatButton) {
+		m_repeatButton = 0;
+	}
+
+	if (!isCompact()) {
+		CClientProxy1_3::keyUp(key, mask, button);
+		return;
+	}
+	sendHeldMotion();
+	LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
+	sendCompactKey(kCompactKeyUp, key, mask, 1, button);
+}
+
+void
+CClientProxy1_4::mouseDown(ButtonID button)
+{
+	if (!isCompact()) {
+		CClientProxy1_3::mouseDown(button);
+		return;
+	}
+	sendHeldMotion();
+	LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
+	UInt8 buffer[kMaxCompactRecord];
+	buffer[0] = kCompactMouseDown;
+	getStream()->write(buffer,
+					1 + CProtocolUtil::encodeVarint(buffer + 1, button));
+}
+
+void
+CClientProxy1_4::mouseUp(ButtonID button)
+{
+	if (!isCompact()) {
+		CClientProxy1_3::mouseUp(button);
+		return;
+	}
+	sendHeldMotion();
+	LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
+	UInt8 buffer[kMaxCompactRecord];
+	buffer[0] = kCompactMouseUp;
+	getStream()->write(buffer,
+					1 + CProtocolUtil::encodeVarint(buffer + 1, button));
+}
+
+void
+CClientProxy1_4::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	if (sendChannelMotion(true, xAbs, yAbs)) {
+		// keep the base for compact motion current
+		m_xCompact = xAbs;
+		m_yCompact = yAbs;
+		return;
+	}
+
+	// absolute motion supersedes relative motion held back while the
+	// client's link is backed up.  otherwise holdMouseMove() sends
+	// the batch before the move.
+	if (m_batchSize > 0 && isOutputBackedUp()) {
+		addCoalescedMotion(m_batchSize);
+		m_batchSize = 0;
+	}
+	CClientProxy1_3::mouseMove(xAbs, yAbs);
+}
+
+void
+CClientProxy1_4::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+	if (sendChannelMotion(false, xRel, yRel)) {
+		return;
+	}
+
+	// send each sample on its own if the client can't take batches
+	UInt32 limit = getCapability(kCapMotionBatch);
+	if (limit < 2) {
+		CClientProxy1_3::mouseRelativeMove(xRel, yRel);
+		return;
+	}
+	if (limit > kMaxMotionBatch) {
+		limit = kMaxMotionBatch;
+	}
+
+	LOG((CLOG_DEBUG2 "batch mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
+	addMotionSample(xRel, yRel, limit);
+
+	// send the batch once the current event has been handled.  if
+	// we're not handling an event then send it now.  if the client's
+	// link is backed up then hold the batch until it catches up.
+	if (!m_flushPending && !isOutputBackedUp()) {
+		if (EVENTQUEUE->addFlush(this)) {
+			m_flushPending = true;
+		}
+		else {
+			sendMotionBatch();
+		}
+	}
+}
+
+void
+CClientProxy1_4::mouseWheel(SInt32 xDelta, SInt32 yDelta)
+{
+	// motion before the scroll goes first.  scrolling already held
+	// goes out ahead of motion held after it so don't flush that.
+	if (!m_wheelHeld) {
+		sendHeldMotion();
+	}
+
+	// add to the scrolling not yet sent.  a burst of small deltas from
+	// a touchpad or free spinning wheel goes out as a single message.
+	LOG((CLOG_DEBUG2 "hold mouse wheel for \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
+	m_wheelHeld = true;
+	m_xWheel   += xDelta;
+	m_yWheel   += yDelta;
+	++m_wheelCount;
+
+	// send once the current event has been handled, as for motion
+	// batches, or when the client's link catches up
+	if (!m_flushPending && !isOutputBackedUp()) {
+		if (EVENTQUEUE->addFlush(this)) {
+			m_flushPending = true;
+		}
+		else {
+			sendMouseWheel();
+		}
+	}
+}
+
+void
+CClientProxy1_4::sendMouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	if (!isCompact()) {
+		CProtocolUtil::writeMessage(getStream(), CMsgDMouseMove(xAbs, yAbs));
+	}
+	else {
+		UInt8 buffer[kMaxCompactRecord];
+		UInt8* dst = buffer;
+		*dst++ = kCompactMouseMove;
+		dst   += CProtocolUtil::encodeSignedVarint(dst, xAbs - m_xCompact);
+		dst   += CProtocolUtil::encodeSignedVarint(dst, yAbs - m_yCompact);
+		getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+	}
+	m_xCompact = xAbs;
+	m_yCompact = yAbs;
+}
+
+void
+CClientProxy1_4::sendMouseRelativeMove(SInt32 xRel, SInt32 yRel)
+{
+	if (!isCompact()) {
+		CClientProxy1_3::sendMouseRelativeMove(xRel, yRel);
+		return;
+	}
+	UInt8 buffer[kMaxCompactRecord];
+	UInt8* dst = buffer;
+	*dst++ = kCompactMouseRelMove;
+	dst   += CProtocolUtil::encodeSignedVarint(dst, xRel);
+	dst   += CProtocolUtil::encodeSignedVarint(dst, yRel);
+	getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+}
+
+bool
+CClientProxy1_4::readInfo(CClientInfo& info)
+{
+	CMsgDInfo msg;
+	if (!CProtocolUtil::readMessage(getStream(), msg)) {
+		return false;
+	}
+	info.m_x  = msg.m_x;
+	info.m_y  = msg.m_y;
+	info.m_w  = msg.m_w;
+	info.m_h  = msg.m_h;
+	info.m_mx = msg.m_mx;
+	info.m_my = msg.m_my;
+	return true;
+}
+
+void
+CClientProxy1_4::sendHeldMotion()
+{
+	sendMouseWheel();
+	sendMotionSync();
+	CClientProxy1_3::sendHeldMotion();
+	sendMotionBatch();
+}
+
+void
+CClientProxy1_4::addMotionSample(SInt32 xRel, SInt32 yRel, UInt32 limit)
+{
+	const double now = ARCH->time();
+	do {
+		// each sample must fit the 16 bit deltas of the batch message
+		// so bigger moves take several samples
+		const SInt16 dx = clampDelta(xRel);
+		const SInt16 dy = clampDelta(yRel);
+		xRel -= dx;
+		yRel -= dy;
+
+		if (m_batchSize >= limit) {
+			// merge into the last sample rather than let held motion
+			// grow without bound.  if the merged sample wouldn't fit
+			// then send the batch and start a new one instead.
+			CMotionSample& last = m_batch[m_batchSize - 1];
+			const SInt32 xLast  = last.m_dx + dx;
+			const SInt32 yLast  = last.m_dy + dy;
+			if (isOutputBackedUp() &&
+				clampDelta(xLast) == xLast && clampDelta(yLast) == yLast) {
+				last.m_dx   = xLast;
+				last.m_dy   = yLast;
+				last.m_time = now;
+				addCoalescedMotion(1);
+				continue;
+			}
+			sendMouseWheel();
+			sendMotionBatch();
+		}
+
+		CMotionSample& sample = m_batch[m_batchSize++];
+		sample.m_dx   = dx;
+		sample.m_dy   = dy;
+		sample.m_time = now;
+	} while (xRel != 0 || yRel != 0);
+}
+
+void
+CClientProxy1_4::sendMouseWheel()
+{
+	if (!m_wheelHeld) {
+		return;
+	}
+	m_wheelHeld = false;
+
+	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d from %d events", getName().c_str(), m_xWheel, m_yWheel, m_wheelCount));
+	if (isCompact()) {
+		UInt8 buffer[kMaxCompactRecord];
+		UInt8* dst = buffer;
+		*dst++ = kCompactMouseWheel;
+		dst   += CProtocolUtil::encodeSignedVarint(dst, m_xWheel);
+		dst   += CProtocolUtil::encodeSignedVarint(dst, m_yWheel);
+		getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+	}
+	else {
+		// the message only has room for 16 bit deltas
+		while (m_xWheel != 0 || m_yWheel != 0) {
+			const SInt16 dx = clampDelta(m_xWheel);
+			const SInt16 dy = clampDelta(m_yWheel);
+			CProtocolUtil::writeMessage(getStream(), CMsgDMouseWheel(dx, dy));
+			m_xWheel -= dx;
+			m_yWheel -= dy;
+		}
+	}
+	m_xWheel     = 0;
+	m_yWheel     = 0;
+	m_wheelCount = 0;
+}
+
+void
+CClientProxy1_4::sendMotionBatch()
+{
+	if (m_batchSize == 0) {
+		return;
+	}
+
+	// a lone sample is cheaper as a plain relative move
+	if (m_batchSize == 1) {
+		m_batchSize = 0;
+		LOG((CLOG_DEBUG2 "send mouse relative move to \"%s\" %d,%d", getName().c_str(), m_batch[0].m_dx, m_batch[0].m_dy));
+		sendMouseRelativeMove(m_batch[0].m_dx, m_batch[0].m_dy);
+		return;
+	}
+
+	// compact clients get a record per sample, all in one write
+	if (isCompact()) {
+		UInt8 buffer[kMaxCompactRecord * kMaxMotionBatch];
+		UInt8* dst = buffer;
+		for (UInt32 i = 0; i < m_batchSize; ++i) {
+			const CMotionSample& sample = m_batch[i];
+			*dst++ = static_cast<UInt8>((i == 0) ? kCompactMouseRelMove :
+											kCompactMouseRelMoveTimed);
+			dst   += CProtocolUtil::encodeSignedVarint(dst, sample.m_dx);
+			dst   += CProtocolUtil::encodeSignedVarint(dst, sample.m_dy);
+			if (i > 0) {
+				dst += CProtocolUtil::encodeVarint(dst, getSampleInterval(i));
+			}
+		}
+		LOG((CLOG_DEBUG2 "send %d mouse relative moves to \"%s\"", m_batchSize, getName().c_str()));
+		m_batchSize = 0;
+		getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+		return;
+	}
+
+	// encode the message header then dx, dy and the microseconds
+	// since the previous sample for each sample
+	UInt8 buffer[CMsgDMouseRelMoveBatch::kSize + 6 * kMaxMotionBatch];
+	UInt8* dst = buffer + CProtocolUtil::encode(buffer,
+							CMsgDMouseRelMoveBatch(3 * m_batchSize));
+	for (UInt32 i = 0; i < m_batchSize; ++i) {
+		const CMotionSample& sample = m_batch[i];
+		const UInt16 us = getSampleInterval(i);
+		const UInt16 dx = static_cast<UInt16>(sample.m_dx);
+		const UInt16 dy = static_cast<UInt16>(sample.m_dy);
+		*dst++ = static_cast<UInt8>(dx >> 8);
+		*dst++ = static_cast<UInt8>(dx);
+		*dst++ = static_cast<UInt8>(dy >> 8);
+		*dst++ = static_cast<UInt8>(dy);
+		*dst++ = static_cast<UInt8>(us >> 8);
+		*dst++ = static_cast<UInt8>(us);
+	}
+	LOG((CLOG_DEBUG2 "send %d mouse relative moves to \"%s\"", m_batchSize, getName().c_str()));
+	m_batchSize = 0;
+	getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+}
+
+UInt16
+CClientProxy1_4::getSampleInterval(UInt32 i) const
+{
+	if (i == 0) {
+		return 0;
+	}
+	const double dt = 1.0e+6 * (m_batch[i].m_time - m_batch[i - 1].m_time);
+	if (dt <= 0.0) {
+		return 0;
+	}
+	else if (dt >= 65535.0) {
+		return 65535;
+	}
+	else {
+		return static_cast<UInt16>(dt);
+	}
+}
+
+bool
+CClientProxy1_4::isCompact() const
+{
+	return (getCapability(kCapCompactInput) != 0);
+}
+
+void
+CClientProxy1_4::sendCompactKey(UInt8 opcode, KeyID key,
+				KeyModifierMask mask, SInt32 count, KeyButton button)
+{
+	UInt8 buffer[kMaxCompactRecord];
+	UInt8* dst = buffer;
+	*dst++ = opcode;
+	dst   += CProtocolUtil::encodeVarint(dst, key);
+	dst   += CProtocolUtil::encodeVarint(dst, mask);
+	if (opcode == kCompactKeyRepeat) {
+		dst += CProtocolUtil::encodeVarint(dst, static_cast<UInt32>(count));
+	}
+	dst   += CProtocolUtil::encodeVarint(dst, button);
+	getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+}
+
+bool
+CClientProxy1_4::isLocalRepeat(KeyID key) const
+{
+	if (getCapability(kCapKeyRepeat) == 0) {
+		return false;
+	}
+	switch (key) {
+	case kKeyAltGr:
+	case kKeyNumLock:
+	case kKeyScrollLock:
+		return false;
+
+	default:
+		return (key < kKeyShift_L || key > kKeyHyper_R);
+	}
+}
+
+void
+CClientProxy1_4::sendKeyDownRepeat(KeyID key,
+				KeyModifierMask mask, KeyButton button)
+{
+	sendHeldMotion();
+	const double delaySecs    = (m_repeatDelay > 0.0) ?
+									m_repeatDelay : kDefaultRepeatDelay;
+	const double intervalSecs = (m_repeatInterval > 0.0) ?
+									m_repeatInterval : kDefaultRepeatInterval;
+	const UInt16 delay    = static_cast<UInt16>(1000.0 * delaySecs + 0.5);
+	const UInt16 interval = static_cast<UInt16>(1000.0 * intervalSecs + 0.5);
+	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x, repeat %d/%dms", getName().c_str(), key, mask, button, delay, interval));
+	if (!isCompact()) {
+		CProtocolUtil::writeMessage(getStream(),
+							CMsgDKeyDownRepeat(key, mask, button,
+											delay, interval));
+		return;
+	}
+
+	UInt8 buffer[kMaxCompactRecord];
+	UInt8* dst = buffer;
+	*dst++ = kCompactKeyDownRepeat;
+	dst   += CProtocolUtil::encodeVarint(dst, key);
+	dst   += CProtocolUtil::encodeVarint(dst, mask);
+	dst   += CProtocolUtil::encodeVarint(dst, button);
+	dst   += CProtocolUtil::encodeVarint(dst, delay);
+	dst   += CProtocolUtil::encodeVarint(dst, interval);
+	getStream()->write(buffer, static_cast<UInt32>(dst - buffer));
+}
+
+void
+CClientProxy1_4::timeKeyRepeat(KeyButton button, SInt32 count)
+{
+	if (button != m_repeatButton || button == 0 || count <= 0) {
+		return;
+	}
+
+	// the first repeat comes after the delay and the rest come every
+	// interval.  take the first sample of each as is and average later
+	// ones to smooth out scheduling jitter.
+	const double now = ARCH->time();
+	double sample    = now - m_repeatTime;
+	double* estimate = &m_repeatDelay;
+	if (m_repeatCount > 0) {
+		sample  /= count;
+		estimate = &m_repeatInterval;
+	}
+	m_repeatTime   = now;
+	m_repeatCount += count;
+	if (sample >= kMinRepeatTime && sample <= kMaxRepeatTime) {
+		if (*estimate == 0.0) {
+			*estimate = sample;
+		}
+		else {
+			*estimate += 0.25 * (sample - *estimate);
+		}
+	}
+}
+
+bool
+CClientProxy1_4::sendChannelMotion(bool absolute, SInt32 x, SInt32 y)
+{
+	if (m_motionChannel == NULL || !m_motionChannel->isOpen(m_motionToken)) {
+		return false;
+	}
+
+	// anything held for the stream goes first
+	sendMouseWheel();
+	CClientProxy1_3::sendHeldMotion();
+	sendMotionBatch();
+
+	// absolute motion makes earlier motion moot.  relative motion adds
+	// to the sum since then so a lost update costs nothing once a later
+	// one arrives.  the sum wraps.
+	const UInt32 seq = nextMotionSeq();
+	if (absolute) {
+		m_motionAbsSeq = seq;
+		m_xMotion      = x;
+		m_yMotion      = y;
+		m_dxMotion     = 0;
+		m_dyMotion     = 0;
+	}
+	else {
+		m_dxMotion     = static_cast<SInt32>(
+							static_cast<UInt32>(m_dxMotion) + x);
+		m_dyMotion     = static_cast<SInt32>(
+							static_cast<UInt32>(m_dyMotion) + y);
+	}
+	m_motionSync = true;
+
+	// a datagram that can't be sent is as good as lost
+	LOG((CLOG_DEBUG2 "send mouse %s %d,%d to \"%s\" as motion %u", absolute ? "move" : "relative move", x, y, getName().c_str(), seq));
+	UInt8 buffer[CMsgMotionUpdate::kSize];
+	m_motionChannel->send(m_motionToken, buffer,
+							CProtocolUtil::encode(buffer,
+								CMsgMotionUpdate(m_motionToken, seq,
+									m_motionAbsSeq, m_xMotion, m_yMotion,
+									m_dxMotion, m_dyMotion)));
+	return true;
+}
+
+UInt32
+CClientProxy1_4::nextMotionSeq()
+{
+	// 0 means no motion
+	if (++m_motionSeq == 0) {
+		++m_motionSeq;
+	}
+	return m_motionSeq;
+}
+
+void
+CClientProxy1_4::sendMotionSync()
+{
+	if (!m_motionSync) {
+		return;
+	}
+	m_motionSync = false;
+
+	// input after this must land where the mouse is so send the last
+	// update again where it can't be lost
+	LOG((CLOG_DEBUG2 "send motion sync to \"%s\" at motion %u", getName().c_str(), m_motionSeq));
+	CProtocolUtil::writeMessage(getStream(),
+							CMsgDMotionSync(m_motionSeq, m_motionAbsSeq,
+									m_xMotion, m_yMotion,
+									m_dxMotion, m_dyMotion));
+}
+
+void
+CClientProxy1_4::handleFlush(const CEvent&, void*)
+{
+	m_flushPending = false;
+
+	// if the client's link is backed up then the scrolling and the
+	// batch go out through sendHeldMotion() when it catches up
+	if (!isOutputBackedUp()) {
+		sendMouseWheel();
+		sendMotionBatch();
+	}
+}
@@ -0,0 +1,219 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CCLIENTPROXY1_4_H
+#define CCLIENTPROXY1_4_H
+
+#include "CClientProxy1_3.h"
+#include "CNetworkAddress.h"
+#include "stdmap.h"
+
+class CMotionChannel;
+
+//! Proxy for client implementing protocol version 1.4
+class CClientProxy1_4 : public CClientProxy1_3 {
+public:
+	CClientProxy1_4(const CString& name, IStream* adoptedStream);
+	~CClientProxy1_4();
+
+	//! @name manipulators
+	//@{
+
+	//! Send motion over a side channel
+	/*!
+	Tells the client to open the motion side channel \c channel and
+	sends mouse motion over it once the client's hello arrives from
+	the host at \p peer, the address of the client's TCP connection.
+	Use only if the kCapMotionChannel capability is on.
+	*/
+	void				setMotionChannel(CMotionChannel* channel,
+							const CNetworkAddress& peer);
+
+	//! Start a resumable session
+	/*!
+	Sets the token a later connection from the client must present to
+	resume the session and \p peer, the address of the client.  Only a
+	connection from the same host can resume the session.  Use only if
+	the kCapResume capability is on.  The session can't be resumed
+	until \c setResumable() allows it.
+	*/
+	void				setSession(UInt32 token,
+							const CNetworkAddress& peer);
+
+	//! Allow or disallow resuming the session
+	/*!
+	A later connection can resume the session only while \p resumable
+	is true.  The server allows it only while it holds the client as
+	connected or suspended, so a connection can't take over a proxy
+	that's still handshaking or being closed.
+	*/
+	void				setResumable(bool resumable);
+
+	//! Resume the session
+	/*!
+	Uses \p adoptedStream, a new connection from the client that has
+	completed the greeting handshake, in place of the old one and
+	sends the resumed event.  If the old link isn't known to be down
+	yet then it's disconnected first.  The motion side channel is
+	dropped;  call \c setMotionChannel() to open it again.
+	*/
+	void				resume(IStream* adoptedStream);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Find a session
+	/*!
+	Returns the proxy whose session has token \p token and was started
+	from the host of \p peer or NULL if there isn't one.
+	*/
+	static CClientProxy1_4*	findSession(UInt32 token,
+							const CNetworkAddress& peer);
+
+	//! Create a session token
+	/*!
+	Returns a token for a new session.  It's never 0, 1 or \p other
+	and no other session has it.
+	*/
+	static UInt32		newSessionToken(UInt32 other);
+
+	//@}
+
+	// IClient overrides
+	virtual void		enter(SInt32 xAbs, SInt32 yAbs,
+							UInt32 seqNum, KeyModifierMask mask,
+							bool forScreensaver);
+	virtual void		keyDown(KeyID, KeyModifierMask, KeyButton);
+	virtual void		keyRepeat(KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+	virtual void		keyUp(KeyID, KeyModifierMask, KeyButton);
+	virtual void		mouseDown(ButtonID);
+	virtual void		mouseUp(ButtonID);
+	virtual void		mouseMove(SInt32 xAbs, SInt32 yAbs);
+	virtual void		mouseRelativeMove(SInt32 xRel, SInt32 yRel);
+	virtual void		mouseWheel(SInt32 xDelta, SInt32 yDelta);
+
+protected:
+	// CClientProxy1_0 overrides
+	virtual void		sendMouseMove(SInt32 xAbs, SInt32 yAbs);
+	virtual void		sendMouseRelativeMove(SInt32 xRel, SInt32 yRel);
+	virtual bool		readInfo(CClientInfo& info);
+	virtual void		sendHeldMotion();
+
+private:
+	// add relative motion to the batch in samples that fit 16 bits,
+	// sending or merging samples if the batch already has \p limit
+	// samples
+	void				addMotionSample(SInt32 xRel, SInt32 yRel,
+							UInt32 limit);
+
+	// send the batched relative motion, if any
+	void				sendMotionBatch();
+
+	// send the scrolling held by mouseWheel(), if any
+	void				sendMouseWheel();
+
+	// get the microseconds between batched sample \p i and the one
+	// before it, 0 for the first sample
+	UInt16				getSampleInterval(UInt32 i) const;
+
+	// true if the client takes compact input records
+	bool				isCompact() const;
+
+	// send a compact key record
+	void				sendCompactKey(UInt8 opcode, KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+
+	// true if the client should repeat \p key itself.  we leave
+	// modifier keys, which usually don't repeat, to the primary.
+	bool				isLocalRepeat(KeyID key) const;
+
+	// send a key press the client repeats itself
+	void				sendKeyDownRepeat(KeyID, KeyModifierMask, KeyButton);
+
+	// update the estimate of the primary's key repeat delay and
+	// interval from a repeat of \p button
+	void				timeKeyRepeat(KeyButton button, SInt32 count);
+
+	// send absolute or relative motion over the side channel.  returns
+	// false if the motion must go on the stream instead.
+	bool				sendChannelMotion(bool absolute, SInt32 x, SInt32 y);
+
+	// get the number for the next motion on the side channel
+	UInt32				nextMotionSeq();
+
+	// send a kMsgDMotionSync if motion went over the side channel since
+	// the last one
+	void				sendMotionSync();
+
+	void				handleFlush(const CEvent&, void*);
+
+private:
+	typedef std::map<UInt32, CClientProxy1_4*> CSessionMap;
+	class CMotionSample {
+	public:
+		SInt32			m_dx;
+		SInt32			m_dy;
+		double			m_time;
+	};
+	// largest compact input record:  an opcode and five varints
+	enum { kMaxCompactRecord = 1 + 5 * 5 };
+
+	CMotionSample		m_batch[kMaxMotionBatch];
+	UInt32				m_batchSize;
+	bool				m_flushPending;
+
+	// scrolling not yet sent and the number of wheel events in it
+	bool				m_wheelHeld;
+	SInt32				m_xWheel, m_yWheel;
+	UInt32				m_wheelCount;
+
+	// last absolute position sent, the base for compact motion
+	SInt32				m_xCompact, m_yCompact;
+
+	// the key last pressed, or 0 once released, whether the client
+	// repeats it, the number of repeats of it seen and the time of the
+	// press or the last repeat
+	KeyButton			m_repeatButton;
+	bool				m_repeatLocal;
+	UInt32				m_repeatCount;
+	double				m_repeatTime;
+
+	// estimated key repeat delay and interval on the primary or 0 if
+	// we haven't seen it yet
+	double				m_repeatDelay;
+	double				m_repeatInterval;
+
+	// the motion side channel or NULL, our token on it, the number of
+	// the last motion and of the last absolute motion, its position and
+	// the relative motion since.  m_motionSync is true if motion went
+	// over the channel since the last sync.
+	CMotionChannel*		m_motionChannel;
+	UInt32				m_motionToken;
+	UInt32				m_motionSeq;
+	UInt32				m_motionAbsSeq;
+	SInt32				m_xMotion, m_yMotion;
+	SInt32				m_dxMotion, m_dyMotion;
+	bool				m_motionSync;
+
+	// our session token or 0 if the session can't be resumed, the
+	// address of the client that started it and the sessions that may
+	// be resumed by token
+	UInt32				m_session;
+	CNetworkAddress		m_sessionPeer;
+	static CSessionMap	s_sessions;
+};
+
+#endif
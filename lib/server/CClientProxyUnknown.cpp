@@ -17,6 +17,7 @@
 #include "CClientProxy1_1.h"
 #include "CClientProxy1_2.h"
 #include "CClientProxy1_3.h"
+#include "CClientProxy1_4.h"
 #include "ProtocolTypes.h"
 #include "CProtocolUtil.h"
 #include "XSynergy.h"
@@ -34,8 +35,11 @@
 CEvent::Type			CClientProxyUnknown::s_successEvent = CEvent::kUnknown;
 CEvent::Type			CClientProxyUnknown::s_failureEvent = CEvent::kUnknown;
 
-CClientProxyUnknown::CClientProxyUnknown(IStream* stream, double timeout) :
+CClientProxyUnknown::CClientProxyUnknown(IStream* stream, double timeout,
+				CMotionChannel* motionChannel, const CNetworkAddress& peer) :
 	m_stream(stream),
+	m_motionChannel(motionChannel),
+	m_peer(peer),
 	m_proxy(NULL),
 	m_ready(false)
 {
@@ -201,12 +205,22 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 			throw XIncompatibleClient(major, minor);
 		}
 
+		// clients implementing 1.4 or later offer capabilities
+		CCapabilityList offered;
+		if (major > 1 || minor >= 4) {
+			if (!CProtocolUtil::readf(m_stream,
+									kMsgHelloCapabilities, &offered)) {
+				throw XBadClient();
+			}
+		}
+
 		// remove stream event handlers.  the proxy we're about to create
 		// may install its own handlers and we don't want to accidentally
 		// remove those later.
 		removeHandlers();
 
 		// create client proxy for highest version supported by the client
+		CCapabilityList capabilities;
 		if (major == 1) {
 			switch (minor) {
 			case 0:
@@ -224,6 +238,29 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 			case 3:
 				m_proxy = new CClientProxy1_3(name, m_stream);
 				break;
+
+			case 4: {
+				// resume the client's session if it presented the token
+				// of one from the same host, otherwise start a new one.
+				// the capabilities must precede the proxy's messages.
+				const UInt32 offeredSession = getOffered(offered, kCapResume);
+				CClientProxy1_4* resumable =
+							CClientProxy1_4::findSession(offeredSession, m_peer);
+				if (resumable != NULL && resumable->getName() == name) {
+					sendCapabilities(offered, capabilities, offeredSession);
+					resumable->resume(m_stream);
+					m_stream = NULL;
+					setupProxy(resumable, capabilities);
+
+					// the server already has the proxy
+					sendSuccess();
+					return;
+				}
+				sendCapabilities(offered, capabilities,
+							CClientProxy1_4::newSessionToken(offeredSession));
+				m_proxy = new CClientProxy1_4(name, m_stream);
+				break;
+			}
 			}
 		}
 
@@ -233,6 +270,12 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 		}
 
 		// the proxy is created and now proxy now owns the stream
+		setupProxy(m_proxy, capabilities);
+		const UInt32 session = m_proxy->getCapability(kCapResume);
+		if (session != 0) {
+			static_cast<CClientProxy1_4*>(m_proxy)->setSession(session,
+							m_peer);
+		}
 		LOG((CLOG_DEBUG1 "created proxy for client \"%s\" version %d.%d", name.c_str(), major, minor));
 		m_stream = NULL;
 
@@ -243,14 +286,14 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 	catch (XIncompatibleClient& e) {
 		// client is incompatible
 		LOG((CLOG_WARN "client \"%s\" has incompatible version %d.%d)", name.c_str(), e.getMajor(), e.getMinor()));
-		CProtocolUtil::writef(m_stream,
-							kMsgEIncompatible,
-							kProtocolMajorVersion, kProtocolMinorVersion);
+		CProtocolUtil::writeMessage(m_stream,
+							CMsgEIncompatible(kProtocolMajorVersion,
+											kProtocolMinorVersion));
 	}
 	catch (XBadClient&) {
 		// client not behaving
 		LOG((CLOG_WARN "protocol error from client \"%s\"", name.c_str()));
-		CProtocolUtil::writef(m_stream, kMsgEBad);
+		CProtocolUtil::writeMessage(m_stream, CMsgEBad());
 	}
 	catch (XBase& e) {
 		// misc error
@@ -259,6 +302,73 @@ CClientProxyUnknown::handleData(const CEvent&, void*)
 	sendFailure();
 }
 
+void
+CClientProxyUnknown::sendCapabilities(const CCapabilityList& offered,
+				CCapabilityList& capabilities, UInt32 session)
+{
+	// capabilities we support and our value for each.  we reply to
+	// kCapResume with the session token instead.
+	static const UInt32 s_supported[][2] = {
+		{ kCapMotionBatch, kMaxMotionBatch },
+		{ kCapCompactInput, 1 },
+		{ kCapKeyRepeat, 1 },
+		{ kCapMotionChannel, 1 },
+		{ kCapResume, 1 },
+		{ kCapNoAck, 1 }
+	};
+	static const UInt32 s_numSupported =
+							sizeof(s_supported) / sizeof(s_supported[0]);
+
+	// use each offered capability we support with the smaller value
+	capabilities.clear();
+	for (UInt32 i = 0; i + 1 < offered.size(); i += 2) {
+		const UInt32 id    = offered[i];
+		const UInt32 value = offered[i + 1];
+		for (UInt32 j = 0; j < s_numSupported; ++j) {
+			if (s_supported[j][0] == id && value != 0 &&
+				(id != kCapMotionChannel || m_motionChannel != NULL)) {
+				capabilities.push_back(id);
+				if (id == kCapResume) {
+					capabilities.push_back(session);
+				}
+				else {
+					capabilities.push_back(value < s_supported[j][1] ?
+											value : s_supported[j][1]);
+				}
+				LOG((CLOG_DEBUG1 "using capability %c%c%c%c=%d", (id >> 24) & 0xff, (id >> 16) & 0xff, (id >> 8) & 0xff, id & 0xff, capabilities.back()));
+				break;
+			}
+		}
+	}
+
+	CProtocolUtil::writef(m_stream, kMsgDCapabilities, &capabilities);
+}
+
+void
+CClientProxyUnknown::setupProxy(CClientProxy* proxy,
+				const CCapabilityList& capabilities)
+{
+	proxy->setCapabilities(capabilities);
+
+	// only 1.4 and later clients have capabilities
+	if (proxy->getCapability(kCapMotionChannel) != 0) {
+		static_cast<CClientProxy1_4*>(proxy)->
+							setMotionChannel(m_motionChannel, m_peer);
+	}
+}
+
+UInt32
+CClientProxyUnknown::getOffered(const CCapabilityList& offered,
+				CapabilityID id)
+{
+	for (UInt32 i = 0; i + 1 < offered.size(); i += 2) {
+		if (offered[i] == id) {
+			return offered[i + 1];
+		}
+	}
+	return 0;
+}
+
 void
 CClientProxyUnknown::handleWriteError(const CEvent&, void*)
 {
@@ -16,14 +16,25 @@
 #define CCLIENTPROXYUNKNOWN_H
 
 #include "CEvent.h"
+#include "CNetworkAddress.h"
+#include "ProtocolTypes.h"
 
 class CClientProxy;
 class CEventQueueTimer;
+class CMotionChannel;
 class IStream;
 
 class CClientProxyUnknown {
 public:
-	CClientProxyUnknown(IStream* stream, double timeout);
+	/*!
+	Clients that can take mouse motion over a side channel get it over
+	\c motionChannel, if not NULL.  \p peer is the address the client's
+	connection comes from;  the channel only accepts the client's hello
+	from that host.
+	*/
+	CClientProxyUnknown(IStream* stream, double timeout,
+							CMotionChannel* motionChannel = NULL,
+							const CNetworkAddress& peer = CNetworkAddress());
 	~CClientProxyUnknown();
 
 	//! @name manipulators
@@ -33,7 +44,8 @@ public:
 	/*!
 	Returns the client proxy created after a successful handshake
 	(i.e. when this object sends a success event).  Returns NULL
-	if the handshake is unsuccessful or incomplete.
+	if the handshake is unsuccessful or incomplete or if the client
+	resumed a session, whose proxy the server already has.
 	*/
 	CClientProxy*		orphanClientProxy();
 
@@ -64,6 +76,13 @@ private:
 	void				addProxyHandlers();
 	void				removeHandlers();
 	void				removeTimer();
+	void				sendCapabilities(const CCapabilityList& offered,
+							CCapabilityList& capabilities,
+							UInt32 session);
+	void				setupProxy(CClientProxy* proxy,
+							const CCapabilityList& capabilities);
+	static UInt32		getOffered(const CCapabilityList& offered,
+							CapabilityID id);
 	void				handleData(const CEvent&, void*);
 	void				handleWriteError(const CEvent&, void*);
 	void				handleTimeout(const CEvent&, void*);
@@ -73,6 +92,8 @@ private:
 private:
 	IStream*			m_stream;
 	CEventQueueTimer*	m_timer;
+	CMotionChannel*		m_motionChannel;
+	CNetworkAddress		m_peer;
 	CClientProxy*		m_proxy;
 	bool				m_ready;
 
@@ -16,6 +16,7 @@
 #include "CServer.h"
 #include "CPrimaryClient.h"
 #include "CKeyMap.h"
+#include "CEventDataPool.h"
 #include "CEventQueue.h"
 #include "CLog.h"
 #include "TMethodEventJob.h"
@@ -53,7 +54,7 @@ CInputFilter::CKeystrokeCondition::CKeystrokeCondition(
 	m_key(info->m_key),
 	m_mask(info->m_mask)
 {
-	free(info);
+	CEventDataPool::release(info);
 }
 
 CInputFilter::CKeystrokeCondition::CKeystrokeCondition(
@@ -140,7 +141,7 @@ CInputFilter::CMouseButtonCondition::CMouseButtonCondition(
 	m_button(info->m_button),
 	m_mask(info->m_mask)
 {
-	free(info);
+	CEventDataPool::release(info);
 }
 
 CInputFilter::CMouseButtonCondition::CMouseButtonCondition(
@@ -477,13 +478,13 @@ CInputFilter::CKeystrokeAction::CKeystrokeAction(
 
 CInputFilter::CKeystrokeAction::~CKeystrokeAction()
 {
-	free(m_keyInfo);
+	CEventDataPool::release(m_keyInfo);
 }
 
 void
 CInputFilter::CKeystrokeAction::adoptInfo(IPlatformScreen::CKeyInfo* info)
 {
-	free(m_keyInfo);
+	CEventDataPool::release(m_keyInfo);
 	m_keyInfo = info;
 }
 
@@ -562,7 +563,7 @@ CInputFilter::CMouseButtonAction::CMouseButtonAction(
 
 CInputFilter::CMouseButtonAction::~CMouseButtonAction()
 {
-	free(m_buttonInfo);
+	CEventDataPool::release(m_buttonInfo);
 }
 
 const IPlatformScreen::CButtonInfo*
@@ -0,0 +1,130 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "CMotionChannel.h"
+#include "CProtocolUtil.h"
+#include "ProtocolTypes.h"
+#include "IDatagramSocket.h"
+#include "CLog.h"
+#include "IEventQueue.h"
+#include "TMethodEventJob.h"
+#include "CArch.h"
+
+//
+// CMotionChannel
+//
+
+CMotionChannel::CMotionChannel(IDatagramSocket* socket) :
+	m_socket(socket),
+	m_refCount(1)
+{
+	assert(m_socket != NULL);
+
+	EVENTQUEUE->adoptHandler(IDatagramSocket::getInputReadyEvent(),
+							m_socket->getEventTarget(),
+							new TMethodEventJob<CMotionChannel>(this,
+								&CMotionChannel::handleInputReady));
+}
+
+CMotionChannel::~CMotionChannel()
+{
+	EVENTQUEUE->removeHandler(IDatagramSocket::getInputReadyEvent(),
+							m_socket->getEventTarget());
+	delete m_socket;
+}
+
+void
+CMotionChannel::ref()
+{
+	++m_refCount;
+}
+
+void
+CMotionChannel::unref()
+{
+	if (--m_refCount == 0) {
+		delete this;
+	}
+}
+
+UInt32
+CMotionChannel::addClient(const CNetworkAddress& peer)
+{
+	// tokens are unique and never 0.  each is drawn independently so
+	// a client can't work out another client's token from its own.
+	UInt32 token;
+	do {
+		ARCH->getRandom(&token, sizeof(token));
+	} while (token == 0 || m_clients.count(token) != 0);
+	CClientInfo& info = m_clients[token];
+	info.m_peer       = peer;
+	return token;
+}
+
+void
+CMotionChannel::removeClient(UInt32 token)
+{
+	m_clients.erase(token);
+}
+
+bool
+CMotionChannel::send(UInt32 token, const void* data, UInt32 n)
+{
+	CClientMap::const_iterator i = m_clients.find(token);
+	if (i == m_clients.end() || !i->second.m_address.isValid()) {
+		return false;
+	}
+	return m_socket->send(data, n, i->second.m_address);
+}
+
+bool
+CMotionChannel::isOpen(UInt32 token) const
+{
+	CClientMap::const_iterator i = m_clients.find(token);
+	return (i != m_clients.end() && i->second.m_address.isValid());
+}
+
+void
+CMotionChannel::handleInputReady(const CEvent&, void*)
+{
+	// a hello tells us where to send a client's motion.  the port can
+	// change if the client's NAT mapping does but the host must be the
+	// one the client's TCP connection comes from.
+	UInt8 buffer[CMsgMotionHello::kSize];
+	CNetworkAddress from;
+	UInt32 n;
+	while ((n = m_socket->receive(buffer, sizeof(buffer), &from)) != 0) {
+		CMsgMotionHello msg;
+		if (n != CMsgMotionHello::kSize ||
+			CProtocolUtil::getCode(buffer) != kCodeMotionHello ||
+			!CProtocolUtil::decode(buffer + 4, n - 4, msg)) {
+			LOG((CLOG_DEBUG1 "bad motion channel datagram from %s", from.getHostname().c_str()));
+			continue;
+		}
+		CClientMap::iterator i = m_clients.find(msg.m_token);
+		if (i == m_clients.end()) {
+			LOG((CLOG_DEBUG1 "motion channel hello from %s with unknown token", from.getHostname().c_str()));
+			continue;
+		}
+		CClientInfo& info = i->second;
+		if (!from.isSameHost(info.m_peer)) {
+			LOG((CLOG_DEBUG1 "motion channel hello from %s doesn't match client at %s", from.getHostname().c_str(), info.m_peer.getHostname().c_str()));
+			continue;
+		}
+		if (!info.m_address.isValid() || info.m_address != from) {
+			LOG((CLOG_DEBUG "motion channel to %s:%d open", from.getHostname().c_str(), from.getPort()));
+			info.m_address = from;
+		}
+	}
+}
@@ -0,0 +1,115 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2006 Chris Schoeneman
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file COPYING that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef CMOTIONCHANNEL_H
+#define CMOTIONCHANNEL_H
+
+#include "CEvent.h"
+#include "CNetworkAddress.h"
+#include "stdmap.h"
+
+class IDatagramSocket;
+
+//! Mouse motion side channel
+/*!
+This class sends mouse motion to clients in datagrams over a socket
+shared by all clients.  Each client is identified by a token it sends
+back in hello datagrams so we learn where to send its motion.  Tokens
+are random and a hello is only accepted from the host the client's
+TCP connection comes from, so one client can't steer another client's
+motion elsewhere.  See kCapMotionChannel in ProtocolTypes.h.
+
+The channel is shared by the client listener and the client proxies,
+any of which may go first, so it's reference counted.
+*/
+class CMotionChannel {
+public:
+	//! Create channel on bound socket
+	/*!
+	The socket is adopted.  The reference count starts at 1.
+	*/
+	CMotionChannel(IDatagramSocket* adoptedSocket);
+
+	//! @name manipulators
+	//@{
+
+	//! Add a reference
+	void				ref();
+
+	//! Release a reference
+	/*!
+	Releases a reference, deleting the channel if it was the last.
+	*/
+	void				unref();
+
+	//! Add a client
+	/*!
+	Returns a new token for a client whose TCP connection comes from
+	\p peer.  Motion can't be sent to the client until a hello datagram
+	arrives with the token from the same host as \p peer.
+	*/
+	UInt32				addClient(const CNetworkAddress& peer);
+
+	//! Remove a client
+	/*!
+	Forgets the client with token \c token.
+	*/
+	void				removeClient(UInt32 token);
+
+	//! Send datagram to client
+	/*!
+	Sends \c n bytes of \c data as a datagram to the client with token
+	\c token.  Returns false, without sending, if no hello datagram
+	has arrived from the client yet, or if the datagram couldn't be
+	sent.
+	*/
+	bool				send(UInt32 token, const void* data, UInt32 n);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if client can take datagrams
+	/*!
+	Returns true once a hello datagram has arrived from the client with
+	token \c token.
+	*/
+	bool				isOpen(UInt32 token) const;
+
+	//@}
+
+private:
+	~CMotionChannel();
+
+	void				handleInputReady(const CEvent&, void*);
+
+private:
+	class CClientInfo {
+	public:
+		// the client's TCP peer address
+		CNetworkAddress	m_peer;
+
+		// where to send motion.  invalid until the client's first hello.
+		CNetworkAddress	m_address;
+	};
+	typedef std::map<UInt32, CClientInfo> CClientMap;
+
+	IDatagramSocket*	m_socket;
+	int					m_refCount;
+
+	// clients by token
+	CClientMap			m_clients;
+};
+
+#endif
@@ -14,6 +14,7 @@
 
 #include "CServer.h"
 #include "CClientProxy.h"
+#include "CClientProxy1_4.h"
 #include "CClientProxyUnknown.h"
 #include "CPrimaryClient.h"
 #include "IPlatformScreen.h"
@@ -115,6 +116,10 @@ CServer::CServer(const CConfig& config, CPrimaryClient* primaryClient) :
 							m_primaryClient->getEventTarget(),
 							new TMethodEventJob<CServer>(this,
 								&CServer::handleMotionSecondaryEvent));
+	EVENTQUEUE->setCoalescer(IPlatformScreen::getMotionOnPrimaryEvent(),
+							&CServer::coalesceMotionPrimary, this);
+	EVENTQUEUE->setCoalescer(IPlatformScreen::getMotionOnSecondaryEvent(),
+							&CServer::coalesceMotionSecondary, NULL);
 	EVENTQUEUE->adoptHandler(IPlatformScreen::getWheelEvent(),
 							m_primaryClient->getEventTarget(),
 							new TMethodEventJob<CServer>(this,
@@ -180,6 +185,10 @@ CServer::~CServer()
 							m_primaryClient->getEventTarget());
 	EVENTQUEUE->removeHandler(IPlatformScreen::getMotionOnSecondaryEvent(),
 							m_primaryClient->getEventTarget());
+	EVENTQUEUE->setCoalescer(IPlatformScreen::getMotionOnPrimaryEvent(),
+							NULL, NULL);
+	EVENTQUEUE->setCoalescer(IPlatformScreen::getMotionOnSecondaryEvent(),
+							NULL, NULL);
 	EVENTQUEUE->removeHandler(IPlatformScreen::getWheelEvent(),
 							m_primaryClient->getEventTarget());
 	EVENTQUEUE->removeHandler(IPlatformScreen::getScreensaverActivatedEvent(),
@@ -282,6 +291,9 @@ CServer::adoptClient(CBaseClientProxy* client)
 	}
 	LOG((CLOG_NOTE "client \"%s\" has connected", getName(client).c_str()));
 
+	// the client's session may be resumed now that we hold the client
+	setResumable(client, true);
+
 	// send configuration options to client
 	sendOptions(client);
 
@@ -300,6 +312,13 @@ CServer::adoptClient(CBaseClientProxy* client)
 void
 CServer::disconnect()
 {
+	// drop clients held for resumption.  they're already disconnected.
+	while (!m_suspendedClients.empty()) {
+		CBaseClientProxy* client = m_suspendedClients.begin()->first;
+		removeSuspendedClient(client);
+		delete client;
+	}
+
 	// close all secondary clients
 	if (m_clients.size() > 1 || !m_oldClients.empty()) {
 		CConfig emptyConfig;
@@ -442,6 +461,21 @@ CServer::getJumpZoneSize(CBaseClientProxy* client) const
 	}
 }
 
+bool
+CServer::isInJumpZone(SInt32 x, SInt32 y) const
+{
+	// primary motion is stale while on a secondary screen
+	if (m_active != m_primaryClient) {
+		return false;
+	}
+
+	SInt32 ax, ay, aw, ah;
+	m_primaryClient->getShape(ax, ay, aw, ah);
+	SInt32 zoneSize = getJumpZoneSize(m_primaryClient);
+	return (x < ax + zoneSize || x >= ax + aw - zoneSize ||
+			y < ay + zoneSize || y >= ay + ah - zoneSize);
+}
+
 void
 CServer::switchScreen(CBaseClientProxy* dst,
 				SInt32 x, SInt32 y, bool forScreensaver)
@@ -1289,6 +1323,38 @@ CServer::handleMotionSecondaryEvent(const CEvent& event, void*)
 	onMouseMoveSecondary(info->m_x, info->m_y);
 }
 
+bool
+CServer::coalesceMotionPrimary(CEvent& event, const CEvent& next,
+				void* vserver)
+{
+	IPlatformScreen::CMotionInfo* info =
+		reinterpret_cast<IPlatformScreen::CMotionInfo*>(event.getData());
+	const IPlatformScreen::CMotionInfo* nextInfo =
+		reinterpret_cast<IPlatformScreen::CMotionInfo*>(next.getData());
+
+	// a position in the jump zone may switch screens so it must be
+	// handled on its own
+	const CServer* server = reinterpret_cast<const CServer*>(vserver);
+	if (server->isInJumpZone(info->m_x, info->m_y)) {
+		return false;
+	}
+	info->m_x = nextInfo->m_x;
+	info->m_y = nextInfo->m_y;
+	return true;
+}
+
+bool
+CServer::coalesceMotionSecondary(CEvent& event, const CEvent& next, void*)
+{
+	IPlatformScreen::CMotionInfo* info =
+		reinterpret_cast<IPlatformScreen::CMotionInfo*>(event.getData());
+	const IPlatformScreen::CMotionInfo* nextInfo =
+		reinterpret_cast<IPlatformScreen::CMotionInfo*>(next.getData());
+	info->m_x += nextInfo->m_x;
+	info->m_y += nextInfo->m_y;
+	return true;
+}
+
 void
 CServer::handleWheelEvent(const CEvent& event, void*)
 {
@@ -1327,8 +1393,16 @@ void
 CServer::handleClientDisconnected(const CEvent&, void* vclient)
 {
 	// client has disconnected.  it might be an old client or an
-	// active client.  we don't care so just handle it both ways.
+	// active client.  we don't care so just handle it both ways,
+	// except that we hold onto an active client that can resume its
+	// session.
 	CBaseClientProxy* client = reinterpret_cast<CBaseClientProxy*>(vclient);
+	// FIXME -- avoid type cast (kinda hard, though)
+	if (m_clientSet.count(client) != 0 &&
+		((CClientProxy*)client)->getCapability(kCapResume) != 0) {
+		suspendClient(client);
+		return;
+	}
 	removeActiveClient(client);
 	removeOldClient(client);
 	delete client;
@@ -1344,6 +1418,34 @@ CServer::handleClientCloseTimeout(const CEvent&, void* vclient)
 	delete client;
 }
 
+void
+CServer::handleClientResumed(const CEvent&, void* vclient)
+{
+	CBaseClientProxy* client = reinterpret_cast<CBaseClientProxy*>(vclient);
+	removeSuspendedClient(client);
+	adoptClient(client);
+
+	// the client may have missed clipboard grabs while it was away.
+	// it keeps the clipboards it still owns.
+	if (m_clientSet.count(client) != 0) {
+		for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+			if (m_clipboards[id].m_clipboardOwner != getName(client)) {
+				client->grabClipboard(id);
+			}
+		}
+	}
+}
+
+void
+CServer::handleSuspendedClientTimeout(const CEvent&, void* vclient)
+{
+	// client didn't come back in time
+	CBaseClientProxy* client = reinterpret_cast<CBaseClientProxy*>(vclient);
+	LOG((CLOG_NOTE "client \"%s\" did not resume its session", getName(client).c_str()));
+	removeSuspendedClient(client);
+	delete client;
+}
+
 void
 CServer::handleSwitchToScreenEvent(const CEvent& event, void*)
 {
@@ -1965,6 +2067,9 @@ CServer::closeClient(CBaseClientProxy* client, const char* msg)
 	// client.
 	LOG((CLOG_NOTE "disconnecting client \"%s\"", getName(client).c_str()));
 
+	// a closing client can't be resumed
+	setResumable(client, false);
+
 	// send message
 	// FIXME -- avoid type cast (kinda hard, though)
 	((CClientProxy*)client)->close(msg);
@@ -2037,6 +2142,52 @@ CServer::removeOldClient(CBaseClientProxy* client)
 	}
 }
 
+void
+CServer::removeSuspendedClient(CBaseClientProxy* client)
+{
+	COldClients::iterator i = m_suspendedClients.find(client);
+	if (i != m_suspendedClients.end()) {
+		EVENTQUEUE->removeHandler(CClientProxy::getResumedEvent(),
+							client->getEventTarget());
+		EVENTQUEUE->removeHandler(CEvent::kTimer, i->second);
+		EVENTQUEUE->deleteTimer(i->second);
+		m_suspendedClients.erase(i);
+	}
+}
+
+void
+CServer::suspendClient(CBaseClientProxy* client)
+{
+	LOG((CLOG_NOTE "holding screen \"%s\" %.0f seconds for the client to resume", getName(client).c_str(), kSessionResumeTime));
+
+	// the screen is unusable until the client resumes
+	removeActiveClient(client);
+
+	// wait for the client to resume its session.  the client is
+	// deleted if it doesn't in time.
+	CEventQueueTimer* timer =
+		EVENTQUEUE->newOneShotTimer(kSessionResumeTime, NULL);
+	EVENTQUEUE->adoptHandler(CEvent::kTimer, timer,
+							new TMethodEventJob<CServer>(this,
+								&CServer::handleSuspendedClientTimeout,
+								client));
+	EVENTQUEUE->adoptHandler(CClientProxy::getResumedEvent(),
+							client->getEventTarget(),
+							new TMethodEventJob<CServer>(this,
+								&CServer::handleClientResumed, client));
+	m_suspendedClients.insert(std::make_pair(client, timer));
+}
+
+void
+CServer::setResumable(CBaseClientProxy* client, bool resumable)
+{
+	// only 1.4 and later clients offer kCapResume
+	// FIXME -- avoid type cast (kinda hard, though)
+	if (((CClientProxy*)client)->getCapability(kCapResume) != 0) {
+		static_cast<CClientProxy1_4*>(client)->setResumable(resumable);
+	}
+}
+
 void
 CServer::forceLeaveClient(CBaseClientProxy* client)
 {
@@ -217,6 +217,10 @@ private:
 	// returns the jump zone of the client
 	SInt32				getJumpZoneSize(CBaseClientProxy*) const;
 
+	// returns true iff the position on the primary screen is in its
+	// jump zone, where motion may switch screens
+	bool				isInJumpZone(SInt32 x, SInt32 y) const;
+
 	// change the active screen
 	void				switchScreen(CBaseClientProxy*,
 							SInt32 x, SInt32 y, bool forScreenSaver);
@@ -324,6 +328,8 @@ private:
 	void				handleSwitchWaitTimeout(const CEvent&, void*);
 	void				handleClientDisconnected(const CEvent&, void*);
 	void				handleClientCloseTimeout(const CEvent&, void*);
+	void				handleClientResumed(const CEvent&, void*);
+	void				handleSuspendedClientTimeout(const CEvent&, void*);
 	void				handleSwitchToScreenEvent(const CEvent&, void*);
 	void				handleSwitchInDirectionEvent(const CEvent&, void*);
 	void				handleKeyboardBroadcastEvent(const CEvent&,void*);
@@ -331,6 +337,15 @@ private:
 	void				handleFakeInputBeginEvent(const CEvent&, void*);
 	void				handleFakeInputEndEvent(const CEvent&, void*);
 
+	// event coalescers.  the primary screen's motion events carry
+	// positions so the latest wins, except that a position in the jump
+	// zone isn't skipped.  secondary motion is relative so the deltas
+	// add up.
+	static bool			coalesceMotionPrimary(CEvent&, const CEvent&,
+							void*);
+	static bool			coalesceMotionSecondary(CEvent&, const CEvent&,
+							void*);
+
 	// event processing
 	void				onClipboardChanged(CBaseClientProxy* sender,
 							ClipboardID id, UInt32 seqNum);
@@ -365,6 +380,14 @@ private:
 	// remove clients from internal state
 	void				removeActiveClient(CBaseClientProxy*);
 	void				removeOldClient(CBaseClientProxy*);
+	void				removeSuspendedClient(CBaseClientProxy*);
+
+	// hold a disconnected client for it to resume its session
+	void				suspendClient(CBaseClientProxy*);
+
+	// allow or disallow a later connection to resume \p client's
+	// session, if it has one
+	void				setResumable(CBaseClientProxy*, bool resumable);
 
 	// force the cursor off of \p client
 	void				forceLeaveClient(CBaseClientProxy* client);
@@ -394,6 +417,9 @@ private:
 	typedef std::map<CBaseClientProxy*, CEventQueueTimer*> COldClients;
 	COldClients			m_oldClients;
 
+	// disconnected clients held for resumption until their timer fires
+	COldClients			m_suspendedClients;
+
 	// the client with focus
 	CBaseClientProxy*	m_active;
 
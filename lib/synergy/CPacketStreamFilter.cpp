@@ -16,28 +16,35 @@
 #include "IEventQueue.h"
 #include "CLock.h"
 #include "TMethodEventJob.h"
+#include <cstring>
 
 //
 // CPacketStreamFilter
 //
 
+const UInt32			CPacketStreamFilter::kMaxPacketCopy = 16384;
+
 CPacketStreamFilter::CPacketStreamFilter(IStream* stream, bool adoptStream) :
 	CStreamFilter(stream, adoptStream),
 	m_size(0),
-	m_inputShutdown(false)
+	m_inputShutdown(false),
+	m_flushPending(false)
 {
-	// do nothing
+	EVENTQUEUE->adoptHandler(CEvent::kFlush, this,
+							new TMethodEventJob<CPacketStreamFilter>(this,
+								&CPacketStreamFilter::handleFlush));
 }
 
 CPacketStreamFilter::~CPacketStreamFilter()
 {
-	// do nothing
+	EVENTQUEUE->removeHandler(CEvent::kFlush, this);
 }
 
 void
 CPacketStreamFilter::close()
 {
 	CLock lock(&m_mutex);
+	writePackets();
 	m_size = 0;
 	m_buffer.pop(m_buffer.getSize());
 	CStreamFilter::close();
@@ -64,36 +71,92 @@ CPacketStreamFilter::read(void* buffer, UInt32 n)
 
 	// read it
 	if (buffer != NULL) {
-		memcpy(buffer, m_buffer.peek(n), n);
+		m_buffer.read(buffer, n);
 	}
-	m_buffer.pop(n);
-	m_size -= n;
+	else {
+		m_buffer.pop(n);
+	}
+	packetRead(n);
+	return n;
+}
 
-	// get next packet's size if we've finished with this packet and
-	// there's enough data to do so.
-	readPacketSize();
+UInt32
+CPacketStreamFilter::readInto(CStreamBuffer& buffer)
+{
+	CLock lock(&m_mutex);
 
-	if (m_inputShutdown && m_size == 0) {
-		EVENTQUEUE->addEvent(CEvent(getInputShutdownEvent(),
-						getEventTarget(), NULL));
+	// if not enough data yet then give up
+	if (!isReadyNoLock()) {
+		return 0;
 	}
 
+	// move the rest of the buffered packet
+	UInt32 n = m_size;
+	buffer.splice(m_buffer, n);
+	packetRead(n);
 	return n;
 }
 
+const void*
+CPacketStreamFilter::peek(UInt32 n)
+{
+	CLock lock(&m_mutex);
+
+	// only the rest of the buffered packet can be seen
+	assert(n <= (isReadyNoLock() ? m_size : 0));
+	return m_buffer.peek(n);
+}
+
 void
 CPacketStreamFilter::write(const void* buffer, UInt32 count)
 {
-	// write the length of the payload
+	// the length of the payload
 	UInt8 length[4];
 	length[0] = (UInt8)((count >> 24) & 0xff);
 	length[1] = (UInt8)((count >> 16) & 0xff);
 	length[2] = (UInt8)((count >>  8) & 0xff);
 	length[3] = (UInt8)( count        & 0xff);
-	getStream()->write(length, sizeof(length));
 
-	// write the payload
-	getStream()->write(buffer, count);
+	CLock lock(&m_mutex);
+
+	// large payloads aren't worth copying (or keeping a buffer that
+	// big around for) so write the length and payload separately
+	// after any packets we're holding.
+	if (count > kMaxPacketCopy) {
+		writePackets();
+		getStream()->write(length, sizeof(length));
+		getStream()->write(buffer, count);
+		return;
+	}
+
+	// append the packet to the ones we're holding.  the buffer is
+	// reused so this doesn't normally allocate.
+	UInt32 offset = (UInt32)m_packets.size();
+	m_packets.resize(offset + sizeof(length) + count);
+	memcpy(&m_packets[offset], length, sizeof(length));
+	memcpy(&m_packets[offset + sizeof(length)], buffer, count);
+
+	// hold the packets until the event being dispatched has been
+	// handled, unless there's no such event or we're holding plenty
+	if (m_packets.size() >= kMaxPacketCopy) {
+		writePackets();
+	}
+	else if (!m_flushPending) {
+		m_flushPending = EVENTQUEUE->addFlush(this);
+		if (!m_flushPending) {
+			writePackets();
+		}
+	}
+}
+
+void
+CPacketStreamFilter::flush()
+{
+	{
+		CLock lock(&m_mutex);
+		writePackets();
+	}
+	CStreamFilter::flush();
 }
 
 void
@@ -105,6 +168,14 @@ CPacketStreamFilter::shutdownInput()
 	CStreamFilter::shutdownInput();
 }
 
+void
+CPacketStreamFilter::shutdownOutput()
+{
+	CLock lock(&m_mutex);
+	writePackets();
+	CStreamFilter::shutdownOutput();
+}
+
 bool
 CPacketStreamFilter::isReady() const
 {
@@ -132,8 +203,7 @@ CPacketStreamFilter::readPacketSize()
 
 	if (m_size == 0 && m_buffer.getSize() >= 4) {
 		UInt8 buffer[4];
-		memcpy(buffer, m_buffer.peek(sizeof(buffer)), sizeof(buffer));
-		m_buffer.pop(sizeof(buffer));
+		m_buffer.read(buffer, sizeof(buffer));
 		m_size = ((UInt32)buffer[0] << 24) |
 				 ((UInt32)buffer[1] << 16) |
 				 ((UInt32)buffer[2] <<  8) |
@@ -141,19 +211,32 @@ CPacketStreamFilter::readPacketSize()
 	}
 }
 
+void
+CPacketStreamFilter::packetRead(UInt32 n)
+{
+	// note -- m_mutex must be locked on entry
+
+	m_size -= n;
+
+	// get next packet's size if we've finished with this packet and
+	// there's enough data to do so.
+	readPacketSize();
+
+	if (m_inputShutdown && m_size == 0) {
+		EVENTQUEUE->addEvent(CEvent(getInputShutdownEvent(),
+						getEventTarget(), NULL));
+	}
+}
+
 bool
 CPacketStreamFilter::readMore()
 {
 	// note if we have whole packet
 	bool wasReady = isReadyNoLock();
 
-	// read more data
-	char buffer[4096];
-	UInt32 n = getStream()->read(buffer, sizeof(buffer));
-	while (n > 0) {
-		m_buffer.write(buffer, n);
-		n = getStream()->read(buffer, sizeof(buffer));
-	}
+	// take whatever the stream has buffered.  a socket hands over the
+	// memory it read into so nothing is copied.
+	getStream()->readInto(m_buffer);
 
 	// if we don't yet have the next packet size then get it,
 	// if possible.
@@ -167,6 +250,25 @@ CPacketStreamFilter::readMore()
 	return (wasReady != isReady);
 }
 
+void
+CPacketStreamFilter::writePackets()
+{
+	// note -- m_mutex must be locked on entry
+
+	if (!m_packets.empty()) {
+		getStream()->write(&m_packets[0], (UInt32)m_packets.size());
+		m_packets.clear();
+	}
+}
+
+void
+CPacketStreamFilter::handleFlush(const CEvent&, void*)
+{
+	CLock lock(&m_mutex);
+	m_flushPending = false;
+	writePackets();
+}
+
 void
 CPacketStreamFilter::filterEvent(const CEvent& event)
 {
@@ -18,10 +18,15 @@
 #include "CStreamFilter.h"
 #include "CStreamBuffer.h"
 #include "CMutex.h"
+#include "stdvector.h"
 
 //! Packetizing stream filter 
 /*!
-Filters a stream to read and write packets.
+Filters a stream to read and write packets.  Packets written while an
+event is being dispatched are held until the dispatch is done and then
+written to the stream together.  Once a whole packet has arrived
+\c peek() returns a view of the rest of it, so parsers can decode it
+where the socket read it.
 */
 class CPacketStreamFilter : public CStreamFilter {
 public:
@@ -31,8 +36,12 @@ public:
 	// IStream overrides
 	virtual void		close();
 	virtual UInt32		read(void* buffer, UInt32 n);
+	virtual UInt32		readInto(CStreamBuffer& buffer);
+	virtual const void*	peek(UInt32 n);
 	virtual void		write(const void* buffer, UInt32 n);
+	virtual void		flush();
 	virtual void		shutdownInput();
+	virtual void		shutdownOutput();
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
 
@@ -43,13 +52,20 @@ protected:
 private:
 	bool				isReadyNoLock() const;
 	void				readPacketSize();
+	void				packetRead(UInt32 n);
 	bool				readMore();
+	void				writePackets();
+	void				handleFlush(const CEvent&, void*);
 
 private:
+	static const UInt32	kMaxPacketCopy;
+
 	CMutex				m_mutex;
 	UInt32				m_size;
 	CStreamBuffer		m_buffer;
 	bool				m_inputShutdown;
+	std::vector<UInt8>	m_packets;
+	bool				m_flushPending;
 };
 
 #endif
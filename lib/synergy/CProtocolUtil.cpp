@@ -50,7 +50,8 @@ CProtocolUtil::readf(IStream* stream, const char* fmt, ...)
 	va_list args;
 	va_start(args, fmt);
 	try {
-		vreadf(stream, fmt, args);
+		CReader reader(stream);
+		vreadf(reader, fmt, args);
 		result = true;
 	}
 	catch (XIO&) {
@@ -72,27 +73,36 @@ CProtocolUtil::vwritef(IStream* stream,
 		return;
 	}
 
+	// use a fixed size buffer if its big enough
+	UInt8 fixed[256];
+	const bool useFixed = (size <= sizeof(fixed));
+
 	// fill buffer
-	UInt8* buffer = new UInt8[size];
+	UInt8* buffer = fixed;
+	if (!useFixed) {
+		buffer = new UInt8[size];
+	}
 	writef(buffer, fmt, args);
 
 	try {
 		// write buffer
 		stream->write(buffer, size);
 		LOG((CLOG_DEBUG2 "wrote %d bytes", size));
-
-		delete[] buffer;
 	}
 	catch (XBase&) {
-		delete[] buffer;
+		if (!useFixed) {
+			delete[] buffer;
+		}
 		throw;
 	}
+	if (!useFixed) {
+		delete[] buffer;
+	}
 }
 
 void
-CProtocolUtil::vreadf(IStream* stream, const char* fmt, va_list args)
+CProtocolUtil::vreadf(CReader& reader, const char* fmt, va_list args)
 {
-	assert(stream != NULL);
 	assert(fmt != NULL);
 
 	// begin scanning
@@ -107,8 +117,7 @@ CProtocolUtil::vreadf(IStream* stream, const char* fmt, va_list args)
 				assert(len == 1 || len == 2 || len == 4);
 
 				// read the data
-				UInt8 buffer[4];
-				read(stream, buffer, len);
+				const UInt8* buffer = reader.read(len);
 
 				// convert it
 				void* v = va_arg(args, void*);
@@ -146,8 +155,7 @@ CProtocolUtil::vreadf(IStream* stream, const char* fmt, va_list args)
 				assert(len == 1 || len == 2 || len == 4);
 
 				// read the vector length
-				UInt8 buffer[4];
-				read(stream, buffer, 4);
+				const UInt8* buffer = reader.read(4);
 				UInt32 n = (static_cast<UInt32>(buffer[0]) << 24) |
 						   (static_cast<UInt32>(buffer[1]) << 16) |
 						   (static_cast<UInt32>(buffer[2]) <<  8) |
@@ -157,40 +165,24 @@ CProtocolUtil::vreadf(IStream* stream, const char* fmt, va_list args)
 				void* v = va_arg(args, void*);
 				switch (len) {
 				case 1:
-					// 1 byte integer
-					for (UInt32 i = 0; i < n; ++i) {
-						read(stream, buffer, 1);
-						reinterpret_cast<std::vector<UInt8>*>(v)->push_back(
-							buffer[0]);
-						LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, reinterpret_cast<std::vector<UInt8>*>(v)->back(), reinterpret_cast<std::vector<UInt8>*>(v)->back()));
-					}
+					// 1 byte integers
+					readVector(reader,
+							reinterpret_cast<std::vector<UInt8>*>(v), n);
 					break;
 
 				case 2:
-					// 2 byte integer
-					for (UInt32 i = 0; i < n; ++i) {
-						read(stream, buffer, 2);
-						reinterpret_cast<std::vector<UInt16>*>(v)->push_back(
-							static_cast<UInt16>(
-							(static_cast<UInt16>(buffer[0]) << 8) |
-							 static_cast<UInt16>(buffer[1])));
-						LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, reinterpret_cast<std::vector<UInt16>*>(v)->back(), reinterpret_cast<std::vector<UInt16>*>(v)->back()));
-					}
+					// 2 byte integers
+					readVector(reader,
+							reinterpret_cast<std::vector<UInt16>*>(v), n);
 					break;
 
 				case 4:
-					// 4 byte integer
-					for (UInt32 i = 0; i < n; ++i) {
-						read(stream, buffer, 4);
-						reinterpret_cast<std::vector<UInt32>*>(v)->push_back(
-							(static_cast<UInt32>(buffer[0]) << 24) |
-							(static_cast<UInt32>(buffer[1]) << 16) |
-							(static_cast<UInt32>(buffer[2]) <<  8) |
-							 static_cast<UInt32>(buffer[3]));
-						LOG((CLOG_DEBUG2 "readf: read %d byte integer[%d]: %d (0x%x)", len, i, reinterpret_cast<std::vector<UInt32>*>(v)->back(), reinterpret_cast<std::vector<UInt32>*>(v)->back()));
-					}
+					// 4 byte integers
+					readVector(reader,
+							reinterpret_cast<std::vector<UInt32>*>(v), n);
 					break;
 				}
+				LOG((CLOG_DEBUG2 "readf: read %d %d byte integers", n, len));
 				break;
 			}
 
@@ -198,41 +190,21 @@ CProtocolUtil::vreadf(IStream* stream, const char* fmt, va_list args)
 				assert(len == 0);
 
 				// read the string length
-				UInt8 buffer[128];
-				read(stream, buffer, 4);
+				const UInt8* buffer = reader.read(4);
 				UInt32 len = (static_cast<UInt32>(buffer[0]) << 24) |
 							 (static_cast<UInt32>(buffer[1]) << 16) |
 							 (static_cast<UInt32>(buffer[2]) <<  8) |
 							  static_cast<UInt32>(buffer[3]);
 
-				// use a fixed size buffer if its big enough
-				const bool useFixed = (len <= sizeof(buffer));
-
-				// allocate a buffer to read the data
-				UInt8* sBuffer = buffer;
-				if (!useFixed) {
-					sBuffer = new UInt8[len];
-				}
-
-				// read the data
-				try {
-					read(stream, sBuffer, len);
-				}
-				catch (...) {
-					if (!useFixed) {
-						delete[] sBuffer;
-					}
-					throw;
-				}
+				// copy the data straight into the string
+				const UInt8* sBuffer = reader.read(len);
 				LOG((CLOG_DEBUG2 "readf: read %d byte string: %.*s", len, len, sBuffer));
-
-				// save the data
 				CString* dst = va_arg(args, CString*);
-				dst->assign((const char*)sBuffer, len);
-
-				// release the buffer
-				if (!useFixed) {
-					delete[] sBuffer;
+				if (len > 0) {
+					dst->assign((const char*)sBuffer, len);
+				}
+				else {
+					dst->erase();
 				}
 				break;
 			}
@@ -250,8 +222,8 @@ CProtocolUtil::vreadf(IStream* stream, const char* fmt, va_list args)
 		}
 		else {
 			// read next character
-			char buffer[1];
-			read(stream, buffer, 1);
+			const char* buffer =
+				reinterpret_cast<const char*>(reader.read(1));
 
 			// verify match
 			if (buffer[0] != *fmt) {
@@ -300,7 +272,6 @@ CProtocolUtil::getLength(const char* fmt, va_list args)
 			case 's':
 				assert(len == 0);
 				len = (va_arg(args, CString*))->size() + 4;
-				(void)va_arg(args, UInt8*);
 				break;
 
 			case 'S':
@@ -503,27 +474,102 @@ CProtocolUtil::eatLength(const char** pfmt)
 	}
 }
 
-void
-CProtocolUtil::read(IStream* stream, void* vbuffer, UInt32 count)
+bool
+CProtocolUtil::readVarint(IStream* stream, UInt32& value)
 {
 	assert(stream != NULL);
-	assert(vbuffer != NULL);
 
-	UInt8* buffer = reinterpret_cast<UInt8*>(vbuffer);
-	while (count > 0) {
-		// read more
-		UInt32 n = stream->read(buffer, count);
+	value = 0;
+	try {
+		CReader reader(stream);
+		for (UInt32 shift = 0; shift < 35; shift += 7) {
+			const UInt8 byte = *reader.read(1);
+			value |= static_cast<UInt32>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) {
+				return true;
+			}
+		}
+	}
+	catch (XIO&) {
+		// fall through
+	}
+	return false;
+}
 
-		// bail if stream has hungup
-		if (n == 0) {
-			LOG((CLOG_DEBUG2 "unexpected disconnect in readf(), %d bytes left", count));
-			throw XIOEndOfStream();
+bool
+CProtocolUtil::readSignedVarint(IStream* stream, SInt32& value)
+{
+	UInt32 u;
+	if (!readVarint(stream, u)) {
+		return false;
+	}
+	value = static_cast<SInt32>((u >> 1) ^ (0u - (u & 1)));
+	return true;
+}
+
+template <class T>
+void
+CProtocolUtil::readVector(CReader& reader, std::vector<T>* v, UInt32 n)
+{
+	// the integers must all have arrived already so check the count
+	// before growing the vector.  a bogus count can't make us allocate
+	// a huge vector.
+	if (n > reader.getSize() / sizeof(T)) {
+		throw XIOEndOfStream();
+	}
+	if (n == 0) {
+		return;
+	}
+
+	// convert from NBO straight into the vector's storage
+	const UInt8* src = reader.read(n * sizeof(T));
+	const size_t base = v->size();
+	v->resize(base + n);
+	T* dst = &(*v)[base];
+	for (UInt32 i = 0; i < n; ++i) {
+		T x = 0;
+		for (UInt32 j = 0; j < sizeof(T); ++j) {
+			x = static_cast<T>((x << 8) | src[j]);
 		}
+		dst[i] = x;
+		src   += sizeof(T);
+	}
+}
+
+
+//
+// CProtocolUtil::CReader
+//
+
+CProtocolUtil::CReader::CReader(IStream* stream) :
+	m_stream(stream),
+	m_data(NULL),
+	m_size(stream->getSize()),
+	m_used(0)
+{
+	assert(m_stream != NULL);
+
+	m_data = reinterpret_cast<const UInt8*>(m_stream->peek(m_size));
+}
+
+CProtocolUtil::CReader::~CReader()
+{
+	// remove what was parsed from the stream
+	if (m_used > 0) {
+		m_stream->read(NULL, m_used);
+	}
+}
 
-		// prepare for next read
-		buffer += n;
-		count  -= n;
+const UInt8*
+CProtocolUtil::CReader::read(UInt32 n)
+{
+	if (n > m_size - m_used) {
+		LOG((CLOG_DEBUG2 "unexpected end of message in readf(), %d bytes left", n - (m_size - m_used)));
+		throw XIOEndOfStream();
 	}
+	const UInt8* data = m_data + m_used;
+	m_used += n;
+	return data;
 }
 
 
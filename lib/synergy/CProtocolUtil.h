@@ -16,11 +16,11 @@
 #define CPROTOCOLUTIL_H
 
 #include "BasicTypes.h"
+#include "IStream.h"
 #include "XIO.h"
+#include "stdvector.h"
 #include <stdarg.h>
 
-class IStream;
-
 //! Synergy protocol utilities
 /*!
 This class provides various functions for implementing the synergy
@@ -68,16 +68,186 @@ public:
 	static bool			readf(IStream*,
 							const char* fmt, ...);
 
+	//! Get message code
+	/*!
+	Returns the 4 byte message code at \c code packed into an integer
+	the same way as the \c EMessageCode constants in ProtocolTypes.h.
+	*/
+	static UInt32		getCode(const UInt8* code);
+
+	//! Encode a message
+	/*!
+	Encode \c msg, including its code, into \c buffer, which must
+	have room for at least \c T::kSize bytes.  \c T is one of the
+	message classes in ProtocolTypes.h.  Returns \c T::kSize.
+	*/
+	template <class T>
+	static UInt32		encode(UInt8* buffer, const T& msg);
+
+	//! Decode a message
+	/*!
+	Decode the parameters of a message, not including its code, from
+	the \c size bytes at \c data into \c msg.  Returns false if there
+	are fewer than \c T::kSize - 4 bytes.
+	*/
+	template <class T>
+	static bool			decode(const UInt8* data, UInt32 size, T& msg);
+
+	//! Write a message
+	/*!
+	Encode \c msg and write it to the stream in a single write.
+	*/
+	template <class T>
+	static void			writeMessage(IStream*, const T& msg);
+
+	//! Read a message
+	/*!
+	Decode the parameters of a message whose code has already been
+	read from the stream into \c msg, straight from the stream's
+	buffered input (see \c IStream::peek()), then discard them.
+	Returns true if the whole message had arrived, false otherwise.
+	*/
+	template <class T>
+	static bool			readMessage(IStream*, T& msg);
+
+	//! Encode a varint
+	/*!
+	Encode \c value into \c buffer as a varint, as used by the compact
+	input records in ProtocolTypes.h.  \c buffer must have room for at
+	least 5 bytes.  Returns the number of bytes written.
+	*/
+	static UInt32		encodeVarint(UInt8* buffer, UInt32 value);
+
+	//! Encode a signed varint
+	/*!
+	Like encodeVarint() except \c value is zig-zag encoded first.
+	*/
+	static UInt32		encodeSignedVarint(UInt8* buffer, SInt32 value);
+
+	//! Read a varint
+	/*!
+	Read a varint written by encodeVarint() from the stream into
+	\c value.  Returns false if the stream ends or the varint is
+	longer than 5 bytes.
+	*/
+	static bool			readVarint(IStream*, UInt32& value);
+
+	//! Read a signed varint
+	/*!
+	Like readVarint() except reads a value written by
+	encodeSignedVarint().
+	*/
+	static bool			readSignedVarint(IStream*, SInt32& value);
+
 private:
+	// visitors for the message classes' fields()
+	class CEncoder {
+	public:
+		CEncoder(UInt8* buffer) : m_buffer(buffer) { }
+
+		void			operator()(UInt8 v)
+						{
+							*m_buffer++ = v;
+						}
+		void			operator()(UInt16 v)
+						{
+							*m_buffer++ = static_cast<UInt8>(v >> 8);
+							*m_buffer++ = static_cast<UInt8>(v);
+						}
+		void			operator()(SInt16 v)
+						{
+							(*this)(static_cast<UInt16>(v));
+						}
+		void			operator()(UInt32 v)
+						{
+							*m_buffer++ = static_cast<UInt8>(v >> 24);
+							*m_buffer++ = static_cast<UInt8>(v >> 16);
+							*m_buffer++ = static_cast<UInt8>(v >> 8);
+							*m_buffer++ = static_cast<UInt8>(v);
+						}
+		void			operator()(SInt32 v)
+						{
+							(*this)(static_cast<UInt32>(v));
+						}
+
+	public:
+		UInt8*			m_buffer;
+	};
+
+	class CDecoder {
+	public:
+		CDecoder(const UInt8* data) : m_data(data) { }
+
+		void			operator()(UInt8& v)
+						{
+							v = *m_data++;
+						}
+		void			operator()(UInt16& v)
+						{
+							v = static_cast<UInt16>(
+								(static_cast<UInt16>(m_data[0]) << 8) |
+								 static_cast<UInt16>(m_data[1]));
+							m_data += 2;
+						}
+		void			operator()(SInt16& v)
+						{
+							UInt16 u;
+							(*this)(u);
+							v = static_cast<SInt16>(u);
+						}
+		void			operator()(UInt32& v)
+						{
+							v = (static_cast<UInt32>(m_data[0]) << 24) |
+								(static_cast<UInt32>(m_data[1]) << 16) |
+								(static_cast<UInt32>(m_data[2]) <<  8) |
+								 static_cast<UInt32>(m_data[3]);
+							m_data += 4;
+						}
+		void			operator()(SInt32& v)
+						{
+							UInt32 u;
+							(*this)(u);
+							v = static_cast<SInt32>(u);
+						}
+
+	public:
+		const UInt8*	m_data;
+	};
+
+	// parses the stream's buffered input in place.  with a packet
+	// stream filter that's a view of the rest of the packet.  what was
+	// parsed is removed from the stream when the reader is destroyed.
+	class CReader {
+	public:
+		CReader(IStream*);
+		~CReader();
+
+		// returns the next n bytes.  throws XIOEndOfStream if there
+		// aren't that many left.
+		const UInt8*	read(UInt32 n);
+
+		// returns the number of bytes left
+		UInt32			getSize() const { return m_size - m_used; }
+
+	private:
+		IStream*		m_stream;
+		const UInt8*	m_data;
+		UInt32			m_size;
+		UInt32			m_used;
+	};
+
 	static void			vwritef(IStream*,
 							const char* fmt, UInt32 size, va_list);
-	static void			vreadf(IStream*,
+	static void			vreadf(CReader&,
 							const char* fmt, va_list);
 
 	static UInt32		getLength(const char* fmt, va_list);
 	static void			writef(void*, const char* fmt, va_list);
 	static UInt32		eatLength(const char** fmt);
-	static void			read(IStream*, void*, UInt32);
+
+	// append n NBO integers of type T to v
+	template <class T>
+	static void			readVector(CReader&, std::vector<T>* v, UInt32 n);
 };
 
 //! Mismatched read exception
@@ -91,5 +261,100 @@ public:
 	virtual CString		getWhat() const throw();
 };
 
+inline
+UInt32
+CProtocolUtil::getCode(const UInt8* code)
+{
+	return (static_cast<UInt32>(code[0]) << 24) |
+			(static_cast<UInt32>(code[1]) << 16) |
+			(static_cast<UInt32>(code[2]) <<  8) |
+			 static_cast<UInt32>(code[3]);
+}
+
+inline
+UInt32
+CProtocolUtil::encodeVarint(UInt8* buffer, UInt32 value)
+{
+	UInt8* dst = buffer;
+	while (value >= 0x80) {
+		*dst++ = static_cast<UInt8>(value | 0x80);
+		value >>= 7;
+	}
+	*dst++ = static_cast<UInt8>(value);
+	return static_cast<UInt32>(dst - buffer);
+}
+
+inline
+UInt32
+CProtocolUtil::encodeSignedVarint(UInt8* buffer, SInt32 value)
+{
+	return encodeVarint(buffer, (static_cast<UInt32>(value) << 1) ^
+								static_cast<UInt32>(value >> 31));
+}
+
+template <class T>
+inline
+UInt32
+CProtocolUtil::encode(UInt8* buffer, const T& msg)
+{
+	assert(buffer != NULL);
+
+	const char* code = T::getCode();
+	buffer[0] = static_cast<UInt8>(code[0]);
+	buffer[1] = static_cast<UInt8>(code[1]);
+	buffer[2] = static_cast<UInt8>(code[2]);
+	buffer[3] = static_cast<UInt8>(code[3]);
+
+	CEncoder encoder(buffer + 4);
+	T::fields(msg, encoder);
+	assert(encoder.m_buffer == buffer + T::kSize);
+	return T::kSize;
+}
+
+template <class T>
+inline
+bool
+CProtocolUtil::decode(const UInt8* data, UInt32 size, T& msg)
+{
+	if (size < static_cast<UInt32>(T::kSize - 4)) {
+		return false;
+	}
+
+	CDecoder decoder(data);
+	T::fields(msg, decoder);
+	assert(decoder.m_data == data + T::kSize - 4);
+	return true;
+}
+
+template <class T>
+inline
+void
+CProtocolUtil::writeMessage(IStream* stream, const T& msg)
+{
+	assert(stream != NULL);
+
+	UInt8 buffer[T::kSize];
+	stream->write(buffer, encode(buffer, msg));
+}
+
+template <class T>
+inline
+bool
+CProtocolUtil::readMessage(IStream* stream, T& msg)
+{
+	assert(stream != NULL);
+
+	// decode straight out of the stream's buffer then discard the
+	// message.  with a packet stream filter that's where the socket
+	// read the packet.
+	const UInt32 size = T::kSize - 4;
+	if (stream->getSize() < size) {
+		return false;
+	}
+	decode(static_cast<const UInt8*>(stream->peek(size)), size, msg);
+	stream->read(NULL, size);
+	return true;
+}
+
 #endif
 
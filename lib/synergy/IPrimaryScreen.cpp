@@ -13,6 +13,7 @@
  */
 
 #include "IPrimaryScreen.h"
+#include "CEventDataPool.h"
 
 //
 // IPrimaryScreen
@@ -115,7 +116,8 @@ IPrimaryScreen::getFakeInputEndEvent()
 IPrimaryScreen::CButtonInfo*
 IPrimaryScreen::CButtonInfo::alloc(ButtonID id, KeyModifierMask mask)
 {
-	CButtonInfo* info = (CButtonInfo*)malloc(sizeof(CButtonInfo));
+	CButtonInfo* info = (CButtonInfo*)CEventDataPool::alloc(
+								sizeof(CButtonInfo));
 	info->m_button = id;
 	info->m_mask   = mask;
 	return info;
@@ -124,12 +126,22 @@ IPrimaryScreen::CButtonInfo::alloc(ButtonID id, KeyModifierMask mask)
 IPrimaryScreen::CButtonInfo*
 IPrimaryScreen::CButtonInfo::alloc(const CButtonInfo& x)
 {
-	CButtonInfo* info = (CButtonInfo*)malloc(sizeof(CButtonInfo));
+	CButtonInfo* info = (CButtonInfo*)CEventDataPool::alloc(
+								sizeof(CButtonInfo));
 	info->m_button = x.m_button;
 	info->m_mask   = x.m_mask;
 	return info;
 }
 
+IPrimaryScreen::CButtonInfo
+IPrimaryScreen::CButtonInfo::make(ButtonID id, KeyModifierMask mask)
+{
+	CButtonInfo info;
+	info.m_button = id;
+	info.m_mask   = mask;
+	return info;
+}
+
 bool
 IPrimaryScreen::CButtonInfo::equal(const CButtonInfo* a, const CButtonInfo* b)
 {
@@ -144,12 +156,22 @@ IPrimaryScreen::CButtonInfo::equal(const CButtonInfo* a, const CButtonInfo* b)
 IPrimaryScreen::CMotionInfo*
 IPrimaryScreen::CMotionInfo::alloc(SInt32 x, SInt32 y)
 {
-	CMotionInfo* info = (CMotionInfo*)malloc(sizeof(CMotionInfo));
+	CMotionInfo* info = (CMotionInfo*)CEventDataPool::alloc(
+								sizeof(CMotionInfo));
 	info->m_x = x;
 	info->m_y = y;
 	return info;
 }
 
+IPrimaryScreen::CMotionInfo
+IPrimaryScreen::CMotionInfo::make(SInt32 x, SInt32 y)
+{
+	CMotionInfo info;
+	info.m_x = x;
+	info.m_y = y;
+	return info;
+}
+
 
 //
 // IPrimaryScreen::CWheelInfo
@@ -158,12 +180,22 @@ IPrimaryScreen::CMotionInfo::alloc(SInt32 x, SInt32 y)
 IPrimaryScreen::CWheelInfo*
 IPrimaryScreen::CWheelInfo::alloc(SInt32 xDelta, SInt32 yDelta)
 {
-	CWheelInfo* info = (CWheelInfo*)malloc(sizeof(CWheelInfo));
+	CWheelInfo* info = (CWheelInfo*)CEventDataPool::alloc(
+								sizeof(CWheelInfo));
 	info->m_xDelta = xDelta;
 	info->m_yDelta = yDelta;
 	return info;
 }
 
+IPrimaryScreen::CWheelInfo
+IPrimaryScreen::CWheelInfo::make(SInt32 xDelta, SInt32 yDelta)
+{
+	CWheelInfo info;
+	info.m_xDelta = xDelta;
+	info.m_yDelta = yDelta;
+	return info;
+}
+
 
 //
 // IPrimaryScreen::CHotKeyInfo
@@ -172,7 +204,16 @@ IPrimaryScreen::CWheelInfo::alloc(SInt32 xDelta, SInt32 yDelta)
 IPrimaryScreen::CHotKeyInfo*
 IPrimaryScreen::CHotKeyInfo::alloc(UInt32 id)
 {
-	CHotKeyInfo* info = (CHotKeyInfo*)malloc(sizeof(CHotKeyInfo));
+	CHotKeyInfo* info = (CHotKeyInfo*)CEventDataPool::alloc(
+								sizeof(CHotKeyInfo));
 	info->m_id = id;
 	return info;
 }
+
+IPrimaryScreen::CHotKeyInfo
+IPrimaryScreen::CHotKeyInfo::make(UInt32 id)
+{
+	CHotKeyInfo info;
+	info.m_id = id;
+	return info;
+}
@@ -32,6 +32,7 @@ public:
 	public:
 		static CButtonInfo* alloc(ButtonID, KeyModifierMask);
 		static CButtonInfo* alloc(const CButtonInfo&);
+		static CButtonInfo	make(ButtonID, KeyModifierMask);
 
 		static bool			equal(const CButtonInfo*, const CButtonInfo*);
 
@@ -43,6 +44,7 @@ public:
 	class CMotionInfo {
 	public:
 		static CMotionInfo* alloc(SInt32 x, SInt32 y);
+		static CMotionInfo	make(SInt32 x, SInt32 y);
 
 	public:
 		SInt32			m_x;
@@ -52,6 +54,7 @@ public:
 	class CWheelInfo {
 	public:
 		static CWheelInfo* alloc(SInt32 xDelta, SInt32 yDelta);
+		static CWheelInfo	make(SInt32 xDelta, SInt32 yDelta);
 
 	public:
 		SInt32			m_xDelta;
@@ -61,6 +64,7 @@ public:
 	class CHotKeyInfo {
 	public:
 		static CHotKeyInfo* alloc(UInt32 id);
+		static CHotKeyInfo	make(UInt32 id);
 
 	public:
 		UInt32			m_id;
@@ -16,32 +16,43 @@
 
 const char*				kMsgHello			= "Synergy%2i%2i";
 const char*				kMsgHelloBack		= "Synergy%2i%2i%s";
+const char*				kMsgHelloCapabilities	= "%4I";
 const char*				kMsgCNoop 			= "CNOP";
 const char*				kMsgCClose 			= "CBYE";
-const char*				kMsgCEnter 			= "CINN%2i%2i%4i%2i";
+const char*				kMsgCEnter 			= "CINN%4i%4i%4i%2i";
+const char*				kMsgCEnter1_3		= "CINN%2i%2i%4i%2i";
 const char*				kMsgCLeave 			= "COUT";
 const char*				kMsgCClipboard 		= "CCLP%1i%4i";
 const char*				kMsgCScreenSaver 	= "CSEC%1i";
 const char*				kMsgCResetOptions	= "CROP";
 const char*				kMsgCInfoAck		= "CIAK";
 const char*				kMsgCKeepAlive		= "CALV";
+const char*				kMsgCMotionChannel	= "CMCH%4i";
 const char*				kMsgDKeyDown		= "DKDN%2i%2i%2i";
 const char*				kMsgDKeyDown1_0		= "DKDN%2i%2i";
+const char*				kMsgDKeyDownRepeat	= "DKDR%2i%2i%2i%2i%2i";
 const char*				kMsgDKeyRepeat		= "DKRP%2i%2i%2i%2i";
 const char*				kMsgDKeyRepeat1_0	= "DKRP%2i%2i%2i";
 const char*				kMsgDKeyUp			= "DKUP%2i%2i%2i";
 const char*				kMsgDKeyUp1_0		= "DKUP%2i%2i";
 const char*				kMsgDMouseDown		= "DMDN%1i";
 const char*				kMsgDMouseUp		= "DMUP%1i";
-const char*				kMsgDMouseMove		= "DMMV%2i%2i";
+const char*				kMsgDMouseMove		= "DMMV%4i%4i";
+const char*				kMsgDMouseMove1_3	= "DMMV%2i%2i";
 const char*				kMsgDMouseRelMove	= "DMRM%2i%2i";
+const char*				kMsgDMouseRelMoveBatch	= "DMRB%2I";
+const char*				kMsgDMotionSync		= "DMSY%4i%4i%4i%4i%4i%4i";
 const char*				kMsgDMouseWheel		= "DMWM%2i%2i";
 const char*				kMsgDMouseWheel1_0	= "DMWM%2i";
 const char*				kMsgDClipboard		= "DCLP%1i%4i%s";
-const char*				kMsgDInfo			= "DINF%2i%2i%2i%2i%2i%2i%2i";
+const char*				kMsgDInfo			= "DINF%4i%4i%4i%4i%2i%4i%4i";
+const char*				kMsgDInfo1_3		= "DINF%2i%2i%2i%2i%2i%2i%2i";
 const char*				kMsgDSetOptions		= "DSOP%4I";
+const char*				kMsgDCapabilities	= "DCAP%4I";
 const char*				kMsgQInfo			= "QINF";
 const char*				kMsgEIncompatible	= "EICV%2i%2i";
 const char*				kMsgEBusy 			= "EBSY";
 const char*				kMsgEUnknown		= "EUNK";
 const char*				kMsgEBad			= "EBAD";
+const char*				kMsgMotionHello		= "MHLO%4i";
+const char*				kMsgMotionUpdate	= "MUPD%4i%4i%4i%4i%4i%4i%4i";
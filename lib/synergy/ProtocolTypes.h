@@ -16,6 +16,7 @@
 #define PROTOCOLTYPES_H
 
 #include "BasicTypes.h"
+#include "stdvector.h"
 
 // protocol version number
 // 1.0:  initial protocol
@@ -23,8 +24,11 @@
 // 1.2:  adds mouse relative motion
 // 1.3:  adds keep alive and deprecates heartbeats,
 //       adds horizontal mouse scrolling
+// 1.4:  uses 32 bit absolute positions and screen sizes,
+//       adds capability negotiation, batched relative mouse motion,
+//       compact input records and client generated key repeat
 static const SInt16		kProtocolMajorVersion = 1;
-static const SInt16		kProtocolMinorVersion = 3;
+static const SInt16		kProtocolMinorVersion = 4;
 
 // default contact port number
 static const UInt16		kDefaultPort = 24800;
@@ -40,6 +44,10 @@ static const double		kKeepAliveRate = 3.0;
 // number of skipped kMsgCKeepAlive messages that indicates a problem
 static const double		kKeepAlivesUntilDeath = 3.0;
 
+// minimum time between kMsgCNoop acknowledgements (in seconds) from a
+// client using kCapNoAck
+static const double		kAckInterval = 0.02;
+
 // obsolete heartbeat stuff
 static const double		kHeartRate = -1.0;
 static const double		kHeartBeatsUntilDeath = 3.0;
@@ -72,7 +80,8 @@ enum EDirectionMask {
 //
 
 //
-// positions and sizes are signed 16 bit integers.
+// positions and sizes are signed 32 bit integers (16 bit before
+// protocol 1.4).  relative motion deltas are signed 16 bit integers.
 //
 
 //
@@ -90,12 +99,21 @@ extern const char*		kMsgHello;
 // name.
 extern const char*		kMsgHelloBack;
 
+// capabilities offered with the hello reply;  secondary -> primary
+// clients implementing protocol 1.4 or later append this to the
+// kMsgHelloBack message.  $1 = capability id/value pairs, one for
+// each capability the client supports (see kCap*).
+extern const char*		kMsgHelloCapabilities;
+
 
 //
 // command codes
 //
 
 // no operation;  secondary -> primary
+// clients send this after every message to work around delayed ACKs
+// unless kCapNoAck is on.  then they send it at most every kAckInterval
+// seconds while messages are arriving.
 extern const char*		kMsgCNoop;
 
 // close connection;  primary -> secondary
@@ -111,6 +129,9 @@ extern const char*		kMsgCClose;
 // should adjust its toggle modifiers to reflect that state.
 extern const char*		kMsgCEnter;
 
+// enter screen 1.3:  same as above but x,y are 16 bit
+extern const char*		kMsgCEnter1_3;
+
 // leave screen:  primary -> secondary
 // leaving screen.  the secondary screen should send clipboard
 // data in response to this message for those clipboards that
@@ -151,6 +172,12 @@ extern const char*		kMsgCInfoAck;
 // defined by an option.
 extern const char*		kMsgCKeepAlive;
 
+// open motion side channel:  primary -> secondary
+// sent after kMsgDCapabilities if the kCapMotionChannel capability is
+// on and the primary can take datagrams.  $1 = token identifying the
+// secondary's datagrams.  see the motion side channel below.
+extern const char*		kMsgCMotionChannel;
+
 
 //
 // data codes
@@ -172,6 +199,16 @@ extern const char*		kMsgDKeyDown;
 // key pressed 1.0:  same as above but without KeyButton
 extern const char*		kMsgDKeyDown1_0;
 
+// key pressed with repeat:  primary -> secondary
+// only sent if the kCapKeyRepeat capability is on.  $1 = KeyID,
+// $2 = KeyModifierMask, $3 = KeyButton as for kMsgDKeyDown.  $4 =
+// repeat delay, $5 = repeat interval, both in milliseconds.  the
+// secondary repeats the key itself, first after the delay and then
+// every interval, until it receives the key's kMsgDKeyUp, another key
+// press or a kMsgCLeave.  the primary doesn't send kMsgDKeyRepeat for
+// the key.
+extern const char*		kMsgDKeyDownRepeat;
+
 // key auto-repeat:  primary -> secondary
 // $1 = KeyID, $2 = KeyModifierMask, $3 = number of repeats, $4 = KeyButton
 extern const char*		kMsgDKeyRepeat;
@@ -198,14 +235,36 @@ extern const char*		kMsgDMouseUp;
 // $1 = x, $2 = y.  x,y are absolute screen coordinates.
 extern const char*		kMsgDMouseMove;
 
+// mouse moved 1.3:  same as above but x,y are 16 bit
+extern const char*		kMsgDMouseMove1_3;
+
 // relative mouse move:  primary -> secondary
 // $1 = dx, $2 = dy.  dx,dy are motion deltas.
 extern const char*		kMsgDMouseRelMove;
 
+// batched relative mouse move:  primary -> secondary
+// only sent if the kCapMotionBatch capability is on.
+// $1 = motion samples, three 2 byte integers per sample:  dx, dy
+// and the time in microseconds since the previous sample in the
+// batch (0 for the first sample and at most 65535).  samples are
+// in the order the motion happened.  a batch is equivalent to a
+// kMsgDMouseRelMove for each sample but saves the framing of each.
+extern const char*		kMsgDMouseRelMoveBatch;
+
+// motion side channel sync:  primary -> secondary
+// $1..$6 = as for kMsgMotionUpdate.  sent, if motion went over the side
+// channel since the last one, before any other input and before
+// kMsgCLeave so the secondary has all motion up to that point.  the
+// secondary handles it as if the datagram had arrived.
+extern const char*		kMsgDMotionSync;
+
 // mouse scroll:  primary -> secondary
 // $1 = xDelta, $2 = yDelta.  the delta should be +120 for one tick forward
 // (away from the user) or right and -120 for one tick backward (toward
-// the user) or left.
+// the user) or left.  high resolution wheels and touchpads scroll by
+// fractions of a tick so deltas needn't be multiples of 120;  the
+// secondary should save what it can't use yet for the next scroll.
+// a message may carry the scrolling of several wheel events.
 extern const char*		kMsgDMouseWheel;
 
 // mouse vertical scroll:  primary -> secondary
@@ -235,11 +294,22 @@ extern const char*		kMsgDClipboard;
 // the new screen area.
 extern const char*		kMsgDInfo;
 
+// client data 1.3:  same as above but all values are 16 bit
+extern const char*		kMsgDInfo1_3;
+
 // set options:  primary -> secondary
 // client should set the given option/value pairs.  $1 = option/value
 // pairs.
 extern const char*		kMsgDSetOptions;
 
+// set capabilities:  primary -> secondary
+// sent to clients implementing protocol 1.4 or later before any other
+// message after the greeting handshake.  $1 = capability id/value
+// pairs, one for each capability offered in kMsgHelloCapabilities
+// that the primary will use, with the value to use.  capabilities
+// not listed are off for the connection.
+extern const char*		kMsgDCapabilities;
+
 
 //
 // query codes
@@ -271,6 +341,205 @@ extern const char*		kMsgEUnknown;
 extern const char*		kMsgEBad;
 
 
+//
+// motion side channel datagrams (see kCapMotionChannel)
+//
+
+// hello:  secondary -> primary
+// $1 = token from kMsgCMotionChannel.
+extern const char*		kMsgMotionHello;
+
+// motion update:  primary -> secondary
+// $1 = token from kMsgCMotionChannel, $2 = number of the last motion,
+// $3 = number of the last absolute motion or 0 if none, $4 = x, $5 = y
+// of that motion, $6 = dx, $7 = dy of all relative motion since.
+extern const char*		kMsgMotionUpdate;
+
+
+//
+// message codes packed into 4 byte integers, first character in the
+// most significant byte.  CProtocolUtil::getCode() packs a code read
+// from a stream the same way.  these are constant expressions so they
+// can be used to dispatch messages with a switch.  each has the same
+// name as the message format above with kCode in place of kMsg.
+//
+
+// macro for packing 4 characters into a 4 byte integer constant
+#define MESSAGE_CODE(_a, _b, _c, _d)				\
+	((static_cast<UInt32>(_a) << 24) |				\
+	 (static_cast<UInt32>(_b) << 16) |				\
+	 (static_cast<UInt32>(_c) <<  8) |				\
+	  static_cast<UInt32>(_d))
+
+enum EMessageCode {
+	kCodeCNoop              = MESSAGE_CODE('C', 'N', 'O', 'P'),
+	kCodeCClose             = MESSAGE_CODE('C', 'B', 'Y', 'E'),
+	kCodeCEnter             = MESSAGE_CODE('C', 'I', 'N', 'N'),
+	kCodeCLeave             = MESSAGE_CODE('C', 'O', 'U', 'T'),
+	kCodeCClipboard         = MESSAGE_CODE('C', 'C', 'L', 'P'),
+	kCodeCScreenSaver       = MESSAGE_CODE('C', 'S', 'E', 'C'),
+	kCodeCResetOptions      = MESSAGE_CODE('C', 'R', 'O', 'P'),
+	kCodeCInfoAck           = MESSAGE_CODE('C', 'I', 'A', 'K'),
+	kCodeCKeepAlive         = MESSAGE_CODE('C', 'A', 'L', 'V'),
+	kCodeCMotionChannel     = MESSAGE_CODE('C', 'M', 'C', 'H'),
+	kCodeDKeyDown           = MESSAGE_CODE('D', 'K', 'D', 'N'),
+	kCodeDKeyDownRepeat     = MESSAGE_CODE('D', 'K', 'D', 'R'),
+	kCodeDKeyRepeat         = MESSAGE_CODE('D', 'K', 'R', 'P'),
+	kCodeDKeyUp             = MESSAGE_CODE('D', 'K', 'U', 'P'),
+	kCodeDMouseDown         = MESSAGE_CODE('D', 'M', 'D', 'N'),
+	kCodeDMouseUp           = MESSAGE_CODE('D', 'M', 'U', 'P'),
+	kCodeDMouseMove         = MESSAGE_CODE('D', 'M', 'M', 'V'),
+	kCodeDMouseRelMove      = MESSAGE_CODE('D', 'M', 'R', 'M'),
+	kCodeDMouseRelMoveBatch = MESSAGE_CODE('D', 'M', 'R', 'B'),
+	kCodeDMotionSync        = MESSAGE_CODE('D', 'M', 'S', 'Y'),
+	kCodeDMouseWheel        = MESSAGE_CODE('D', 'M', 'W', 'M'),
+	kCodeDClipboard         = MESSAGE_CODE('D', 'C', 'L', 'P'),
+	kCodeDInfo              = MESSAGE_CODE('D', 'I', 'N', 'F'),
+	kCodeDSetOptions        = MESSAGE_CODE('D', 'S', 'O', 'P'),
+	kCodeDCapabilities      = MESSAGE_CODE('D', 'C', 'A', 'P'),
+	kCodeQInfo              = MESSAGE_CODE('Q', 'I', 'N', 'F'),
+	kCodeMotionHello        = MESSAGE_CODE('M', 'H', 'L', 'O'),
+	kCodeMotionUpdate       = MESSAGE_CODE('M', 'U', 'P', 'D'),
+	kCodeEIncompatible      = MESSAGE_CODE('E', 'I', 'C', 'V'),
+	kCodeEBusy              = MESSAGE_CODE('E', 'B', 'S', 'Y'),
+	kCodeEUnknown           = MESSAGE_CODE('E', 'U', 'N', 'K'),
+	kCodeEBad               = MESSAGE_CODE('E', 'B', 'A', 'D')
+};
+
+
+//
+// capabilities.  these are optional features negotiated per connection
+// so they can be switched on without a new protocol version.  the
+// client offers the capabilities it supports with a value for each in
+// kMsgHelloCapabilities and the primary replies with kMsgDCapabilities
+// listing those it will use.  unless noted otherwise the primary uses
+// the smaller of its own value and the client's.  values are never 0;
+// 0 means the capability is off.
+//
+
+//! Capability identifier
+typedef UInt32			CapabilityID;
+
+//! Capability id/value pairs
+typedef std::vector<UInt32> CCapabilityList;
+
+// batched relative mouse motion (kMsgDMouseRelMoveBatch).  the value
+// is the most samples in one batch.
+static const CapabilityID	kCapMotionBatch = MESSAGE_CODE('M', 'B', 'A', 'T');
+
+// largest motion batch this implementation sends or offers to accept
+static const UInt32		kMaxMotionBatch = 32;
+
+// compact input records (see ECompactOpcode).  the value is the
+// version of the record format, currently 1.
+static const CapabilityID	kCapCompactInput = MESSAGE_CODE('C', 'M', 'P', 'I');
+
+// client generated key repeat (kMsgDKeyDownRepeat).  the value is 1.
+static const CapabilityID	kCapKeyRepeat    = MESSAGE_CODE('K', 'R', 'P', 'T');
+
+// mouse motion over a datagram side channel (kMsgCMotionChannel).  the
+// value is 1.  the primary only uses it if it can take datagrams.
+static const CapabilityID	kCapMotionChannel = MESSAGE_CODE('U', 'D', 'P', 'M');
+
+// session resumption.  the client offers 1 or, to resume a session it
+// lost less than kSessionResumeTime seconds ago, that session's token.
+// the primary replies with the connection's token:  the offered token
+// if it resumed the session, otherwise a new one that is never 1.  only
+// a connection from the host that started the session, with the same
+// screen name, can resume it.  a resumed session skips kMsgQInfo,
+// kMsgDInfo and waiting for kMsgDSetOptions;  the handshake is complete
+// once kMsgDCapabilities arrives and the primary keeps the screen's slot
+// and clipboard state.  the client then sends a kMsgDInfo in case its
+// screen changed.
+static const CapabilityID	kCapResume = MESSAGE_CODE('R', 'S', 'U', 'M');
+
+// seconds the primary holds a lost session for resumption
+static const double		kSessionResumeTime = 60.0;
+
+// no kMsgCNoop after every message.  the client instead acknowledges
+// what has arrived at most every kAckInterval seconds.  the value is 1.
+static const CapabilityID	kCapNoAck = MESSAGE_CODE('N', 'A', 'C', 'K');
+
+
+//
+// compact input records.  when kCapCompactInput is on the primary
+// sends these in place of the data messages for input.  a record is a
+// one byte opcode followed by its fields, with no message code.
+// opcodes are less than kCompactLast so they can't be mistaken for
+// the first character of a message code.  records may be written
+// back to back in a single packet.
+//
+// fields are varints:  7 bits per byte, least significant group
+// first, with the high bit set in every byte but the last.  signed
+// fields are zig-zag encoded first ((n << 1) ^ (n >> 31)) so small
+// values of either sign take one byte.  in comments, $n refers to
+// the n'th field as in the message codes above.
+//
+
+enum ECompactOpcode {
+	// mouse moved;  $1 = dx, $2 = dy (signed) from the last absolute
+	// position sent by kMsgCEnter, kMsgDMouseMove or this record
+	kCompactMouseMove = 1,
+
+	// relative mouse move;  $1 = dx, $2 = dy (signed)
+	kCompactMouseRelMove,
+
+	// relative mouse move;  $1 = dx, $2 = dy (signed), $3 = time in
+	// microseconds since the previous relative move (at most 65535)
+	kCompactMouseRelMoveTimed,
+
+	// mouse scroll;  $1 = xDelta, $2 = yDelta (signed)
+	kCompactMouseWheel,
+
+	// key pressed;  $1 = KeyID, $2 = KeyModifierMask, $3 = KeyButton
+	kCompactKeyDown,
+
+	// key auto-repeat;  $1 = KeyID, $2 = KeyModifierMask,
+	// $3 = number of repeats, $4 = KeyButton
+	kCompactKeyRepeat,
+
+	// key released;  $1 = KeyID, $2 = KeyModifierMask, $3 = KeyButton
+	kCompactKeyUp,
+
+	// mouse button pressed;  $1 = ButtonID
+	kCompactMouseDown,
+
+	// mouse button released;  $1 = ButtonID
+	kCompactMouseUp,
+
+	// key pressed with repeat;  $1 = KeyID, $2 = KeyModifierMask,
+	// $3 = KeyButton, $4 = repeat delay, $5 = repeat interval, as for
+	// kMsgDKeyDownRepeat
+	kCompactKeyDownRepeat,
+
+	kCompactLast = 0x20
+};
+
+
+//
+// motion side channel.  a lost TCP segment holds up everything behind
+// it so mouse motion can go in UDP datagrams instead, where a lost
+// datagram only costs the motion in it.  the primary takes datagrams
+// on the port it listens on.  after kMsgCMotionChannel the secondary
+// sends a kMsgMotionHello datagram every kMotionHelloInterval seconds.
+// once the primary has one it sends a kMsgMotionUpdate datagram for
+// each motion and no longer sends motion in messages.  keys, buttons,
+// the wheel and everything else stay on the stream.  datagrams are
+// encoded like messages and those with the wrong token are ignored.
+//
+// motions are numbered consecutively (wrapping) from 1, with the enter
+// counting as an absolute motion.  rather than the latest motion each
+// update carries the latest absolute position and the sum of relative
+// motion since, so any one update has all the secondary needs.  the
+// secondary ignores updates numbered before the last it used, moves
+// to the position if its number is new and moves by the part of the
+// relative sum it hasn't moved yet.
+//
+
+// seconds between hello datagrams
+static const double		kMotionHelloInterval = 1.0;
+
+
 //
 // structures
 //
@@ -304,5 +573,753 @@ public:
 	SInt32				m_mx, m_my;
 };
 
+
+//
+// message structures.  each fixed size message above has a class
+// holding its parameters in wire order and width.  kSize is the size
+// of the message on the wire, code included.  fields() applies a
+// visitor to each parameter in order;  CProtocolUtil uses it to
+// encode and decode messages without a format string.  the greeting
+// handshake, kMsgDClipboard and kMsgDSetOptions have variable length
+// and are still sent with CProtocolUtil::writef().
+//
+
+//! No operation message
+/*!
+Parameters of a kMsgCNoop message.
+*/
+class CMsgCNoop {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgCNoop; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Close connection message
+/*!
+Parameters of a kMsgCClose message.
+*/
+class CMsgCClose {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgCClose; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Enter screen message
+/*!
+Parameters of a kMsgCEnter message.
+*/
+class CMsgCEnter {
+public:
+	enum { kSize = 4 + 4 + 4 + 4 + 2 };
+
+	CMsgCEnter() :
+							m_x(0), m_y(0), m_seqNum(0), m_mask(0) { }
+	CMsgCEnter(SInt32 x, SInt32 y, UInt32 seqNum, UInt16 mask) :
+							m_x(x), m_y(y), m_seqNum(seqNum), m_mask(mask) { }
+
+	static const char*	getCode() { return kMsgCEnter; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_x); f(m.m_y); f(m.m_seqNum); f(m.m_mask); }
+
+public:
+	SInt32				m_x;
+	SInt32				m_y;
+	UInt32				m_seqNum;
+	UInt16				m_mask;
+};
+
+//! Enter screen message (protocol 1.3)
+/*!
+Parameters of a kMsgCEnter1_3 message.
+*/
+class CMsgCEnter1_3 {
+public:
+	enum { kSize = 4 + 2 + 2 + 4 + 2 };
+
+	CMsgCEnter1_3() :
+							m_x(0), m_y(0), m_seqNum(0), m_mask(0) { }
+	CMsgCEnter1_3(SInt16 x, SInt16 y, UInt32 seqNum, UInt16 mask) :
+							m_x(x), m_y(y), m_seqNum(seqNum), m_mask(mask) { }
+
+	static const char*	getCode() { return kMsgCEnter1_3; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_x); f(m.m_y); f(m.m_seqNum); f(m.m_mask); }
+
+public:
+	SInt16				m_x;
+	SInt16				m_y;
+	UInt32				m_seqNum;
+	UInt16				m_mask;
+};
+
+//! Leave screen message
+/*!
+Parameters of a kMsgCLeave message.
+*/
+class CMsgCLeave {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgCLeave; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Grab clipboard message
+/*!
+Parameters of a kMsgCClipboard message.
+*/
+class CMsgCClipboard {
+public:
+	enum { kSize = 4 + 1 + 4 };
+
+	CMsgCClipboard() :
+							m_id(0), m_seqNum(0) { }
+	CMsgCClipboard(UInt8 id, UInt32 seqNum) :
+							m_id(id), m_seqNum(seqNum) { }
+
+	static const char*	getCode() { return kMsgCClipboard; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_seqNum); }
+
+public:
+	UInt8				m_id;
+	UInt32				m_seqNum;
+};
+
+//! Screensaver change message
+/*!
+Parameters of a kMsgCScreenSaver message.
+*/
+class CMsgCScreenSaver {
+public:
+	enum { kSize = 4 + 1 };
+
+	CMsgCScreenSaver() :
+							m_on(0) { }
+	CMsgCScreenSaver(UInt8 on) :
+							m_on(on) { }
+
+	static const char*	getCode() { return kMsgCScreenSaver; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_on); }
+
+public:
+	UInt8				m_on;
+};
+
+//! Reset options message
+/*!
+Parameters of a kMsgCResetOptions message.
+*/
+class CMsgCResetOptions {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgCResetOptions; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Resolution change acknowledgment message
+/*!
+Parameters of a kMsgCInfoAck message.
+*/
+class CMsgCInfoAck {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgCInfoAck; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Keep connection alive message
+/*!
+Parameters of a kMsgCKeepAlive message.
+*/
+class CMsgCKeepAlive {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgCKeepAlive; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Open motion side channel message
+/*!
+Parameters of a kMsgCMotionChannel message.
+*/
+class CMsgCMotionChannel {
+public:
+	enum { kSize = 4 + 4 };
+
+	CMsgCMotionChannel() :
+							m_token(0) { }
+	CMsgCMotionChannel(UInt32 token) :
+							m_token(token) { }
+
+	static const char*	getCode() { return kMsgCMotionChannel; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_token); }
+
+public:
+	UInt32				m_token;
+};
+
+//! Key pressed message
+/*!
+Parameters of a kMsgDKeyDown message.
+*/
+class CMsgDKeyDown {
+public:
+	enum { kSize = 4 + 2 + 2 + 2 };
+
+	CMsgDKeyDown() :
+							m_id(0), m_mask(0), m_button(0) { }
+	CMsgDKeyDown(UInt16 id, UInt16 mask, UInt16 button) :
+							m_id(id), m_mask(mask), m_button(button) { }
+
+	static const char*	getCode() { return kMsgDKeyDown; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); f(m.m_button); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+	UInt16				m_button;
+};
+
+//! Key pressed with repeat message
+/*!
+Parameters of a kMsgDKeyDownRepeat message.
+*/
+class CMsgDKeyDownRepeat {
+public:
+	enum { kSize = 4 + 2 + 2 + 2 + 2 + 2 };
+
+	CMsgDKeyDownRepeat() :
+							m_id(0), m_mask(0), m_button(0),
+							m_delay(0), m_interval(0) { }
+	CMsgDKeyDownRepeat(UInt16 id, UInt16 mask, UInt16 button,
+							UInt16 delay, UInt16 interval) :
+							m_id(id), m_mask(mask), m_button(button),
+							m_delay(delay), m_interval(interval) { }
+
+	static const char*	getCode() { return kMsgDKeyDownRepeat; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); f(m.m_button); f(m.m_delay); f(m.m_interval); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+	UInt16				m_button;
+	UInt16				m_delay;
+	UInt16				m_interval;
+};
+
+//! Key pressed message (protocol 1.0)
+/*!
+Parameters of a kMsgDKeyDown1_0 message.
+*/
+class CMsgDKeyDown1_0 {
+public:
+	enum { kSize = 4 + 2 + 2 };
+
+	CMsgDKeyDown1_0() :
+							m_id(0), m_mask(0) { }
+	CMsgDKeyDown1_0(UInt16 id, UInt16 mask) :
+							m_id(id), m_mask(mask) { }
+
+	static const char*	getCode() { return kMsgDKeyDown1_0; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+};
+
+//! Key auto-repeat message
+/*!
+Parameters of a kMsgDKeyRepeat message.
+*/
+class CMsgDKeyRepeat {
+public:
+	enum { kSize = 4 + 2 + 2 + 2 + 2 };
+
+	CMsgDKeyRepeat() :
+							m_id(0), m_mask(0), m_count(0), m_button(0) { }
+	CMsgDKeyRepeat(UInt16 id, UInt16 mask, UInt16 count, UInt16 button) :
+							m_id(id), m_mask(mask), m_count(count), m_button(button) { }
+
+	static const char*	getCode() { return kMsgDKeyRepeat; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); f(m.m_count); f(m.m_button); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+	UInt16				m_count;
+	UInt16				m_button;
+};
+
+//! Key auto-repeat message (protocol 1.0)
+/*!
+Parameters of a kMsgDKeyRepeat1_0 message.
+*/
+class CMsgDKeyRepeat1_0 {
+public:
+	enum { kSize = 4 + 2 + 2 + 2 };
+
+	CMsgDKeyRepeat1_0() :
+							m_id(0), m_mask(0), m_count(0) { }
+	CMsgDKeyRepeat1_0(UInt16 id, UInt16 mask, UInt16 count) :
+							m_id(id), m_mask(mask), m_count(count) { }
+
+	static const char*	getCode() { return kMsgDKeyRepeat1_0; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); f(m.m_count); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+	UInt16				m_count;
+};
+
+//! Key released message
+/*!
+Parameters of a kMsgDKeyUp message.
+*/
+class CMsgDKeyUp {
+public:
+	enum { kSize = 4 + 2 + 2 + 2 };
+
+	CMsgDKeyUp() :
+							m_id(0), m_mask(0), m_button(0) { }
+	CMsgDKeyUp(UInt16 id, UInt16 mask, UInt16 button) :
+							m_id(id), m_mask(mask), m_button(button) { }
+
+	static const char*	getCode() { return kMsgDKeyUp; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); f(m.m_button); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+	UInt16				m_button;
+};
+
+//! Key released message (protocol 1.0)
+/*!
+Parameters of a kMsgDKeyUp1_0 message.
+*/
+class CMsgDKeyUp1_0 {
+public:
+	enum { kSize = 4 + 2 + 2 };
+
+	CMsgDKeyUp1_0() :
+							m_id(0), m_mask(0) { }
+	CMsgDKeyUp1_0(UInt16 id, UInt16 mask) :
+							m_id(id), m_mask(mask) { }
+
+	static const char*	getCode() { return kMsgDKeyUp1_0; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); f(m.m_mask); }
+
+public:
+	UInt16				m_id;
+	UInt16				m_mask;
+};
+
+//! Mouse button pressed message
+/*!
+Parameters of a kMsgDMouseDown message.
+*/
+class CMsgDMouseDown {
+public:
+	enum { kSize = 4 + 1 };
+
+	CMsgDMouseDown() :
+							m_id(0) { }
+	CMsgDMouseDown(UInt8 id) :
+							m_id(id) { }
+
+	static const char*	getCode() { return kMsgDMouseDown; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); }
+
+public:
+	UInt8				m_id;
+};
+
+//! Mouse button released message
+/*!
+Parameters of a kMsgDMouseUp message.
+*/
+class CMsgDMouseUp {
+public:
+	enum { kSize = 4 + 1 };
+
+	CMsgDMouseUp() :
+							m_id(0) { }
+	CMsgDMouseUp(UInt8 id) :
+							m_id(id) { }
+
+	static const char*	getCode() { return kMsgDMouseUp; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_id); }
+
+public:
+	UInt8				m_id;
+};
+
+//! Mouse moved message
+/*!
+Parameters of a kMsgDMouseMove message.
+*/
+class CMsgDMouseMove {
+public:
+	enum { kSize = 4 + 4 + 4 };
+
+	CMsgDMouseMove() :
+							m_x(0), m_y(0) { }
+	CMsgDMouseMove(SInt32 x, SInt32 y) :
+							m_x(x), m_y(y) { }
+
+	static const char*	getCode() { return kMsgDMouseMove; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_x); f(m.m_y); }
+
+public:
+	SInt32				m_x;
+	SInt32				m_y;
+};
+
+//! Mouse moved message (protocol 1.3)
+/*!
+Parameters of a kMsgDMouseMove1_3 message.
+*/
+class CMsgDMouseMove1_3 {
+public:
+	enum { kSize = 4 + 2 + 2 };
+
+	CMsgDMouseMove1_3() :
+							m_x(0), m_y(0) { }
+	CMsgDMouseMove1_3(SInt16 x, SInt16 y) :
+							m_x(x), m_y(y) { }
+
+	static const char*	getCode() { return kMsgDMouseMove1_3; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_x); f(m.m_y); }
+
+public:
+	SInt16				m_x;
+	SInt16				m_y;
+};
+
+//! Relative mouse move message
+/*!
+Parameters of a kMsgDMouseRelMove message.
+*/
+class CMsgDMouseRelMove {
+public:
+	enum { kSize = 4 + 2 + 2 };
+
+	CMsgDMouseRelMove() :
+							m_dx(0), m_dy(0) { }
+	CMsgDMouseRelMove(SInt16 dx, SInt16 dy) :
+							m_dx(dx), m_dy(dy) { }
+
+	static const char*	getCode() { return kMsgDMouseRelMove; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_dx); f(m.m_dy); }
+
+public:
+	SInt16				m_dx;
+	SInt16				m_dy;
+};
+
+//! Batched relative mouse move message
+/*!
+Parameters of a kMsgDMouseRelMoveBatch message up to the samples.
+\c m_count is the number of 2 byte integers that follow, three per
+sample.
+*/
+class CMsgDMouseRelMoveBatch {
+public:
+	enum { kSize = 4 + 4 };
+
+	CMsgDMouseRelMoveBatch() :
+							m_count(0) { }
+	CMsgDMouseRelMoveBatch(UInt32 count) :
+							m_count(count) { }
+
+	static const char*	getCode() { return kMsgDMouseRelMoveBatch; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_count); }
+
+public:
+	UInt32				m_count;
+};
+
+//! Motion side channel sync message
+/*!
+Parameters of a kMsgDMotionSync message.
+*/
+class CMsgDMotionSync {
+public:
+	enum { kSize = 4 + 4 + 4 + 4 + 4 + 4 + 4 };
+
+	CMsgDMotionSync() :
+							m_seq(0), m_absSeq(0),
+							m_x(0), m_y(0), m_dx(0), m_dy(0) { }
+	CMsgDMotionSync(UInt32 seq, UInt32 absSeq,
+							SInt32 x, SInt32 y, SInt32 dx, SInt32 dy) :
+							m_seq(seq), m_absSeq(absSeq),
+							m_x(x), m_y(y), m_dx(dx), m_dy(dy) { }
+
+	static const char*	getCode() { return kMsgDMotionSync; }
+	template <class M, class F>
+	static void			fields(M& m, F& f)
+							{ f(m.m_seq); f(m.m_absSeq);
+							  f(m.m_x); f(m.m_y); f(m.m_dx); f(m.m_dy); }
+
+public:
+	UInt32				m_seq;
+	UInt32				m_absSeq;
+	SInt32				m_x, m_y;
+	SInt32				m_dx, m_dy;
+};
+
+//! Mouse scroll message
+/*!
+Parameters of a kMsgDMouseWheel message.
+*/
+class CMsgDMouseWheel {
+public:
+	enum { kSize = 4 + 2 + 2 };
+
+	CMsgDMouseWheel() :
+							m_xDelta(0), m_yDelta(0) { }
+	CMsgDMouseWheel(SInt16 xDelta, SInt16 yDelta) :
+							m_xDelta(xDelta), m_yDelta(yDelta) { }
+
+	static const char*	getCode() { return kMsgDMouseWheel; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_xDelta); f(m.m_yDelta); }
+
+public:
+	SInt16				m_xDelta;
+	SInt16				m_yDelta;
+};
+
+//! Mouse vertical scroll message (protocol 1.0)
+/*!
+Parameters of a kMsgDMouseWheel1_0 message.
+*/
+class CMsgDMouseWheel1_0 {
+public:
+	enum { kSize = 4 + 2 };
+
+	CMsgDMouseWheel1_0() :
+							m_yDelta(0) { }
+	CMsgDMouseWheel1_0(SInt16 yDelta) :
+							m_yDelta(yDelta) { }
+
+	static const char*	getCode() { return kMsgDMouseWheel1_0; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_yDelta); }
+
+public:
+	SInt16				m_yDelta;
+};
+
+//! Client data message
+/*!
+Parameters of a kMsgDInfo message.
+*/
+class CMsgDInfo {
+public:
+	enum { kSize = 4 + 4 + 4 + 4 + 4 + 2 + 4 + 4 };
+
+	CMsgDInfo() :
+							m_x(0), m_y(0), m_w(0), m_h(0), m_obsolete1(0), m_mx(0), m_my(0) { }
+	CMsgDInfo(SInt32 x, SInt32 y, SInt32 w, SInt32 h, SInt16 obsolete1, SInt32 mx, SInt32 my) :
+							m_x(x), m_y(y), m_w(w), m_h(h), m_obsolete1(obsolete1), m_mx(mx), m_my(my) { }
+
+	static const char*	getCode() { return kMsgDInfo; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_x); f(m.m_y); f(m.m_w); f(m.m_h); f(m.m_obsolete1); f(m.m_mx); f(m.m_my); }
+
+public:
+	SInt32				m_x;
+	SInt32				m_y;
+	SInt32				m_w;
+	SInt32				m_h;
+	SInt16				m_obsolete1;
+	SInt32				m_mx;
+	SInt32				m_my;
+};
+
+//! Client data message (protocol 1.3)
+/*!
+Parameters of a kMsgDInfo1_3 message.
+*/
+class CMsgDInfo1_3 {
+public:
+	enum { kSize = 4 + 2 + 2 + 2 + 2 + 2 + 2 + 2 };
+
+	CMsgDInfo1_3() :
+							m_x(0), m_y(0), m_w(0), m_h(0), m_obsolete1(0), m_mx(0), m_my(0) { }
+	CMsgDInfo1_3(SInt16 x, SInt16 y, SInt16 w, SInt16 h, SInt16 obsolete1, SInt16 mx, SInt16 my) :
+							m_x(x), m_y(y), m_w(w), m_h(h), m_obsolete1(obsolete1), m_mx(mx), m_my(my) { }
+
+	static const char*	getCode() { return kMsgDInfo1_3; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_x); f(m.m_y); f(m.m_w); f(m.m_h); f(m.m_obsolete1); f(m.m_mx); f(m.m_my); }
+
+public:
+	SInt16				m_x;
+	SInt16				m_y;
+	SInt16				m_w;
+	SInt16				m_h;
+	SInt16				m_obsolete1;
+	SInt16				m_mx;
+	SInt16				m_my;
+};
+
+//! Query screen info message
+/*!
+Parameters of a kMsgQInfo message.
+*/
+class CMsgQInfo {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgQInfo; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Incompatible versions message
+/*!
+Parameters of a kMsgEIncompatible message.
+*/
+class CMsgEIncompatible {
+public:
+	enum { kSize = 4 + 2 + 2 };
+
+	CMsgEIncompatible() :
+							m_major(0), m_minor(0) { }
+	CMsgEIncompatible(SInt16 major, SInt16 minor) :
+							m_major(major), m_minor(minor) { }
+
+	static const char*	getCode() { return kMsgEIncompatible; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_major); f(m.m_minor); }
+
+public:
+	SInt16				m_major;
+	SInt16				m_minor;
+};
+
+//! Name in use message
+/*!
+Parameters of a kMsgEBusy message.
+*/
+class CMsgEBusy {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgEBusy; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Unknown client message
+/*!
+Parameters of a kMsgEUnknown message.
+*/
+class CMsgEUnknown {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgEUnknown; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Protocol violation message
+/*!
+Parameters of a kMsgEBad message.
+*/
+class CMsgEBad {
+public:
+	enum { kSize = 4 };
+
+	static const char*	getCode() { return kMsgEBad; }
+	template <class M, class F>
+	static void			fields(M&, F&) { }
+};
+
+//! Motion side channel hello datagram
+/*!
+Parameters of a kMsgMotionHello datagram.
+*/
+class CMsgMotionHello {
+public:
+	enum { kSize = 4 + 4 };
+
+	CMsgMotionHello() :
+							m_token(0) { }
+	CMsgMotionHello(UInt32 token) :
+							m_token(token) { }
+
+	static const char*	getCode() { return kMsgMotionHello; }
+	template <class M, class F>
+	static void			fields(M& m, F& f) { f(m.m_token); }
+
+public:
+	UInt32				m_token;
+};
+
+//! Motion side channel update datagram
+/*!
+Parameters of a kMsgMotionUpdate datagram.
+*/
+class CMsgMotionUpdate {
+public:
+	enum { kSize = 4 + 4 + 4 + 4 + 4 + 4 + 4 + 4 };
+
+	CMsgMotionUpdate() :
+							m_token(0), m_seq(0), m_absSeq(0),
+							m_x(0), m_y(0), m_dx(0), m_dy(0) { }
+	CMsgMotionUpdate(UInt32 token, UInt32 seq, UInt32 absSeq,
+							SInt32 x, SInt32 y, SInt32 dx, SInt32 dy) :
+							m_token(token), m_seq(seq), m_absSeq(absSeq),
+							m_x(x), m_y(y), m_dx(dx), m_dy(dy) { }
+
+	static const char*	getCode() { return kMsgMotionUpdate; }
+	template <class M, class F>
+	static void			fields(M& m, F& f)
+							{ f(m.m_token); f(m.m_seq); f(m.m_absSeq);
+							  f(m.m_x); f(m.m_y); f(m.m_dx); f(m.m_dy); }
+
+public:
+	UInt32				m_token;
+	UInt32				m_seq;
+	UInt32				m_absSeq;
+	SInt32				m_x, m_y;
+	SInt32				m_dx, m_dy;
+};
+
 #endif
 